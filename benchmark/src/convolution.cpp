@@ -1,5 +1,6 @@
 #include "boofcv/image_convert.h"
 #include "boofcv/convolve.h"
+#include "boofcv/cpu_features.h"
 #include "benchmark_common.h"
 #include <time.h>
 
@@ -97,6 +98,67 @@ float benchmark_average( int N , uint32_t radius, const Gray<U8>&input , Benchma
     return 1000.0f*total/N;
 }
 
+/**
+ * Compares the inner convolution using a kernel width only known at run time against the unrolled version
+ * that has the width as a compile time constant
+ */
+class BenchmarkInner {
+public:
+    bool unrolled;
+    bool horizontal;
+
+    BenchmarkInner( bool unrolled , bool horizontal ) : unrolled(unrolled), horizontal(horizontal) {}
+
+    void process( const Kernel1D<S32>& kernel , const Gray<U8>& input, Gray<S16>& output ) {
+        if( horizontal ) {
+            if( unrolled )
+                ConvolveImage_Inner::horizontal_unrolled(kernel,input,output);
+            else
+                ConvolveImage_Inner::horizontal(kernel,input,output);
+        } else {
+            if( unrolled )
+                ConvolveImage_Inner::vertical_unrolled(kernel,input,output);
+            else
+                ConvolveImage_Inner::vertical(kernel,input,output);
+        }
+    }
+};
+
+float benchmark_inner( int N , uint32_t width, const Gray<U8>&input , BenchmarkInner& algorithm )
+{
+    Kernel1D<S32> kernel = FactoryKernel::gaussian1D<S32>(-1.0,width);
+    Gray<S16> output( input.width, input.height);
+
+    float total = 0;
+    for( int i = 0; i < N; i++ ) {
+        clock_t t = clock();
+        algorithm.process(kernel,input,output);
+        total += (float)(clock() - t)/CLOCKS_PER_SEC;
+    }
+
+    return 1000.0f*total/N;
+}
+
+void benchmark_unrolled( int N , const Gray<U8>&input ) {
+    bool simd = CpuFeatures::isSimdEnabled();
+    CpuFeatures::setSimdEnabled(false);
+
+    for( int i = 0; i < 2; i++ ) {
+        BenchmarkInner generic(false,i==0);
+        BenchmarkInner unrolled(true,i==0);
+        const char* name = i==0 ? "horizontal" : "vertical";
+
+        for( uint32_t width = 3; width <= 13; width += 2 ) {
+            float time_generic = benchmark_inner(N,width,input,generic);
+            float time_unrolled = benchmark_inner(N,width,input,unrolled);
+            printf("%20s width=%2d generic = %f unrolled = %f (ms) speedup = %.2f\n",name,width,
+                   time_generic,time_unrolled,time_generic/time_unrolled);
+        }
+    }
+
+    CpuFeatures::setSimdEnabled(simd);
+}
+
 
 int main() {
     Interleaved<U8> input_color(1,1,1);
@@ -124,4 +186,7 @@ int main() {
     printf("%20s radius=%2d time = %f (ms)\n","convolve ",radius,
            benchmark_average(N,radius,gray,convolve));
 
+    printf("\nInner convolution with SIMD turned off\n");
+    benchmark_unrolled(N,gray);
+
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 #include "boofcv/image_convert.h"
 #include "boofcv/threshold_block_filters.h"
 #include "benchmark_common.h"
-#include <time.h>
+#include <chrono>
 
 using namespace std;
 using namespace boofcv;
@@ -11,13 +11,12 @@ float benchmark( const Gray<U8>&input , InputToBinary<Gray<U8>>& algorithm )
 {
     Gray<U8> output( input.width, input.height);
 
-    clock_t t;
-
-    t = clock();
+    // wall time instead of clock() since clock() adds up the time from all threads
+    auto t0 = std::chrono::steady_clock::now();
     algorithm.process(input,output);
-    t = clock() - t;
+    auto t1 = std::chrono::steady_clock::now();
 
-    return (float)t/CLOCKS_PER_SEC;
+    return std::chrono::duration<float>(t1-t0).count();
 }
 
 float benchmark_average( int N , const Gray<U8>&input , InputToBinary<Gray<U8>>& algorithm )
@@ -52,6 +51,7 @@ int main() {
     GlobalFixedBinaryFilter<U8> global_fixed(125,down);
     GlobalOtsuBinaryFilter<U8> global_otsu(0,255,down);
     LocalMeanBinaryFilter<U8> local_mean(regionWidth,scale,down);
+    LocalMeanBinaryFilter<U8> local_mean_integral(regionWidth,scale,down,true);
     ThresholdBlockMinMax<U8> block_min_max(1,regionWidth,local_blocks,scale,down);
     ThresholdBlockMean<U8> block_mean(regionWidth,local_blocks,scale,down);
     ThresholdBlockOtsu<U8> block_otsu(true,regionWidth,0,scale,down,local_blocks);
@@ -59,6 +59,18 @@ int main() {
     printf("%20s time = %f (ms)\n","global_fixed",benchmark_average(N,gray,global_fixed));
     printf("%20s time = %f (ms)\n","global_otsu",benchmark_average(N,gray,global_otsu));
     printf("%20s time = %f (ms)\n","local_mean",benchmark_average(N,gray,local_mean));
+    printf("%20s time = %f (ms)\n","local_mean_integral",benchmark_average(N,gray,local_mean_integral));
+    printf("%20s time = %f (ms)\n","block_min_max",benchmark_average(N,gray,block_min_max));
+    printf("%20s time = %f (ms)\n","block_mean",benchmark_average(N,gray,block_mean));
+    printf("%20s time = %f (ms)\n","block_otsu",benchmark_average(N,gray,block_otsu));
+
+    ThreadPool pool;
+    ConcurrencyContext context(pool);
+    block_min_max.concurrency = context;
+    block_mean.concurrency = context;
+    block_otsu.concurrency = context;
+
+    printf("\nBlock thresholding with %d threads\n",pool.size());
     printf("%20s time = %f (ms)\n","block_min_max",benchmark_average(N,gray,block_min_max));
     printf("%20s time = %f (ms)\n","block_mean",benchmark_average(N,gray,block_mean));
     printf("%20s time = %f (ms)\n","block_otsu",benchmark_average(N,gray,block_otsu));
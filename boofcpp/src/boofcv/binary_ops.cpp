@@ -1,16 +1,170 @@
 #include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "binary_ops.h"
+#include "cpu_features.h"
 #include "sanity_checks.h"
 
+#if BOOFCPP_SIMD_AVX2
+#include <immintrin.h>
+#define BOOFCPP_SIMD_TARGET __attribute__((target("avx2")))
+#endif
+
 using namespace boofcv;
 
+namespace {
+    template<bool erode>
+    inline U8 morph_op( U8 a , U8 b ) {
+        return erode ? std::min(a,b) : std::max(a,b);
+    }
+
+    /**
+     * Running minimum (erode) or maximum (dilate) along each row using van Herk/Gil-Werman. The row is padded by
+     * 'radius' on each side with a value which doesn't change the result and split into blocks the size of the
+     * window. A window always spans the end of one block and the start of the next, so its value is the suffix
+     * of the first block combined with the prefix of the second.
+     */
+    template<bool erode>
+    void running_horizontal( const Gray<U8>& input , uint32_t radius , Gray<U8>& output , uint32_t y0 , uint32_t y1 ) {
+        const U8 neutral = erode ? 0xFF : 0;
+        const uint32_t n = input.width;
+        const uint32_t k = 2*radius+1;
+        const uint32_t length = ((n + 2*radius + k - 1)/k)*k;
+
+        std::vector<U8> prefix(length), suffix(length);
+
+        for( uint32_t y = y0; y < y1; y++ ) {
+            const U8* in = &input.data[input.offset + y*input.stride];
+            U8* out = &output.data[output.offset + y*output.stride];
+
+            for( uint32_t i = 0; i < length; i++ ) {
+                U8 value = i >= radius && i - radius < n ? in[i-radius] : neutral;
+                prefix[i] = i % k == 0 ? value : morph_op<erode>(prefix[i-1],value);
+            }
+            for( uint32_t i = length; i-- > 0; ) {
+                U8 value = i >= radius && i - radius < n ? in[i-radius] : neutral;
+                suffix[i] = i % k == k-1 ? value : morph_op<erode>(suffix[i+1],value);
+            }
+            for( uint32_t x = 0; x < n; x++ ) {
+                out[x] = morph_op<erode>(suffix[x],prefix[x+k-1]);
+            }
+        }
+    }
+
+    /**
+     * Same as running_horizontal but along columns. Whole rows are combined at once so the inner loops run along
+     * contiguous memory. Only the suffix of the current block and the prefix of the next block are stored.
+     */
+    template<bool erode>
+    void running_vertical( const Gray<U8>& input , uint32_t radius , Gray<U8>& output , uint32_t y0 , uint32_t y1 ) {
+        const uint32_t w = input.width;
+        const uint32_t n = input.height;
+        const uint32_t k = 2*radius+1;
+
+        std::vector<U8> neutral(w, erode ? 0xFF : 0);
+        std::vector<U8> prefix(k*w), suffix(k*w);
+
+        // row 'i' in the padded image
+        auto row = [&]( uint32_t i ) -> const U8* {
+            if( i >= radius && i - radius < n )
+                return &input.data[input.offset + (i-radius)*input.stride];
+            return neutral.data();
+        };
+
+        for( uint32_t block = y0/k; block*k < y1; block++ ) {
+            const uint32_t base = block*k;
+
+            std::memcpy(&suffix[(k-1)*w],row(base+k-1),w);
+            for( uint32_t j = k-1; j-- > 0; ) {
+                const U8* in = row(base+j);
+                const U8* next = &suffix[(j+1)*w];
+                U8* dst = &suffix[j*w];
+                for( uint32_t x = 0; x < w; x++ ) {
+                    dst[x] = morph_op<erode>(next[x],in[x]);
+                }
+            }
+
+            if( k > 1 )
+                std::memcpy(&prefix[0],row(base+k),w);
+            for( uint32_t j = 1; j + 1 < k; j++ ) {
+                const U8* in = row(base+k+j);
+                const U8* previous = &prefix[(j-1)*w];
+                U8* dst = &prefix[j*w];
+                for( uint32_t x = 0; x < w; x++ ) {
+                    dst[x] = morph_op<erode>(previous[x],in[x]);
+                }
+            }
+
+            for( uint32_t j = 0; j < k; j++ ) {
+                uint32_t y = base + j;
+                if( y < y0 || y >= y1 )
+                    continue;
+                U8* out = &output.data[output.offset + y*output.stride];
+                const U8* a = &suffix[j*w];
+                if( j == 0 ) {
+                    // the window is exactly this block
+                    std::memcpy(out,a,w);
+                } else {
+                    const U8* b = &prefix[(j-1)*w];
+                    for( uint32_t x = 0; x < w; x++ ) {
+                        out[x] = morph_op<erode>(a[x],b[x]);
+                    }
+                }
+            }
+        }
+    }
+
+    template<bool erode>
+    void morph_rect( const Gray<U8>& input , uint32_t radiusX , uint32_t radiusY , Gray<U8>& output ,
+                     Gray<U8>& storage , const ConcurrencyContext* context ) {
+        if( &storage == &input || &storage == &output )
+            throw invalid_argument("storage can't be the input or output");
+        storage.reshape(input.width,input.height);
+
+        auto horizontal = [&](uint32_t y0, uint32_t y1) {
+            running_horizontal<erode>(input,radiusX,storage,y0,y1);
+        };
+        if( context )
+            concurrent_rows(*context,input.height,horizontal);
+        else
+            horizontal(0,input.height);
+
+        // output is only written after the input has been read, so they can be the same image
+        output.reshape(input.width,input.height);
+        auto vertical = [&](uint32_t y0, uint32_t y1) {
+            running_vertical<erode>(storage,radiusY,output,y0,y1);
+        };
+        if( context )
+            concurrent_rows(*context,input.height,vertical);
+        else
+            vertical(0,input.height);
+    }
+}
+
 void boofcv::BinaryImageOps::logicAnd(const Gray<U8>& inputA , const Gray<U8>& inputB , Gray<U8>& output )
 {
     checkSameShape(inputA, inputB);
     output.reshape(inputA.width,inputA.height);
 
-    for( uint32_t y = 0; y < inputA.height; y++ ) {
+    logicAnd(inputA,inputB,output,0,inputA.height);
+}
+
+void boofcv::BinaryImageOps::logicAnd(const Gray<U8>& inputA , const Gray<U8>& inputB , Gray<U8>& output ,
+                                      const ConcurrencyContext& context )
+{
+    checkSameShape(inputA, inputB);
+    output.reshape(inputA.width,inputA.height);
+
+    concurrent_rows(context,inputA.height,[&](uint32_t y0, uint32_t y1){
+        logicAnd(inputA,inputB,output,y0,y1);
+    });
+}
+
+void boofcv::BinaryImageOps::logicAnd(const Gray<U8>& inputA , const Gray<U8>& inputB , Gray<U8>& output ,
+                                      uint32_t y0, uint32_t y1 )
+{
+    for( uint32_t y = y0; y < y1; y++ ) {
         uint32_t indexA = inputA.offset + y*inputA.stride;
         uint32_t indexB = inputB.offset + y*inputB.stride;
         uint32_t indexOut = output.offset + y*output.stride;
@@ -27,7 +181,24 @@ void boofcv::BinaryImageOps::logicOr(const Gray<U8>& inputA , const Gray<U8>& in
     checkSameShape(inputA, inputB);
     output.reshape(inputA.width,inputA.height);
 
-    for( uint32_t y = 0; y < inputA.height; y++ ) {
+    logicOr(inputA,inputB,output,0,inputA.height);
+}
+
+void boofcv::BinaryImageOps::logicOr(const Gray<U8>& inputA , const Gray<U8>& inputB , Gray<U8>& output ,
+                                     const ConcurrencyContext& context )
+{
+    checkSameShape(inputA, inputB);
+    output.reshape(inputA.width,inputA.height);
+
+    concurrent_rows(context,inputA.height,[&](uint32_t y0, uint32_t y1){
+        logicOr(inputA,inputB,output,y0,y1);
+    });
+}
+
+void boofcv::BinaryImageOps::logicOr(const Gray<U8>& inputA , const Gray<U8>& inputB , Gray<U8>& output ,
+                                     uint32_t y0, uint32_t y1 )
+{
+    for( uint32_t y = y0; y < y1; y++ ) {
         uint32_t indexA = inputA.offset + y*inputA.stride;
         uint32_t indexB = inputB.offset + y*inputB.stride;
         uint32_t indexOut = output.offset + y*output.stride;
@@ -42,10 +213,25 @@ void boofcv::BinaryImageOps::logicOr(const Gray<U8>& inputA , const Gray<U8>& in
 void boofcv::BinaryImageOps::erode4(const Gray<U8>& input, Gray<U8>& output) {
     output.reshape(input.width,input.height);
 
+    erode4(input,output,0,input.height);
+}
+
+void boofcv::BinaryImageOps::erode4(const Gray<U8>& input, Gray<U8>& output, const ConcurrencyContext& context) {
+    output.reshape(input.width,input.height);
+
+    concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+        erode4(input,output,y0,y1);
+    });
+}
+
+void boofcv::BinaryImageOps::erode4(const Gray<U8>& input, Gray<U8>& output, uint32_t y0, uint32_t y1) {
     const int h = input.height - 1;
     const int w = input.width - 2;
 
-    for (uint32_t y = 1; y < h; y++) {
+    y0 = std::max(y0,1U);
+    y1 = std::min(y1,(uint32_t)std::max(h,0));
+
+    for (uint32_t y = y0; y < y1; y++) {
         uint32_t indexIn = input.offset + y * input.stride + 1;
         uint32_t indexOut = output.offset + y * output.stride + 1;
 
@@ -64,10 +250,25 @@ void boofcv::BinaryImageOps::erode4(const Gray<U8>& input, Gray<U8>& output) {
 void boofcv::BinaryImageOps::dilate4(const Gray<U8>& input, Gray<U8>& output) {
     output.reshape(input.width,input.height);
 
+    dilate4(input,output,0,input.height);
+}
+
+void boofcv::BinaryImageOps::dilate4(const Gray<U8>& input, Gray<U8>& output, const ConcurrencyContext& context) {
+    output.reshape(input.width,input.height);
+
+    concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+        dilate4(input,output,y0,y1);
+    });
+}
+
+void boofcv::BinaryImageOps::dilate4(const Gray<U8>& input, Gray<U8>& output, uint32_t y0, uint32_t y1) {
     const int h = input.height - 1;
     const int w = input.width - 2;
 
-    for (uint32_t y = 1; y < h; y++) {
+    y0 = std::max(y0,1U);
+    y1 = std::min(y1,(uint32_t)std::max(h,0));
+
+    for (uint32_t y = y0; y < y1; y++) {
         uint32_t indexIn = input.offset + y * input.stride + 1;
         uint32_t indexOut = output.offset + y * output.stride + 1;
 
@@ -84,6 +285,195 @@ void boofcv::BinaryImageOps::dilate4(const Gray<U8>& input, Gray<U8>& output) {
     }
 }
 
+void boofcv::BinaryImageOps::erode8(const Gray<U8>& input, Gray<U8>& output) {
+    erodeRect(input,1,1,output);
+}
+
+void boofcv::BinaryImageOps::dilate8(const Gray<U8>& input, Gray<U8>& output) {
+    dilateRect(input,1,1,output);
+}
+
+void boofcv::BinaryImageOps::erode8(const Gray<U8>& input, Gray<U8>& output, const ConcurrencyContext& context) {
+    Gray<U8> storage;
+    erodeRect(input,1,1,output,storage,context);
+}
+
+void boofcv::BinaryImageOps::dilate8(const Gray<U8>& input, Gray<U8>& output, const ConcurrencyContext& context) {
+    Gray<U8> storage;
+    dilateRect(input,1,1,output,storage,context);
+}
+
+void boofcv::BinaryImageOps::erodeRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output,
+                                       Gray<U8>& storage) {
+    morph_rect<true>(input,radiusX,radiusY,output,storage,nullptr);
+}
+
+void boofcv::BinaryImageOps::dilateRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output,
+                                        Gray<U8>& storage) {
+    morph_rect<false>(input,radiusX,radiusY,output,storage,nullptr);
+}
+
+void boofcv::BinaryImageOps::erodeRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output) {
+    Gray<U8> storage;
+    morph_rect<true>(input,radiusX,radiusY,output,storage,nullptr);
+}
+
+void boofcv::BinaryImageOps::dilateRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output) {
+    Gray<U8> storage;
+    morph_rect<false>(input,radiusX,radiusY,output,storage,nullptr);
+}
+
+void boofcv::BinaryImageOps::erodeRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output,
+                                       Gray<U8>& storage, const ConcurrencyContext& context) {
+    morph_rect<true>(input,radiusX,radiusY,output,storage,&context);
+}
+
+void boofcv::BinaryImageOps::dilateRect(const Gray<U8>& input, uint32_t radiusX, uint32_t radiusY, Gray<U8>& output,
+                                        Gray<U8>& storage, const ConcurrencyContext& context) {
+    morph_rect<false>(input,radiusX,radiusY,output,storage,&context);
+}
+
+#if BOOFCPP_SIMD_AVX2
+namespace {
+    /**
+     * Thresholds 32 then 16 pixels at a time. input <= threshold is found with min(input,threshold) == input
+     * since there's no unsigned byte comparison.
+     *
+     * @return Number of pixels processed
+     */
+    BOOFCPP_SIMD_TARGET uint32_t threshold_row_avx2( const U8* input , U8 threshold , bool down ,
+                                                     U8* output , uint32_t length ) {
+        const __m256i t = _mm256_set1_epi8(static_cast<char>(threshold));
+        const __m256i one = _mm256_set1_epi8(1);
+        const __m256i flip = down ? _mm256_setzero_si256() : one;
+
+        uint32_t i = 0;
+        for( ; i + 32 <= length; i += 32 ) {
+            __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&input[i]));
+            __m256i below = _mm256_cmpeq_epi8(_mm256_min_epu8(p,t),p);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&output[i]),
+                                _mm256_xor_si256(_mm256_and_si256(below,one),flip));
+        }
+        // blocks are often narrower than 32 pixels
+        if( i + 16 <= length ) {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input[i]));
+            __m128i below = _mm_cmpeq_epi8(_mm_min_epu8(p,_mm256_castsi256_si128(t)),p);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]),
+                             _mm_xor_si128(_mm_and_si128(below,_mm256_castsi256_si128(one)),
+                                           _mm256_castsi256_si128(flip)));
+            i += 16;
+        }
+        return i;
+    }
+
+    /**
+     * Packs the results of comparing 16 floats into 16 bytes which are 0 or 1
+     */
+    BOOFCPP_SIMD_TARGET inline __m128i pack_masks( __m256 a , __m256 b ) {
+        __m256i ia = _mm256_castps_si256(a), ib = _mm256_castps_si256(b);
+        __m128i wordsA = _mm_packs_epi32(_mm256_castsi256_si128(ia),_mm256_extracti128_si256(ia,1));
+        __m128i wordsB = _mm_packs_epi32(_mm256_castsi256_si128(ib),_mm256_extracti128_si256(ib,1));
+        return _mm_and_si128(_mm_packs_epi16(wordsA,wordsB),_mm_set1_epi8(1));
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t threshold_row_avx2( const F32* input , F32 threshold , bool down ,
+                                                     U8* output , uint32_t length ) {
+        const __m256 t = _mm256_set1_ps(threshold);
+        const __m128i flip = down ? _mm_setzero_si128() : _mm_set1_epi8(1);
+
+        uint32_t i = 0;
+        for( ; i + 16 <= length; i += 16 ) {
+            // ordered comparison so NaN is never below the threshold, same as the scalar code
+            __m256 belowA = _mm256_cmp_ps(_mm256_loadu_ps(&input[i]),t,_CMP_LE_OQ);
+            __m256 belowB = _mm256_cmp_ps(_mm256_loadu_ps(&input[i+8]),t,_CMP_LE_OQ);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]),_mm_xor_si128(pack_masks(belowA,belowB),flip));
+        }
+        if( i + 8 <= length ) {
+            __m256 below = _mm256_cmp_ps(_mm256_loadu_ps(&input[i]),t,_CMP_LE_OQ);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&output[i]),
+                             _mm_xor_si128(pack_masks(below,_mm256_setzero_ps()),flip));
+            i += 8;
+        }
+        return i;
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t threshold_row_pixels_avx2( const U8* input , const F32* thresholds , bool down ,
+                                                            U8* output , uint32_t length ) {
+        const __m128i flip = down ? _mm_setzero_si128() : _mm_set1_epi8(1);
+
+        uint32_t i = 0;
+        for( ; i + 16 <= length; i += 16 ) {
+            __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input[i]));
+            __m256 lower = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(p));
+            __m256 upper = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(p,8)));
+            __m256 belowA = _mm256_cmp_ps(lower,_mm256_loadu_ps(&thresholds[i]),_CMP_LE_OQ);
+            __m256 belowB = _mm256_cmp_ps(upper,_mm256_loadu_ps(&thresholds[i+8]),_CMP_LE_OQ);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]),_mm_xor_si128(pack_masks(belowA,belowB),flip));
+        }
+        return i;
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t threshold_row_pixels_avx2( const F32* input , const F32* thresholds , bool down ,
+                                                            U8* output , uint32_t length ) {
+        const __m128i flip = down ? _mm_setzero_si128() : _mm_set1_epi8(1);
+
+        uint32_t i = 0;
+        for( ; i + 16 <= length; i += 16 ) {
+            __m256 belowA = _mm256_cmp_ps(_mm256_loadu_ps(&input[i]),_mm256_loadu_ps(&thresholds[i]),_CMP_LE_OQ);
+            __m256 belowB = _mm256_cmp_ps(_mm256_loadu_ps(&input[i+8]),_mm256_loadu_ps(&thresholds[i+8]),_CMP_LE_OQ);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]),_mm_xor_si128(pack_masks(belowA,belowB),flip));
+        }
+        return i;
+    }
+}
+#endif
+
+void boofcv::ThresholdOps::thresholdRow( const U8* input , U8 threshold , bool down , U8* output , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = threshold_row_avx2(input,threshold,down,output,length);
+#endif
+    for( ; i < length; i++ ) {
+        output[i] = static_cast<U8>( down == (input[i] <= threshold) );
+    }
+}
+
+void boofcv::ThresholdOps::thresholdRow( const F32* input , F32 threshold , bool down , U8* output , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = threshold_row_avx2(input,threshold,down,output,length);
+#endif
+    for( ; i < length; i++ ) {
+        output[i] = static_cast<U8>( down == (input[i] <= threshold) );
+    }
+}
+
+void boofcv::ThresholdOps::thresholdRowPixels( const U8* input , const F32* thresholds , bool down , U8* output ,
+                                               uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = threshold_row_pixels_avx2(input,thresholds,down,output,length);
+#endif
+    for( ; i < length; i++ ) {
+        output[i] = static_cast<U8>( down == (input[i] <= thresholds[i]) );
+    }
+}
+
+void boofcv::ThresholdOps::thresholdRowPixels( const F32* input , const F32* thresholds , bool down , U8* output ,
+                                               uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = threshold_row_pixels_avx2(input,thresholds,down,output,length);
+#endif
+    for( ; i < length; i++ ) {
+        output[i] = static_cast<U8>( down == (input[i] <= thresholds[i]) );
+    }
+}
+
 boofcv::ComputeOtsu::ComputeOtsu(bool useOtsu2, double tuning, bool down, double scale) {
     this->useOtsu2 = useOtsu2;
     this->tuning = tuning;
@@ -94,13 +484,189 @@ boofcv::ComputeOtsu::ComputeOtsu(bool useOtsu2, double tuning, bool down, double
 boofcv::ComputeOtsu::ComputeOtsu( bool useOtsu2 , bool down ) : ComputeOtsu(useOtsu2,0,down,1.0) {
 }
 
+#if BOOFCPP_SIMD_AVX2
+namespace {
+    BOOFCPP_SIMD_TARGET uint32_t histogram_add_avx2( uint32_t* dst , const uint32_t* src , uint32_t length ) {
+        uint32_t i = 0;
+        for( ; i + 8 <= length; i += 8 ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&dst[i]));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i]), _mm256_add_epi32(a,b));
+        }
+        return i;
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t histogram_subtract_avx2( uint32_t* dst , const uint32_t* src , uint32_t length ) {
+        uint32_t i = 0;
+        for( ; i + 8 <= length; i += 8 ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&dst[i]));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i]), _mm256_sub_epi32(a,b));
+        }
+        return i;
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t histogram_add_avx2( uint32_t* dst , const uint16_t* src , uint32_t length ) {
+        uint32_t i = 0;
+        for( ; i + 8 <= length; i += 8 ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&dst[i]));
+            __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i]), _mm256_add_epi32(a,b));
+        }
+        return i;
+    }
+
+    BOOFCPP_SIMD_TARGET uint32_t histogram_subtract_avx2( uint32_t* dst , const uint16_t* src , uint32_t length ) {
+        uint32_t i = 0;
+        for( ; i + 8 <= length; i += 8 ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&dst[i]));
+            __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dst[i]), _mm256_sub_epi32(a,b));
+        }
+        return i;
+    }
+}
+#endif
+
+void boofcv::HistogramOps::add( uint32_t* dst , const uint32_t* src , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = histogram_add_avx2(dst,src,length);
+#endif
+    for( ; i < length; i++ ) {
+        dst[i] += src[i];
+    }
+}
+
+void boofcv::HistogramOps::subtract( uint32_t* dst , const uint32_t* src , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = histogram_subtract_avx2(dst,src,length);
+#endif
+    for( ; i < length; i++ ) {
+        dst[i] -= src[i];
+    }
+}
+
+void boofcv::HistogramOps::add( uint32_t* dst , const uint16_t* src , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = histogram_add_avx2(dst,src,length);
+#endif
+    for( ; i < length; i++ ) {
+        dst[i] += src[i];
+    }
+}
+
+void boofcv::HistogramOps::subtract( uint32_t* dst , const uint16_t* src , uint32_t length ) {
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = histogram_subtract_avx2(dst,src,length);
+#endif
+    for( ; i < length; i++ ) {
+        dst[i] -= src[i];
+    }
+}
+
+uint32_t boofcv::HistogramOps::sum( const uint32_t* src , uint32_t length ) {
+    uint32_t total = 0;
+    for( uint32_t i = 0; i < length; i++ ) {
+        total += src[i];
+    }
+    return total;
+}
+
+#if BOOFCPP_SIMD_AVX2
+namespace {
+    /**
+     * Evaluates the between class variance for four bins at a time. Each lane keeps the first bin with its largest
+     * variance, then the lanes are merged into 'best' and 'bestIndex'. The variance is computed with the same
+     * operations in the same order as the scalar code, so the values are identical.
+     *
+     * @return Number of bins processed
+     */
+    BOOFCPP_SIMD_TARGET uint32_t otsu_search_avx2( const double* count , const double* moment , uint32_t length ,
+                                                   double total , double sum , double& best , uint32_t& bestIndex ) {
+        const __m256d vtotal = _mm256_set1_pd(total);
+        const __m256d vsum = _mm256_set1_pd(sum);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d four = _mm256_set1_pd(4.0);
+
+        __m256d vbest = zero;
+        __m256d vbestIndex = zero;
+        __m256d index = _mm256_set_pd(3.0,2.0,1.0,0.0);
+
+        uint32_t i = 0;
+        for( ; i + 4 <= length; i += 4 ) {
+            __m256d wB = _mm256_loadu_pd(&count[i]);
+            __m256d sumB = _mm256_loadu_pd(&moment[i]);
+            __m256d wF = _mm256_sub_pd(vtotal,wB);
+
+            __m256d emptyF = _mm256_cmp_pd(wF,zero,_CMP_EQ_OQ);
+            // every pixel is in the background from here on
+            if( _mm256_movemask_pd(emptyF) == 0xF )
+                break;
+
+            __m256d mB = _mm256_div_pd(sumB,wB);
+            __m256d mF = _mm256_div_pd(_mm256_sub_pd(vsum,sumB),wF);
+            __m256d diff = _mm256_sub_pd(mB,mF);
+            __m256d varBetween = _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(wB,wF),diff),diff);
+
+            __m256d empty = _mm256_or_pd(emptyF,_mm256_cmp_pd(wB,zero,_CMP_EQ_OQ));
+            __m256d better = _mm256_andnot_pd(empty,_mm256_cmp_pd(varBetween,vbest,_CMP_GT_OQ));
+            vbest = _mm256_blendv_pd(vbest,varBetween,better);
+            vbestIndex = _mm256_blendv_pd(vbestIndex,index,better);
+            index = _mm256_add_pd(index,four);
+        }
+
+        double lanes[4], lanesIndex[4];
+        _mm256_storeu_pd(lanes,vbest);
+        _mm256_storeu_pd(lanesIndex,vbestIndex);
+        for( int lane = 0; lane < 4; lane++ ) {
+            auto laneIndex = static_cast<uint32_t>(lanesIndex[lane]);
+            if( lanes[lane] > best || (lanes[lane] > 0 && lanes[lane] == best && laneIndex < bestIndex) ) {
+                best = lanes[lane];
+                bestIndex = laneIndex;
+            }
+        }
+        return i;
+    }
+}
+#endif
+
 void boofcv::ComputeOtsu::compute(const GrowArray<uint32_t>&histogram , uint32_t totalPixels) {
+    compute(histogram.data,histogram.size,totalPixels);
+}
+
+void boofcv::ComputeOtsu::compute(const uint32_t* histogram , uint32_t length , uint32_t totalPixels) {
+    computePrefixSums(histogram,length);
     if( useOtsu2 ) {
-        computeOtsu2(histogram,totalPixels);
+        computeOtsu2(length,totalPixels);
     } else {
-        computeOtsu(histogram,totalPixels);
+        computeOtsu(length,totalPixels);
     }
+    adjustThreshold();
+}
+
+void boofcv::ComputeOtsu::computeBatch(const uint32_t* histograms , uint32_t length , uint32_t count ,
+                                       double* thresholds ) {
+    for (uint32_t k = 0; k < count; k++) {
+        uint32_t totalPixels = computePrefixSums(&histograms[k*length],length);
+        if( useOtsu2 ) {
+            computeOtsu2(length,totalPixels);
+        } else {
+            computeOtsu(length,totalPixels);
+        }
+        adjustThreshold();
+        thresholds[k] = threshold;
+    }
+}
 
+void boofcv::ComputeOtsu::adjustThreshold() {
     // apply optional penalty to low texture regions
     variance += 0.001; // avoid divide by zero
     // multiply by threshold twice in an effort to have the image's scaling not effect the tuning parameter
@@ -109,85 +675,105 @@ void boofcv::ComputeOtsu::compute(const GrowArray<uint32_t>&histogram , uint32_t
     threshold = (int)(scale*std::max(threshold,0.0)+0.5);
 }
 
-void boofcv::ComputeOtsu::computeOtsu(const GrowArray<uint32_t>& histogram , uint32_t totalPixels ) {
-    double dlength = histogram.size;
-    double sum = 0;
-    for (uint32_t i = 0; i < histogram.size; i++)
-        sum += (i / dlength) * histogram[i];
-
-    double sumB = 0;
-    uint32_t wB = 0;
+uint32_t boofcv::ComputeOtsu::computePrefixSums(const uint32_t* histogram , uint32_t length ) {
+    if( length <= INLINE_BINS ) {
+        prefixCount = inlineCount;
+        prefixMoment = inlineMoment;
+    } else {
+        heapCount.resize(length);
+        heapMoment.resize(length);
+        prefixCount = heapCount.data();
+        prefixMoment = heapMoment.data();
+    }
 
-    variance = 0;
-    threshold = 0;
+    uint32_t total = 0;
+    if( (length & (length-1)) == 0 ) {
+        // i/length is exact when the length is a power of two, so is the floating point sum of (i/length)*count.
+        // Summing the first moment as an integer and scaling it at the end produces the same values
+        const double inv = 1.0/length;
+        uint64_t moment = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            total += histogram[i];
+            moment += static_cast<uint64_t>(i)*histogram[i];
+            prefixCount[i] = total;
+            prefixMoment[i] = static_cast<double>(moment)*inv;
+        }
+    } else {
+        // rounding depends on the order of the sum so it's accumulated the same way as the standard formulation
+        double dlength = length;
+        double sumB = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            total += histogram[i];
+            sumB += (i / dlength) * histogram[i];
+            prefixCount[i] = total;
+            prefixMoment[i] = sumB;
+        }
+    }
+    return total;
+}
 
-    uint32_t i;
-    for (i = 0; i < histogram.size; i++) {
-        wB += histogram[i];               // Weight Background
+bool boofcv::ComputeOtsu::searchVariance(uint32_t length , uint32_t totalPixels ,
+                                         uint32_t& selected , double& bestVariance ) {
+    const double total = totalPixels;
+    const double sum = length > 0 ? prefixMoment[length-1] : 0.0;
+
+    bestVariance = 0;
+    selected = 0;
+
+    uint32_t i = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() )
+        i = otsu_search_avx2(prefixCount,prefixMoment,length,total,sum,bestVariance,selected);
+#endif
+    for (; i < length; i++) {
+        double wB = prefixCount[i];       // Weight Background
         if (wB == 0) continue;
 
-        uint32_t wF = totalPixels - wB;        // Weight Foreground
+        double wF = total - wB;           // Weight Foreground
         if (wF == 0) break;
 
-        double f = i / dlength;
-        sumB += f * histogram[i];
-
+        double sumB = prefixMoment[i];
         double mB = sumB / wB;            // Mean Background
         double mF = (sum - sumB) / wF;    // Mean Foreground
 
         // Calculate Between Class Variance
-        double varBetween = (double) wB * (double) wF * (mB - mF) * (mB - mF);
+        double varBetween = wB * wF * (mB - mF) * (mB - mF);
 
         // Check if new maximum found
-        if (varBetween > variance) {
-            variance = varBetween;
-            threshold = i;
+        if (varBetween > bestVariance) {
+            bestVariance = varBetween;
+            selected = i;
         }
     }
+    return bestVariance > 0;
 }
 
-void boofcv::ComputeOtsu::computeOtsu2(const GrowArray<uint32_t>&histogram , uint32_t totalPixels ) {
-    double dlength = histogram.size;
-    double sum = 0;
-    for (int i = 0; i < histogram.size; i++)
-        sum += (i / dlength) * histogram[i];
-
-    double sumB = 0;
-    uint32_t wB = 0;
-
-    variance = 0;
-    threshold = 0;
+void boofcv::ComputeOtsu::computeOtsu(uint32_t length , uint32_t totalPixels ) {
+    uint32_t selected;
+    searchVariance(length,totalPixels,selected,variance);
+    threshold = selected;
+    // every value inside the selected bin is at or below the threshold
+    if( binWidth > 1 )
+        threshold = (selected+1.0)*binWidth - 1;
+}
 
+void boofcv::ComputeOtsu::computeOtsu2(uint32_t length , uint32_t totalPixels ) {
+    uint32_t selected;
     double selectedMB=0;
     double selectedMF=0;
 
-    uint32_t i;
-    for (i = 0; i < histogram.size; i++) {
-        wB += histogram[i];               // Weight Background
-        if (wB == 0) continue;
-
-        uint32_t wF = totalPixels - wB;        // Weight Foreground
-        if (wF == 0) break;
-
-        double f = i / dlength;
-        sumB += f * histogram[i];
-
-        double mB = sumB / wB;            // Mean Background
-        double mF = (sum - sumB) / wF;    // Mean Foreground
-
-        // Calculate Between Class Variance
-        double varBetween = (double) wB * (double) wF * (mB - mF) * (mB - mF);
-
-        // Check if new maximum found
-        if (varBetween > variance) {
-            variance = varBetween;
-            selectedMB = mB;
-            selectedMF = mF;
-        }
+    if( searchVariance(length,totalPixels,selected,variance) ) {
+        double wB = prefixCount[selected];
+        double sumB = prefixMoment[selected];
+        selectedMB = sumB / wB;
+        selectedMF = (prefixMoment[length-1] - sumB) / (totalPixels - wB);
     }
 
     // select a threshold which maximizes the distance between the two distributions. In pathological
     // cases there's a dead zone where all the values are equally good and it would select a value with a low index
     // arbitrarily. Then if you scaled the threshold it would reject everything
-    threshold = histogram.size*(selectedMB+selectedMF)/2.0;
+    threshold = length*(selectedMB+selectedMF)/2.0;
+    // values inside a bin are assumed to be at its center
+    if( binWidth > 1 )
+        threshold = threshold*binWidth + (binWidth-1)/2.0;
 }
\ No newline at end of file
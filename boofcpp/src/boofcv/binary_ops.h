@@ -1,11 +1,16 @@
 #ifndef BOOFCPP_BINARY_OPS_H
 #define BOOFCPP_BINARY_OPS_H
 
+#include <vector>
+
 #include "base_types.h"
 #include "image_types.h"
+#include "image_pool.h"
 #include "config_types.h"
 #include "image_statistics.h"
 #include "image_blur.h"
+#include "integral_image.h"
+#include "concurrency.h"
 
 namespace boofcv
 {
@@ -46,9 +51,139 @@ namespace boofcv
          * @param output The output image.
          */
         static void dilate4(const Gray<U8> &input, Gray<U8> &output);
+
+        /**
+         * Erodes an image according to an 8-neighborhood. Unless a pixel and all 8 of its neighbors are one its
+         * value is set to zero. Unlike {@link #erode4} the border is processed, pixels outside the image are ignored.
+         *
+         * @param input  Input image. Not modified.
+         * @param output The output image. Can be the same as the input.
+         */
+        static void erode8(const Gray<U8> &input, Gray<U8> &output);
+
+        /**
+         * Dilates an image according to an 8-neighborhood. If a pixel or any of its 8 neighbors is one then its
+         * output value will be one. Unlike {@link #dilate4} the border is processed, pixels outside the image are
+         * ignored.
+         *
+         * @param input  Input image. Not modified.
+         * @param output The output image. Can be the same as the input.
+         */
+        static void dilate8(const Gray<U8> &input, Gray<U8> &output);
+
+        /**
+         * Erodes an image with a rectangular structuring element which is (2*radiusX+1) by (2*radiusY+1) pixels.
+         * The output is the minimum inside the rectangle, with pixels outside the image being ignored. Applied
+         * as two separable passes using the van Herk/Gil-Werman algorithm, so the cost per pixel doesn't depend
+         * on the radius.
+         *
+         * @param input  Input image. Not modified.
+         * @param radiusX Radius of the rectangle along x-axis. Can be 0.
+         * @param radiusY Radius of the rectangle along y-axis. Can be 0.
+         * @param output The output image. Can be the same as the input.
+         * @param storage Stores the horizontal pass. Reshaped.
+         */
+        static void erodeRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output,
+                              Gray<U8> &storage);
+
+        /**
+         * Dilates an image with a rectangular structuring element. The output is the maximum inside the
+         * rectangle. See {@link #erodeRect}.
+         */
+        static void dilateRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output,
+                               Gray<U8> &storage);
+
+        static void erodeRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output);
+
+        static void dilateRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output);
+
+        /**
+         * Same as {@link #logicAnd} but rows are processed concurrently
+         */
+        static void logicAnd(const Gray<U8> &inputA, const Gray<U8> &inputB, Gray<U8> &output,
+                             const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #logicOr} but rows are processed concurrently
+         */
+        static void logicOr(const Gray<U8> &inputA, const Gray<U8> &inputB, Gray<U8> &output,
+                            const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #erode4} but rows are processed concurrently
+         */
+        static void erode4(const Gray<U8> &input, Gray<U8> &output, const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #dilate4} but rows are processed concurrently
+         */
+        static void dilate4(const Gray<U8> &input, Gray<U8> &output, const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #erode8} but rows are processed concurrently
+         */
+        static void erode8(const Gray<U8> &input, Gray<U8> &output, const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #dilate8} but rows are processed concurrently
+         */
+        static void dilate8(const Gray<U8> &input, Gray<U8> &output, const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #erodeRect} but rows are processed concurrently
+         */
+        static void erodeRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output,
+                              Gray<U8> &storage, const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #dilateRect} but rows are processed concurrently
+         */
+        static void dilateRect(const Gray<U8> &input, uint32_t radiusX, uint32_t radiusY, Gray<U8> &output,
+                               Gray<U8> &storage, const ConcurrencyContext& context );
+
+    private:
+        // Each of these only processes rows y0 (inclusive) to y1 (exclusive)
+        static void logicAnd(const Gray<U8> &inputA, const Gray<U8> &inputB, Gray<U8> &output,
+                             uint32_t y0, uint32_t y1);
+        static void logicOr(const Gray<U8> &inputA, const Gray<U8> &inputB, Gray<U8> &output,
+                            uint32_t y0, uint32_t y1);
+        static void erode4(const Gray<U8> &input, Gray<U8> &output, uint32_t y0, uint32_t y1);
+        static void dilate4(const Gray<U8> &input, Gray<U8> &output, uint32_t y0, uint32_t y1);
     };
 
 
+    /**
+     * Element wise operations on histograms stored as arrays of 32-bit counts. Used when aggregating the
+     * histograms of many blocks. Uses AVX2 when it's available.
+     */
+    class HistogramOps {
+    public:
+        /**
+         * dst[i] += src[i]
+         */
+        static void add( uint32_t* dst , const uint32_t* src , uint32_t length );
+
+        /**
+         * dst[i] -= src[i]
+         */
+        static void subtract( uint32_t* dst , const uint32_t* src , uint32_t length );
+
+        /**
+         * dst[i] += src[i] where src has 16-bit counts
+         */
+        static void add( uint32_t* dst , const uint16_t* src , uint32_t length );
+
+        /**
+         * dst[i] -= src[i] where src has 16-bit counts
+         */
+        static void subtract( uint32_t* dst , const uint16_t* src , uint32_t length );
+
+        /**
+         * Sum of all the elements
+         */
+        static uint32_t sum( const uint32_t* src , uint32_t length );
+    };
+
     /**
      * Computes different variants of Otsu. Can be configured to compute the standard version. This allows the user
      * to better handle textureless regions and can further tune it by scaling the threshold up and down.
@@ -62,6 +197,8 @@ namespace boofcv
         double variance;
         // Is the image being thresholded down or up
         bool down;
+        // Number of pixel values in each histogram bin. The threshold is converted from bins into pixel values
+        uint32_t binWidth = 1;
 
     private:
         // which Otsu variant to use
@@ -87,10 +224,46 @@ namespace boofcv
 
         void compute(const GrowArray<uint32_t>& histogram , uint32_t totalPixels);
 
+        void compute(const uint32_t* histogram , uint32_t length , uint32_t totalPixels);
+
+        /**
+         * Computes the threshold for 'count' histograms which are stored one after another. The number of pixels
+         * in each histogram is found from its counts. Scratch space is shared by all the histograms.
+         *
+         * @param histograms Histograms with 'length' bins each
+         * @param length Number of bins in each histogram
+         * @param count Number of histograms
+         * @param thresholds (Output) threshold for each histogram
+         */
+        void computeBatch(const uint32_t* histograms , uint32_t length , uint32_t count , double* thresholds );
+
     protected:
-        void computeOtsu(const GrowArray<uint32_t>& histogram , uint32_t totalPixels );
-        void computeOtsu2(const GrowArray<uint32_t>&  histogram  , uint32_t totalPixels );
+        // Histograms with up to this many bins keep their prefix sums inside the class. A copy, e.g. one for each
+        // band of rows processed concurrently, then never allocates memory
+        static const uint32_t INLINE_BINS = 256;
+
+        // Integer prefix sums of the histogram converted into double. prefixCount[i] is the number of pixels with
+        // a value <= i and prefixMoment[i] the sum of their values divided by the histogram's length.
+        // Set by computePrefixSums() to point into the inline arrays or the vectors.
+        double* prefixCount = nullptr;
+        double* prefixMoment = nullptr;
+
+        double inlineCount[INLINE_BINS] = {};
+        double inlineMoment[INLINE_BINS] = {};
+        // storage for longer histograms. std::vector so that copies of this class don't share scratch space
+        std::vector<double> heapCount;
+        std::vector<double> heapMoment;
+
+        uint32_t computePrefixSums(const uint32_t* histogram , uint32_t length );
+        void computeOtsu(uint32_t length , uint32_t totalPixels );
+        void computeOtsu2(uint32_t length , uint32_t totalPixels );
+        void adjustThreshold();
 
+        /**
+         * Finds the first bin with the largest between class variance. Returns false if no bin has a variance
+         * greater than zero.
+         */
+        bool searchVariance(uint32_t length , uint32_t totalPixels , uint32_t& selected , double& bestVariance );
     };
 
     class ThresholdOps
@@ -122,6 +295,23 @@ namespace boofcv
             return (uint32_t)otsu.threshold;
         }
 
+        /**
+         * Same as {@link #computeOtsu} but the histogram is computed concurrently
+         */
+        template<class T>
+        static uint32_t computeOtsu( const Gray<T>& input , T min_value , T max_value , bool otsu2 ,
+                                     const ConcurrencyContext& context ) {
+
+            auto range = static_cast<uint32_t>(1+max_value - min_value);
+            GrowArray<uint32_t> histogram(range);
+
+            ImageStatistics::histogram(input,min_value,histogram,context);
+
+            ComputeOtsu otsu(otsu2,0,true,1.0);
+            otsu.compute(histogram, input.total_pixels());
+            return (uint32_t)otsu.threshold;
+        }
+
         /**
           * Applies a global threshold across the whole image.  If 'down' is true, then pixels with values <=
           * to 'threshold' are set to 1 and the others set to 0.  If 'down' is false, then pixels with values >=
@@ -158,6 +348,78 @@ namespace boofcv
             }
         }
 
+        /**
+         * Thresholds a single row of pixels against one threshold. output[i] = down == (input[i] &le; threshold).
+         * Used when a threshold is applied to a block or row at a time.
+         *
+         * @param input Start of the input row
+         * @param threshold The threshold
+         * @param down direction of the threshold
+         * @param output Start of the output row
+         * @param length Number of pixels in the row
+         */
+        template<class T, class V>
+        static void thresholdRow( const T* input , V threshold , bool down , U8* output , uint32_t length ) {
+            for( uint32_t i = 0; i < length; i++ ) {
+                output[i] = static_cast<U8>( down == (input[i] <= threshold) );
+            }
+        }
+
+        /**
+         * Same as {@link #thresholdRow} but uses SIMD instructions when they are available
+         */
+        static void thresholdRow( const U8* input , U8 threshold , bool down , U8* output , uint32_t length );
+
+        /**
+         * Same as {@link #thresholdRow} but uses SIMD instructions when they are available
+         */
+        static void thresholdRow( const F32* input , F32 threshold , bool down , U8* output , uint32_t length );
+
+        /**
+         * Thresholds a single row of pixels where each pixel has its own threshold.
+         * output[i] = down == (input[i] &le; thresholds[i]).
+         *
+         * @param input Start of the input row
+         * @param thresholds Threshold for each pixel
+         * @param down direction of the threshold
+         * @param output Start of the output row
+         * @param length Number of pixels in the row
+         */
+        template<class T>
+        static void thresholdRowPixels( const T* input , const F32* thresholds , bool down , U8* output ,
+                                        uint32_t length ) {
+            for( uint32_t i = 0; i < length; i++ ) {
+                output[i] = static_cast<U8>( down == (input[i] <= thresholds[i]) );
+            }
+        }
+
+        /**
+         * Same as {@link #thresholdRowPixels} but uses SIMD instructions when they are available
+         */
+        static void thresholdRowPixels( const U8* input , const F32* thresholds , bool down , U8* output ,
+                                        uint32_t length );
+
+        /**
+         * Same as {@link #thresholdRowPixels} but uses SIMD instructions when they are available
+         */
+        static void thresholdRowPixels( const F32* input , const F32* thresholds , bool down , U8* output ,
+                                        uint32_t length );
+
+        /**
+         * Same as {@link #threshold} but bands of rows are processed concurrently
+         */
+        template<class T>
+        static void threshold( const Gray<T> &input , T threshold , bool down , Gray<U8> &output ,
+                               const ConcurrencyContext& context ) {
+            output.reshape(input.width,input.height);
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                Gray<T> input_band = input.makeSubimage(0,y0,input.width,y1);
+                Gray<U8> output_band = output.makeSubimage(0,y0,output.width,y1);
+                ThresholdOps::threshold(input_band,threshold,down,output_band);
+            });
+        }
+
         /**
          * Thresholds the image using a locally adaptive threshold that is computed using a local square region centered
          * on each pixel.  The threshold is equal to the average value of the surrounding pixels times the scale.
@@ -187,6 +449,225 @@ namespace boofcv
 
             BlurImageOps::mean(input,mean,radius,storage2);
 
+            thresholdMean(input,mean,scale,down,output);
+        }
+
+        /**
+         * Same as {@link #localMean} but the blur and threshold are processed concurrently
+         */
+        template<class T>
+        static void localMean( const Gray<T>& input , Gray<U8>& output ,
+                               const ConfigLength& width , float scale , bool down ,
+                               Gray<T>& storage1 , Gray<T>&  storage2 , const ConcurrencyContext& context ) {
+
+            output.reshape(input.width, input.height);
+            storage1.reshape(input.width, input.height);
+            storage2.reshape(input.width, input.height);
+
+            uint32_t radius = (uint32_t)width.computeI(min(input.width,input.height))/2;
+
+            Gray<T>& mean = storage1;
+
+            BlurImageOps::mean(input,mean,radius,storage2,context);
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                Gray<T> input_band = input.makeSubimage(0,y0,input.width,y1);
+                Gray<T> mean_band = mean.makeSubimage(0,y0,mean.width,y1);
+                Gray<U8> output_band = output.makeSubimage(0,y0,output.width,y1);
+                thresholdMean(input_band,mean_band,scale,down,output_band);
+            });
+        }
+
+        /**
+         * Same as {@link #localMean} but the local mean is computed from an integral image. The cost per pixel
+         * is the same for any region width and there are no intermediate images the size of the input. The mean
+         * is computed directly from the sum inside the region and is only rounded once, so integer images can
+         * differ slightly from {@link #localMean}, which rounds after the horizontal and vertical blur.
+         *
+         * @param integral Storage for the integral image.
+         */
+        template<class T, class I>
+        static void localMeanIntegral( const Gray<T>& input , Gray<U8>& output ,
+                                       const ConfigLength& width , float scale , bool down ,
+                                       Gray<I>& integral ) {
+
+            output.reshape(input.width, input.height);
+
+            uint32_t radius = (uint32_t)width.computeI(min(input.width,input.height))/2;
+
+            IntegralImageOps::transform(input,integral);
+
+            thresholdIntegral(input,integral,radius,scale,down,output,0,input.height);
+        }
+
+        /**
+         * Same as {@link #localMeanIntegral} but the threshold is processed concurrently. The integral image
+         * is computed by a single thread since each row depends on the previous one.
+         */
+        template<class T, class I>
+        static void localMeanIntegral( const Gray<T>& input , Gray<U8>& output ,
+                                       const ConfigLength& width , float scale , bool down ,
+                                       Gray<I>& integral , const ConcurrencyContext& context ) {
+
+            output.reshape(input.width, input.height);
+
+            uint32_t radius = (uint32_t)width.computeI(min(input.width,input.height))/2;
+
+            IntegralImageOps::transform(input,integral);
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                thresholdIntegral(input,integral,radius,scale,down,output,y0,y1);
+            });
+        }
+
+        /**
+         * Same as {@link #localMean} but the intermediate images are taken from the pool and handed back to it
+         * afterwards
+         */
+        template<class T>
+        static void localMean( const Gray<T>& input , Gray<U8>& output ,
+                               const ConfigLength& width , float scale , bool down ,
+                               ImagePool& pool , const ConcurrencyContext& context ) {
+            Gray<T> storage1 = pool.gray<T>(input.width,input.height);
+            Gray<T> storage2 = pool.gray<T>(input.width,input.height);
+            localMean(input,output,width,scale,down,storage1,storage2,context);
+        }
+
+        /**
+         * Same as {@link #localMeanIntegral} but the integral image is taken from the pool and handed back to it
+         * afterwards
+         */
+        template<class T>
+        static void localMeanIntegral( const Gray<T>& input , Gray<U8>& output ,
+                                       const ConfigLength& width , float scale , bool down ,
+                                       ImagePool& pool , const ConcurrencyContext& context ) {
+            typedef typename IntegralImageType<T>::type I;
+            Gray<I> integral = pool.gray<I>(input.width+1,input.height+1);
+            localMeanIntegral(input,output,width,scale,down,integral,context);
+        }
+
+    private:
+        /**
+         * Mean of a region with integer pixels. Rounded the same way as the mean blur.
+         *
+         * Integer division is slow so it multiplies by the reciprocal of the area instead. (total+area/2 &plusmn; 0.5)/area
+         * is never closer than 0.5/area to an integer, so truncating it gives the same answer as integer division
+         * as long as the round off error is smaller than that. That's true if the area is less than 2^19 and the
+         * sum fits inside of 32-bits. Otherwise integer division is used.
+         */
+        template<class T, class Enable = void>
+        struct RegionMean {
+            typedef typename TypeInfo<T>::sum_type sum_type;
+
+            sum_type divisor;
+            sum_type halfDivisor;
+            double reciprocal;
+            bool use_reciprocal;
+
+            explicit RegionMean( uint32_t area ) :
+                    divisor(static_cast<sum_type>(area)), halfDivisor(static_cast<sum_type>(area/2)),
+                    reciprocal(1.0/area), use_reciprocal( sizeof(sum_type) <= 4 && area < (1u << 19) ) {}
+
+            template<class I>
+            T operator()( I sum ) const {
+                auto total = static_cast<sum_type>(sum);
+                if( use_reciprocal ) {
+                    double numerator = static_cast<double>(total+halfDivisor);
+                    numerator += numerator >= 0 ? 0.5 : -0.5;
+                    return static_cast<T>(static_cast<int64_t>(numerator*reciprocal));
+                } else {
+                    return static_cast<T>((total+halfDivisor)/divisor);
+                }
+            }
+        };
+
+        template<class T>
+        struct RegionMean<T, typename std::enable_if<std::is_floating_point<T>::value >::type> {
+            double area;
+
+            explicit RegionMean( uint32_t area ) : area(area) {}
+
+            template<class I>
+            T operator()( I sum ) const {
+                return static_cast<T>(sum/area);
+            }
+        };
+
+        /**
+         * Thresholds rows y0 (inclusive) to y1 (exclusive) using the mean inside a square region centered on
+         * each pixel. Regions are clipped at the image border.
+         */
+        template<class T, class I>
+        static void thresholdIntegral( const Gray<T>& input , const Gray<I>& integral , uint32_t radius ,
+                                       float scale , bool down , Gray<U8>& output ,
+                                       uint32_t y0 , uint32_t y1 ) {
+            if( down )
+                thresholdIntegral<true>(input,integral,radius,scale,output,y0,y1);
+            else
+                thresholdIntegral<false>(input,integral,radius,scale,output,y0,y1);
+        }
+
+        template<bool down, class T, class I>
+        static void thresholdIntegral( const Gray<T>& input , const Gray<I>& integral , uint32_t radius ,
+                                       float scale , Gray<U8>& output , uint32_t y0 , uint32_t y1 ) {
+            const uint32_t width = input.width;
+            // columns where the region isn't clipped by the left or right border
+            const uint32_t inner0 = std::min(radius,width);
+            const uint32_t inner1 = std::max(inner0,width > radius ? width-radius : 0);
+
+            for( uint32_t y = y0; y < y1; y++ ) {
+                uint32_t top = y > radius ? y-radius : 0;
+                uint32_t bottom = std::min(input.height,y+radius+1);
+                uint32_t rows = bottom-top;
+
+                const I* ptr_top = &integral.data[integral.offset + top*integral.stride];
+                const I* ptr_bottom = &integral.data[integral.offset + bottom*integral.stride];
+                const T* input_ptr = &input.data[input.offset + y*input.stride];
+                U8* output_ptr = &output.data[output.offset + y*output.stride];
+
+                uint32_t x = 0;
+                for( ; x < inner0; x++ ) {
+                    uint32_t right = std::min(width,x+radius+1);
+                    I sum = ptr_bottom[right] - ptr_top[right];
+                    output_ptr[x] = thresholdPixel<down>(input_ptr[x],RegionMean<T>(rows*right)(sum),scale);
+                }
+
+                // inside the region is always the same size, which removes all the branches. When the radius is
+                // at least the width there are no such columns and x-radius would wrap around
+                if( inner0 < inner1 ) {
+                    const RegionMean<T> mean(rows*(2*radius+1));
+                    const I* top_left = &ptr_top[x-radius];
+                    const I* top_right = &ptr_top[x+radius+1];
+                    const I* bottom_left = &ptr_bottom[x-radius];
+                    const I* bottom_right = &ptr_bottom[x+radius+1];
+                    for( ; x < inner1; x++ ) {
+                        I sum = (*bottom_right++ - *bottom_left++) - (*top_right++ - *top_left++);
+                        output_ptr[x] = thresholdPixel<down>(input_ptr[x],mean(sum),scale);
+                    }
+                }
+
+                for( ; x < width; x++ ) {
+                    uint32_t left = x > radius ? x-radius : 0;
+                    I sum = (ptr_bottom[width] - ptr_bottom[left]) - (ptr_top[width] - ptr_top[left]);
+                    output_ptr[x] = thresholdPixel<down>(input_ptr[x],RegionMean<T>(rows*(width-left))(sum),scale);
+                }
+            }
+        }
+
+        template<bool down, class T>
+        static U8 thresholdPixel( T value , T mean , float scale ) {
+            if( down )
+                return static_cast<U8>( value <= mean*scale );
+            else
+                return static_cast<U8>( value*scale > mean );
+        }
+
+        /**
+         * Thresholds each pixel using the local mean
+         */
+        template<class T>
+        static void thresholdMean( const Gray<T>& input , const Gray<T>& mean , float scale , bool down ,
+                                   Gray<U8>& output ) {
             if( down ) {
                 for( uint32_t y = 0; y < input.height; y++ ) {
                     T* mean_ptr = &mean.data[mean.offset + y*mean.stride];
@@ -221,9 +702,24 @@ namespace boofcv
     public:
         typedef typename T::pixel_type pixel_type;
 
+        // Specifies if the image should be processed using multiple threads. Single threaded by default.
+        ConcurrencyContext concurrency;
+        // If not null then intermediate images are taken from this pool for each image and handed back when
+        // done, instead of being kept by the filter
+        ImagePool* pool = nullptr;
+
         virtual ~InputToBinary() = default;
 
         virtual void process(const T& input , Gray<U8>& output ) = 0;
+
+    protected:
+        /**
+         * Allocation for scratch images which only live for a single call. They come from the pool if there is one.
+         * Pixels are not initialized.
+         */
+        ImageAllocation scratchAllocation() const {
+            return ImageAllocation(false,false,pool);
+        }
     };
 
     template<class T>
@@ -238,7 +734,7 @@ namespace boofcv
         { }
 
         void process(const Gray<T>& input , Gray<U8>& output ) override {
-            ThresholdOps::threshold(input,threshold,down,output);
+            ThresholdOps::threshold(input,threshold,down,output,this->concurrency);
         }
     };
 
@@ -255,8 +751,8 @@ namespace boofcv
         {  }
 
         void process(const Gray<T>& input , Gray<U8>& output ) override {
-            T threshold = ThresholdOps::computeOtsu(input,min_value,max_value,false);
-            ThresholdOps::threshold(input,threshold,down,output);
+            T threshold = ThresholdOps::computeOtsu(input,min_value,max_value,false,this->concurrency);
+            ThresholdOps::threshold(input,threshold,down,output,this->concurrency);
         }
     };
 
@@ -267,17 +763,28 @@ namespace boofcv
         ConfigLength regionWidth;
         float scale;
         bool down;
+        // If true the local mean is computed from an integral image. See ThresholdOps::localMeanIntegral
+        bool useIntegral;
         Gray<T> storage1;
         Gray<T> storage2;
+        Gray<typename IntegralImageType<T>::type> integral;
 
-        LocalMeanBinaryFilter( const ConfigLength& regionWidth, float scale, bool down ) :
-                scale(scale), down(down)
+        LocalMeanBinaryFilter( const ConfigLength& regionWidth, float scale, bool down , bool useIntegral = false ) :
+                scale(scale), down(down), useIntegral(useIntegral)
         {
             this->regionWidth = regionWidth;
         }
 
         void process(const Gray<T>& input , Gray<U8>& output ) override {
-            ThresholdOps::localMean(input,output,regionWidth,scale,down,storage1,storage2);
+            if( this->pool != nullptr ) {
+                if( useIntegral )
+                    ThresholdOps::localMeanIntegral(input,output,regionWidth,scale,down,*this->pool,this->concurrency);
+                else
+                    ThresholdOps::localMean(input,output,regionWidth,scale,down,*this->pool,this->concurrency);
+            } else if( useIntegral )
+                ThresholdOps::localMeanIntegral(input,output,regionWidth,scale,down,integral,this->concurrency);
+            else
+                ThresholdOps::localMean(input,output,regionWidth,scale,down,storage1,storage2,this->concurrency);
         }
     };
 }
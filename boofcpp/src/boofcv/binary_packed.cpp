@@ -0,0 +1,180 @@
+#include <vector>
+
+#include "binary_packed.h"
+#include "cpu_features.h"
+
+#if BOOFCPP_SIMD_AVX2
+#include <immintrin.h>
+#define BOOFCPP_SIMD_TARGET __attribute__((target("avx2")))
+#endif
+
+using namespace boofcv;
+
+namespace {
+
+    /**
+     * Packs 'count' pixels into words. Bits past 'count' in the last word are zero.
+     */
+    void pack_row( const U8* input , uint32_t count , uint64_t* output ) {
+        uint32_t x = 0;
+        for( ; x + 64 <= count; x += 64 ) {
+            uint64_t word = 0;
+            for( uint32_t i = 0; i < 64; i++ ) {
+                word |= uint64_t(input[x+i] != 0) << i;
+            }
+            *output++ = word;
+        }
+        if( x < count ) {
+            uint64_t word = 0;
+            for( uint32_t i = 0; x + i < count; i++ ) {
+                word |= uint64_t(input[x+i] != 0) << i;
+            }
+            *output = word;
+        }
+    }
+
+#if BOOFCPP_SIMD_AVX2
+    // Compares 32 pixels against zero at once and gathers the results into a bit mask
+    BOOFCPP_SIMD_TARGET void pack_row_avx2( const U8* input , uint32_t count , uint64_t* output ) {
+        const __m256i zero = _mm256_setzero_si256();
+        uint32_t x = 0;
+        for( ; x + 64 <= count; x += 64 ) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&input[x]));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&input[x+32]));
+            auto low = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a,zero)));
+            auto high = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(b,zero)));
+            *output++ = ~((uint64_t(high) << 32) | low);
+        }
+        pack_row(&input[x],count-x,output);
+    }
+#endif
+
+    /**
+     * Applies erode or dilate to a row. Rows above and below the image are passed in as zeros.
+     */
+    template<bool erode>
+    void morph4_row( const uint64_t* above , const uint64_t* center , const uint64_t* below ,
+                     uint64_t* output , uint32_t words , uint64_t last_mask ) {
+        for( uint32_t i = 0; i < words; i++ ) {
+            uint64_t c = center[i];
+            // shift the neighbors to the left and right of each pixel into its bit
+            uint64_t left = (c << 1) | (i > 0 ? center[i-1] >> 63 : 0);
+            uint64_t right = (c >> 1) | (i+1 < words ? center[i+1] << 63 : 0);
+            if( erode )
+                output[i] = c & left & right & above[i] & below[i];
+            else
+                output[i] = c | left | right | above[i] | below[i];
+        }
+        if( words > 0 )
+            output[words-1] &= last_mask;
+    }
+
+    template<bool erode>
+    void morph4( const GrayBits& input , GrayBits& output , uint32_t y0 , uint32_t y1 ) {
+        uint32_t words = input.wordsPerRow();
+        uint64_t mask = input.lastWordMask();
+        std::vector<uint64_t> zeros(words,0);
+
+        for( uint32_t y = y0; y < y1; y++ ) {
+            const uint64_t* above = y > 0 ? input.row(y-1) : zeros.data();
+            const uint64_t* below = y+1 < input.height ? input.row(y+1) : zeros.data();
+            morph4_row<erode>(above,input.row(y),below,output.row(y),words,mask);
+        }
+    }
+}
+
+void BinaryPackedOps::convert( const Gray<U8>& input , GrayBits& output ) {
+    output.reshape(input.width,input.height);
+
+#if BOOFCPP_SIMD_AVX2
+    bool simd = CpuFeatures::avx2();
+#endif
+    for( uint32_t y = 0; y < input.height; y++ ) {
+        const U8* ptr = &input.data[input.offset + y*input.stride];
+#if BOOFCPP_SIMD_AVX2
+        if( simd ) {
+            pack_row_avx2(ptr,input.width,output.row(y));
+            continue;
+        }
+#endif
+        pack_row(ptr,input.width,output.row(y));
+    }
+}
+
+void BinaryPackedOps::convert( const GrayBits& input , Gray<U8>& output ) {
+    output.reshape(input.width,input.height);
+
+    for( uint32_t y = 0; y < input.height; y++ ) {
+        const uint64_t* ptr = input.row(y);
+        U8* out = &output.data[output.offset + y*output.stride];
+        for( uint32_t x = 0; x < input.width; x++ ) {
+            out[x] = static_cast<U8>((ptr[x/GrayBits::BITS] >> (x%GrayBits::BITS)) & 1);
+        }
+    }
+}
+
+void BinaryPackedOps::logicAnd( const GrayBits& inputA , const GrayBits& inputB , GrayBits& output ) {
+    if( inputA.width != inputB.width || inputA.height != inputB.height )
+        throw invalid_argument("Input shapes must match");
+    output.reshape(inputA.width,inputA.height);
+
+    uint32_t words = inputA.wordsPerRow();
+    for( uint32_t y = 0; y < inputA.height; y++ ) {
+        const uint64_t* a = inputA.row(y);
+        const uint64_t* b = inputB.row(y);
+        uint64_t* out = output.row(y);
+        for( uint32_t i = 0; i < words; i++ ) {
+            out[i] = a[i] & b[i];
+        }
+    }
+}
+
+void BinaryPackedOps::logicOr( const GrayBits& inputA , const GrayBits& inputB , GrayBits& output ) {
+    if( inputA.width != inputB.width || inputA.height != inputB.height )
+        throw invalid_argument("Input shapes must match");
+    output.reshape(inputA.width,inputA.height);
+
+    uint32_t words = inputA.wordsPerRow();
+    for( uint32_t y = 0; y < inputA.height; y++ ) {
+        const uint64_t* a = inputA.row(y);
+        const uint64_t* b = inputB.row(y);
+        uint64_t* out = output.row(y);
+        for( uint32_t i = 0; i < words; i++ ) {
+            out[i] = a[i] | b[i];
+        }
+    }
+}
+
+void BinaryPackedOps::erode4( const GrayBits& input , GrayBits& output ) {
+    output.reshape(input.width,input.height);
+    erode4(input,output,0,input.height);
+}
+
+void BinaryPackedOps::dilate4( const GrayBits& input , GrayBits& output ) {
+    output.reshape(input.width,input.height);
+    dilate4(input,output,0,input.height);
+}
+
+void BinaryPackedOps::erode4( const GrayBits& input , GrayBits& output , const ConcurrencyContext& context ) {
+    output.reshape(input.width,input.height);
+
+    concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+        erode4(input,output,y0,y1);
+    });
+}
+
+void BinaryPackedOps::dilate4( const GrayBits& input , GrayBits& output , const ConcurrencyContext& context ) {
+    output.reshape(input.width,input.height);
+
+    concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+        dilate4(input,output,y0,y1);
+    });
+}
+
+void BinaryPackedOps::erode4( const GrayBits& input , GrayBits& output , uint32_t y0 , uint32_t y1 ) {
+    morph4<true>(input,output,y0,y1);
+}
+
+void BinaryPackedOps::dilate4( const GrayBits& input , GrayBits& output , uint32_t y0 , uint32_t y1 ) {
+    morph4<false>(input,output,y0,y1);
+}
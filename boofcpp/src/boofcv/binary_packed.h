@@ -0,0 +1,221 @@
+#ifndef BOOFCPP_BINARY_PACKED_H
+#define BOOFCPP_BINARY_PACKED_H
+
+#include <cstdint>
+
+#include "base_types.h"
+#include "image_types.h"
+#include "concurrency.h"
+
+namespace boofcv {
+
+    /**
+     * Binary image where each pixel is a single bit. Each row is packed into 64-bit words, with pixel x in bit
+     * x%64 of word x/64. Uses 1/8 the memory of a Gray<U8> binary image and operations can process 64 pixels
+     * at once. Bits past the end of a row are always zero.
+     *
+     * Sub-images are not supported.
+     */
+    class GrayBits : public ImageBaseT<uint64_t> {
+    public:
+        // Number of pixels in each word
+        static const uint32_t BITS = 64;
+
+        uint64_t* data;
+        // length of the array. Can be larger than stride*height because of reshaping
+        uint32_t data_length;
+
+        GrayBits( uint32_t width , uint32_t height ) : GrayBits(width,height,ImageAllocation()) {
+        }
+
+        /**
+         * Creates an image with the specified allocator, row padding and initialization
+         */
+        GrayBits( uint32_t width , uint32_t height , const ImageAllocation& allocation ) {
+            this->setAllocation(allocation);
+            this->width = width;
+            this->height = height;
+            this->offset = 0;
+            this->stride = this->strideFor(wordsFor(width));
+            this->data_length = this->stride*height;
+            this->data = this->allocatePixels(this->data_length,allocation.zero);
+            this->subimage = false;
+        }
+
+        GrayBits() : GrayBits(0,0) {
+        }
+
+        GrayBits( const GrayBits& other ) : GrayBits(0,0,ImageAllocation(other.pad_rows,other.zero_pixels,other.allocator)) {
+            setTo(other);
+        }
+
+        GrayBits( GrayBits&& other ) noexcept : GrayBits() {
+            swap(other);
+        }
+
+        ~GrayBits() {
+            this->freePixels();
+        }
+
+        /**
+         * Changes the image's shape. Pixel values are undefined afterwards, unless the array had to grow and
+         * zero_pixels is true, but bits past the end of each row are always zero.
+         */
+        void reshape( uint32_t width , uint32_t height ) override {
+            if( this->width == width && this->height == height )
+                return;
+            this->invalidateSubimages();
+
+            uint32_t stride = this->strideFor(wordsFor(width));
+            uint32_t desired_length = stride*height;
+            if( desired_length > this->data_length ) {
+                this->data = this->allocatePixels(desired_length,this->zero_pixels);
+                this->data_length = desired_length;
+            }
+            this->width = width;
+            this->height = height;
+            this->stride = stride;
+            clearPadding();
+        }
+
+        bool get( uint32_t x , uint32_t y ) const {
+            if( x >= this->width || y >= this->height )
+                throw invalid_argument("out of range");
+            return ((row(y)[x/BITS] >> (x%BITS)) & 1) != 0;
+        }
+
+        void set( uint32_t x , uint32_t y , bool value ) {
+            if( x >= this->width || y >= this->height )
+                throw invalid_argument("out of range");
+            uint64_t bit = uint64_t(1) << (x%BITS);
+            uint64_t& word = row(y)[x/BITS];
+            word = value ? word | bit : word & ~bit;
+        }
+
+        /**
+         * Pointer to the first word in a row
+         */
+        uint64_t* row( uint32_t y ) const {
+            return &this->data[this->offset + y*this->stride];
+        }
+
+        // Number of words which contain pixels in each row
+        uint32_t wordsPerRow() const {
+            return wordsFor(this->width);
+        }
+
+        // Bits in the last word of a row which are inside the image
+        uint64_t lastWordMask() const {
+            uint32_t remainder = this->width % BITS;
+            return remainder == 0 ? ~uint64_t(0) : (uint64_t(1) << remainder) - 1;
+        }
+
+        void setTo( const GrayBits& src ) {
+            reshape(src.width,src.height);
+            // the two images can have different strides if only one of them pads its rows
+            const uint32_t words = wordsPerRow();
+            for( uint32_t y = 0; y < this->height; y++ ) {
+                uint64_t* ptr = row(y);
+                std::memcpy(ptr,src.row(y),sizeof(uint64_t)*words);
+                for( uint32_t i = words; i < this->stride; i++ ) {
+                    ptr[i] = 0;
+                }
+            }
+        }
+
+        void swap( GrayBits& other ) noexcept {
+            std::swap(this->data,other.data);
+            std::swap(this->data_length,other.data_length);
+            this->swapBase(other);
+        }
+
+        GrayBits& operator=( const GrayBits& other ) {
+            if( this != &other )
+                setTo(other);
+            return *this;
+        }
+
+        GrayBits& operator=( GrayBits&& other ) noexcept {
+            if( this != &other )
+                swap(other);
+            return *this;
+        }
+
+        static uint32_t wordsFor( uint32_t width ) {
+            return (width + BITS - 1)/BITS;
+        }
+
+    private:
+        void clearPadding() {
+            uint32_t words = wordsPerRow();
+            if( words == 0 )
+                return;
+            uint64_t mask = lastWordMask();
+            for( uint32_t y = 0; y < this->height; y++ ) {
+                uint64_t* ptr = row(y);
+                ptr[words-1] &= mask;
+                for( uint32_t i = words; i < this->stride; i++ ) {
+                    ptr[i] = 0;
+                }
+            }
+        }
+    };
+
+    /**
+     * Operations on bit packed binary images. Pixels are processed a word at a time using shifts and bitwise
+     * logic, 64 pixels per operation. Results are the same as the equivalent functions in BinaryImageOps.
+     * Unlike BinaryImageOps the image border is also processed, with pixels outside of the image treated
+     * as zero.
+     */
+    class BinaryPackedOps {
+    public:
+        /**
+         * Packs a binary image. Any non-zero pixel is set to 1.
+         */
+        static void convert( const Gray<U8>& input , GrayBits& output );
+
+        /**
+         * Unpacks into a binary image with values of 0 and 1
+         */
+        static void convert( const GrayBits& input , Gray<U8>& output );
+
+        /**
+         * For each pixel it applies the logical 'and' operator between two images. Output can be an input.
+         */
+        static void logicAnd( const GrayBits& inputA , const GrayBits& inputB , GrayBits& output );
+
+        /**
+         * For each pixel it applies the logical 'or' operator between two images. Output can be an input.
+         */
+        static void logicOr( const GrayBits& inputA , const GrayBits& inputB , GrayBits& output );
+
+        /**
+         * Erodes an image according to a 4-neighborhood. Unless a pixel is connected to all its neighbors its
+         * value is set to zero. Output can't be the input.
+         */
+        static void erode4( const GrayBits& input , GrayBits& output );
+
+        /**
+         * Dilates an image according to a 4-neighborhood. If a pixel is connected to any other pixel then its
+         * value is set to one. Output can't be the input.
+         */
+        static void dilate4( const GrayBits& input , GrayBits& output );
+
+        /**
+         * Same as {@link #erode4} but rows are processed concurrently
+         */
+        static void erode4( const GrayBits& input , GrayBits& output , const ConcurrencyContext& context );
+
+        /**
+         * Same as {@link #dilate4} but rows are processed concurrently
+         */
+        static void dilate4( const GrayBits& input , GrayBits& output , const ConcurrencyContext& context );
+
+    private:
+        // Each of these only processes rows y0 (inclusive) to y1 (exclusive)
+        static void erode4( const GrayBits& input , GrayBits& output , uint32_t y0 , uint32_t y1 );
+        static void dilate4( const GrayBits& input , GrayBits& output , uint32_t y0 , uint32_t y1 );
+    };
+}
+
+#endif
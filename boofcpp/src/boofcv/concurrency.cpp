@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "concurrency.h"
+
+using namespace boofcv;
+
+// Set while a thread is processing tasks. Used to detect nested calls to execute()
+static thread_local bool inside_task = false;
+
+static uint64_t pack_range( uint32_t begin , uint32_t end ) {
+    return ((uint64_t)begin << 32) | end;
+}
+
+static void unpack_range( uint64_t value , uint32_t& begin , uint32_t& end ) {
+    begin = (uint32_t)(value >> 32);
+    end = (uint32_t)value;
+}
+
+ThreadPool::ThreadPool( uint32_t num_threads ) {
+    if( num_threads == 0 )
+        num_threads = std::max(1U,std::thread::hardware_concurrency());
+
+    ranges.reset(new Range[num_threads]);
+
+    for( uint32_t i = 1; i < num_threads; i++ ) {
+        workers.emplace_back(&ThreadPool::worker_loop,this,i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    work_ready.notify_all();
+    for( auto& worker : workers ) {
+        worker.join();
+    }
+}
+
+void ThreadPool::execute( uint32_t count , const std::function<void(uint32_t)>& task ) {
+    if( count == 0 )
+        return;
+
+    // Nested calls and pools without workers process everything in this thread
+    if( inside_task || workers.empty() ) {
+        for( uint32_t i = 0; i < count; i++ ) {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> execute_lock(execute_mutex);
+    {
+        // A worker which woke up late could still be looking at the previous tasks
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock,[this]{ return active == 0; });
+        this->task = &task;
+        this->count = count;
+        this->finished = 0;
+        this->error = nullptr;
+
+        // Give each thread an equal share of the tasks to start with
+        uint64_t threads = size();
+        for( uint32_t i = 0; i < threads; i++ ) {
+            auto begin = (uint32_t)(count*i/threads);
+            auto end = (uint32_t)(count*(i+1)/threads);
+            ranges[i].value = pack_range(begin,end);
+        }
+        this->generation++;
+    }
+    work_ready.notify_all();
+
+    inside_task = true;
+    process_tasks(0);
+    inside_task = false;
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock,[this]{ return finished == this->count && active == 0; });
+        this->task = nullptr;
+        error = this->error;
+    }
+
+    if( error )
+        std::rethrow_exception(error);
+}
+
+void ThreadPool::worker_loop( uint32_t slot ) {
+    inside_task = true;
+    uint64_t seen_generation = 0;
+
+    while( true ) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock,[&]{ return stop || generation != seen_generation; });
+            if( stop )
+                return;
+            seen_generation = generation;
+            active++;
+        }
+
+        process_tasks(slot);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+        }
+        work_done.notify_all();
+    }
+}
+
+void ThreadPool::process_tasks( uint32_t slot ) {
+    while( true ) {
+        uint32_t index;
+        if( !next(slot,index) ) {
+            if( steal(slot) )
+                continue;
+            break;
+        }
+
+        try {
+            (*task)(index);
+        } catch( ... ) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if( !error )
+                error = std::current_exception();
+        }
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = ++finished == count;
+        }
+        if( done )
+            work_done.notify_all();
+    }
+}
+
+bool ThreadPool::next( uint32_t slot , uint32_t& index ) {
+    std::atomic<uint64_t>& range = ranges[slot].value;
+    uint64_t value = range.load();
+    while( true ) {
+        uint32_t begin,end;
+        unpack_range(value,begin,end);
+        if( begin >= end )
+            return false;
+        if( range.compare_exchange_weak(value,pack_range(begin+1,end)) ) {
+            index = begin;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal( uint32_t slot ) {
+    const uint32_t threads = size();
+
+    while( true ) {
+        // The victim is the thread with the most work left
+        uint32_t victim = 0;
+        uint32_t best = 0;
+        uint64_t victim_value = 0;
+        for( uint32_t i = 0; i < threads; i++ ) {
+            if( i == slot )
+                continue;
+            uint64_t value = ranges[i].value.load();
+            uint32_t begin,end;
+            unpack_range(value,begin,end);
+            if( begin < end && end-begin > best ) {
+                best = end-begin;
+                victim = i;
+                victim_value = value;
+            }
+        }
+
+        // The owner always keeps the next task in its range. That way a range which has been modified
+        // can never return to a previous value.
+        if( best < 2 )
+            return false;
+
+        uint32_t begin,end;
+        unpack_range(victim_value,begin,end);
+        uint32_t middle = end - best/2;
+        if( ranges[victim].value.compare_exchange_strong(victim_value,pack_range(begin,middle)) ) {
+            // Only this thread modifies its own range when it's empty
+            ranges[slot].value = pack_range(middle,end);
+            return true;
+        }
+    }
+}
+
+// The pool shared across the library and how many threads it should have
+static std::mutex global_mutex;
+static std::unique_ptr<ThreadPool> global_pool;
+static uint32_t global_threads = 0;
+
+ThreadPool& ThreadPool::global() {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if( !global_pool ) {
+        uint32_t num_threads = global_threads;
+        if( num_threads == 0 ) {
+            const char* text = std::getenv("BOOFCPP_NUM_THREADS");
+            if( text != nullptr ) {
+                long value = std::strtol(text,nullptr,10);
+                num_threads = value > 0 ? (uint32_t)value : 0;
+            }
+        }
+        global_pool.reset(new ThreadPool(num_threads));
+    }
+    return *global_pool;
+}
+
+void ThreadPool::setGlobalThreads( uint32_t num_threads ) {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    global_threads = num_threads;
+    // the pool is created again with the new number of threads when it's next requested
+    global_pool.reset();
+}
+
+void boofcv::parallel_for( const ConcurrencyContext& context , uint32_t begin , uint32_t end ,
+                           const std::function<void(uint32_t,uint32_t)>& func )
+{
+    if( end <= begin )
+        return;
+
+    uint32_t length = end-begin;
+    uint32_t threads = context.pool == nullptr ? 1 : context.pool->size();
+    uint32_t grain = std::max(1U,context.grain);
+
+    // A few blocks per thread helps balance the load if some threads are slower
+    uint32_t block = std::max(grain,(length + 4*threads - 1)/(4*threads));
+    uint32_t num_blocks = (length + block - 1)/block;
+
+    if( threads == 1 || num_blocks == 1 ) {
+        func(begin,end);
+        return;
+    }
+
+    context.pool->execute(num_blocks,[&](uint32_t i){
+        uint32_t i0 = begin + i*block;
+        uint32_t i1 = std::min(end,i0+block);
+        func(i0,i1);
+    });
+}
+
+void boofcv::concurrent_rows( const ConcurrencyContext& context , uint32_t rows ,
+                              const std::function<void(uint32_t,uint32_t)>& func )
+{
+    parallel_for(context,0,rows,func);
+}
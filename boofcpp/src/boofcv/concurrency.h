@@ -0,0 +1,143 @@
+#ifndef BOOFCPP_CONCURRENCY_H
+#define BOOFCPP_CONCURRENCY_H
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <memory>
+
+namespace boofcv {
+
+    /**
+     * A fixed size pool of threads which process a set of tasks. The thread which calls {@link #execute} also
+     * processes tasks and blocks until all of them have finished. If {@link #execute} is called from inside
+     * of a task then the new tasks are processed sequentially by the calling thread.
+     *
+     * Tasks are scheduled using work stealing. Each thread starts with a contiguous range of task indexes and
+     * processes them in order. Once a thread runs out it steals the back half of the largest remaining range.
+     * Neighboring tasks usually touch neighboring memory, so this keeps threads in their own part of the image
+     * while still balancing the load when some tasks take longer than others.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @param num_threads Total number of threads which process tasks, including the calling thread.
+         *                    If zero then the number of hardware threads is used.
+         */
+        explicit ThreadPool( uint32_t num_threads = 0 );
+
+        ~ThreadPool();
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=( const ThreadPool& ) = delete;
+
+        /**
+         * Invokes task(i) for i = 0 to count-1 and returns once all have finished. The order tasks are
+         * processed in is not specified. If a task throws an exception then one of the exceptions is
+         * rethrown after all tasks have finished.
+         */
+        void execute( uint32_t count , const std::function<void(uint32_t)>& task );
+
+        /**
+         * Number of threads which process tasks, including the calling thread
+         */
+        uint32_t size() const {
+            return (uint32_t)workers.size()+1;
+        }
+
+        /**
+         * Returns a pool which is shared across the library. It's created the first time it's requested.
+         * The number of threads is set by {@link #setGlobalThreads}, then the BOOFCPP_NUM_THREADS environmental
+         * variable, then the number of hardware threads.
+         */
+        static ThreadPool& global();
+
+        /**
+         * Changes the number of threads in the global pool. Must not be called while the global pool is being used.
+         *
+         * @param num_threads Total number of threads. If zero then the default is used.
+         */
+        static void setGlobalThreads( uint32_t num_threads );
+
+    private:
+        // Task indexes [begin,end) which a thread has yet to process. Packed into 64-bits so that the owner
+        // and thieves can update it atomically.
+        struct Range {
+            std::atomic<uint64_t> value{0};
+        };
+
+        void worker_loop( uint32_t slot );
+        void process_tasks( uint32_t slot );
+        bool next( uint32_t slot , uint32_t& index );
+        bool steal( uint32_t slot );
+
+        std::vector<std::thread> workers;
+
+        // only one set of tasks can be processed at a time
+        std::mutex execute_mutex;
+
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+
+        // Description of the tasks currently being processed
+        const std::function<void(uint32_t)>* task = nullptr;
+        uint32_t count = 0;
+        // Remaining tasks for each thread. The calling thread is slot 0.
+        std::unique_ptr<Range[]> ranges;
+        uint32_t finished = 0;
+        // number of worker threads inside of process_tasks()
+        uint32_t active = 0;
+        uint64_t generation = 0;
+        bool stop = false;
+        std::exception_ptr error;
+    };
+
+    /**
+     * Specifies if and how an image operation should be run on multiple threads
+     */
+    struct ConcurrencyContext {
+        // Thread pool which processes the work. If null then the operation is single threaded.
+        ThreadPool* pool = nullptr;
+        // The minimum number of rows in a band. Smaller bands have more overhead.
+        uint32_t grain = 32;
+
+        ConcurrencyContext() = default;
+
+        explicit ConcurrencyContext( ThreadPool& pool , uint32_t grain = 32 ) : pool(&pool), grain(grain) {}
+
+        /**
+         * Context which uses the library's global thread pool
+         */
+        static ConcurrencyContext global( uint32_t grain = 32 ) {
+            return ConcurrencyContext(ThreadPool::global(),grain);
+        }
+    };
+
+    /**
+     * Splits the indexes from begin to end-1 into blocks and calls func(i0,i1) once for each block. Blocks are
+     * processed in parallel using the context's thread pool. A block has at least context.grain indexes,
+     * except for the last one.
+     *
+     * @param func Processes indexes i0 (inclusive) to i1 (exclusive)
+     */
+    void parallel_for( const ConcurrencyContext& context , uint32_t begin , uint32_t end ,
+                       const std::function<void(uint32_t,uint32_t)>& func );
+
+    /**
+     * Splits the rows from 0 to rows-1 into bands and calls func(y0,y1) once for each band. Bands are
+     * processed in parallel using the context's thread pool.
+     *
+     * @param rows Total number of rows
+     * @param func Processes rows y0 (inclusive) to y1 (exclusive)
+     */
+    void concurrent_rows( const ConcurrencyContext& context , uint32_t rows ,
+                          const std::function<void(uint32_t,uint32_t)>& func );
+}
+
+#endif
@@ -1,16 +1,54 @@
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
 #include "contour.h"
+#include "cpu_features.h"
+
+#if BOOFCPP_SIMD_AVX2
+#include <immintrin.h>
+#define BOOFCPP_SIMD_TARGET __attribute__((target("avx2")))
+#endif
 
 using namespace boofcv;
 
+#if BOOFCPP_SIMD_AVX2
+namespace {
+    /**
+     * Finds transitions 32 pixels at a time. Pixels equal to 1 are turned into a bit mask and compared against
+     * the mask shifted by one pixel, so each set bit marks the start or end of a run.
+     *
+     * @return Number of pixels processed
+     */
+    BOOFCPP_SIMD_TARGET uint32_t find_runs_avx2( const U8* row , uint32_t length , std::vector<uint32_t>& runs ,
+                                                 bool& inside ) {
+        const __m256i ones = _mm256_set1_epi8(1);
+        uint32_t x = 0;
+        for( ; x + 32 <= length; x += 32 ) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&row[x]));
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v,ones)));
+            if( mask == (inside ? 0xFFFFFFFFU : 0U) )
+                continue;
+            uint32_t changes = mask ^ ((mask << 1) | (inside ? 1U : 0U));
+            while( changes != 0 ) {
+                runs.push_back(x + static_cast<uint32_t>(__builtin_ctz(changes)));
+                changes &= changes - 1;
+            }
+            inside = (mask >> 31) != 0;
+        }
+        return x;
+    }
+}
+#endif
+
 /**
  * Specifies connectivity rule
  *
  * @param rule Specifies 4 or 8 as connectivity rule
  */
 ContourTracer::ContourTracer(ConnectRule rule) :
-        storagePoints(nullptr), binary(nullptr), labeled(nullptr) {
+        storagePoints(nullptr), binary(nullptr), labeled(nullptr), runs(nullptr) {
     this->rule = rule;
 
     if (ConnectRule::EIGHT == rule) {
@@ -52,6 +90,7 @@ ContourTracer::~ContourTracer() {
 void ContourTracer::set_inputs(Gray<U8> &binary, Gray<S32> &labeled, PackedSet<Point2D<S32>> &storagePoints) {
     this->binary = &binary;
     this->labeled = &labeled;
+    this->runs = nullptr;
     this->storagePoints = &storagePoints;
 
     if (rule == ConnectRule::EIGHT) {
@@ -63,6 +102,19 @@ void ContourTracer::set_inputs(Gray<U8> &binary, Gray<S32> &labeled, PackedSet<P
     }
 }
 
+void ContourTracer::set_inputs(Gray<U8> &binary, RowRuns &runs, PackedSet<Point2D<S32>> &storagePoints) {
+    this->binary = &binary;
+    this->labeled = nullptr;
+    this->runs = &runs;
+    this->storagePoints = &storagePoints;
+
+    if (rule == ConnectRule::EIGHT)
+        setOffsets8(offsetsBinary, binary.stride);
+    else
+        setOffsets4(offsetsBinary, binary.stride);
+    std::fill(offsetsLabeled, offsetsLabeled + ruleN, 0);
+}
+
 void ContourTracer::setOffsets8(int32_t *offsets, uint32_t stride) {
     int32_t s = stride;
     offsets[0] = 1;      // x =  1 y =  0
@@ -105,7 +157,7 @@ void ContourTracer::trace(int label, uint32_t initialX, uint32_t initialY, bool
     // index of pixels in the image array
     // binary has a 1 pixel border which labeled lacks, hence the -1,-1 for labeled
     indexBinary = binary->index_of(x, y);
-    indexLabel = labeled->index_of(x - 1, y - 1);
+    indexLabel = labeled != nullptr ? labeled->index_of(x - 1, y - 1) : 0;
     add(x, y);
 
     // find the next black pixel.  handle case where its an isolated point
@@ -206,7 +258,8 @@ bool ContourTracer::checkBlack(uint8_t &pixel) {
         return true;
     } else {
         // mark white pixels to avoid retracing this contour in the future
-        pixel = 255;
+        if( markWhite )
+            pixel = 255;
         return false;
     }
 }
@@ -225,7 +278,12 @@ void ContourTracer::moveToNext() {
  * Adds a point to the contour list
  */
 void ContourTracer::add(int x, int y) {
-    labeled->data[indexLabel] = label;
+    if (runs == nullptr) {
+        labeled->data[indexLabel] = label;
+    } else if (binary->data[indexBinary - 1] != 1) {
+        // only the first pixel in a run needs to be labeled since the rest of the run belongs to the same blob
+        runs->labels[runs->find(static_cast<uint32_t>(x), static_cast<uint32_t>(y))] = label;
+    }
     if (storagePoints->size_of_tail() < maxContourSize) {
         storagePoints->push_tail(Point2D<S32>(x - 1, y - 1));
     }
@@ -239,6 +297,26 @@ ConnectRule ContourTracer::getConnectRule() {
     return rule;
 }
 
+void RowRuns::process( const Gray<U8>& binary , const ConcurrencyContext& context ) {
+    bounds.resize(binary.height);
+    concurrent_rows(context,binary.height,[&](uint32_t y0, uint32_t y1){
+        for( uint32_t y = y0; y < y1; y++ ) {
+            std::vector<uint32_t>& row = bounds[y];
+            row.clear();
+            row.push_back(0);
+            LinearContourLabelChang2004::findRuns(&binary.data[binary.offset + y*binary.stride], binary.width, row);
+            row.push_back(binary.width);
+        }
+    });
+
+    offsets.resize(binary.height+1);
+    offsets[0] = 0;
+    for( uint32_t y = 0; y < binary.height; y++ ) {
+        offsets[y+1] = offsets[y] + static_cast<uint32_t>(bounds[y].size()) - 1;
+    }
+    labels.assign(offsets.back(),0);
+}
+
 ContourPacked::ContourPacked() :
         id(std::numeric_limits<uint32_t>::max()),
         externalIndex(std::numeric_limits<uint32_t>::max())
@@ -267,15 +345,40 @@ LinearContourLabelChang2004::LinearContourLabelChang2004( ConnectRule rule ) :
  * @param labeled Output. Labeled image.  Modified.
  */
 void LinearContourLabelChang2004::process( const Gray<U8>& binary , Gray<S32>& labeled ) {
-    // initialize data structures
-    labeled.reshape(binary.width,binary.height);
+    setupBorder(binary.width,binary.height).copy(binary);
+    labelBorder(labeled);
+}
+
+void LinearContourLabelChang2004::process( const Gray<U8>& binary , Gray<S32>& labeled ,
+                                           const ConcurrencyContext& context ) {
+    Gray<U8> inner = setupBorder(binary.width,binary.height);
+    concurrent_rows(context,binary.height,[&](uint32_t y0, uint32_t y1){
+        inner.makeSubimage(0,y0,inner.width,y1).copy(binary.makeSubimage(0,y0,binary.width,y1));
+    });
+    labelBorder(labeled,context);
+}
 
+void LinearContourLabelChang2004::processContours( const Gray<U8>& binary ) {
+    setupBorder(binary.width,binary.height).copy(binary);
+    traceBorder();
+}
+
+Gray<U8> LinearContourLabelChang2004::setupBorder( uint32_t width , uint32_t height ) {
     // ensure that the image border pixels are filled with zero by enlarging the image
-    if( border.width != binary.width+2 || border.height != binary.height+2)  {
-        border.reshape(binary.width + 2, binary.height + 2);
+    if( pool != nullptr ) {
+        // recycled pixels can have any value
+        border = pool->gray<U8>(width + 2, height + 2);
+        ImageMiscOps::fill_border(border, (U8)0, 1);
+    } else if( border.width != width+2 || border.height != height+2)  {
+        border.reshape(width + 2, height + 2);
         ImageMiscOps::fill_border(border, (U8)0, 1);
     }
-    border.makeSubimage(1,1,border.width-1,border.height-1).copy(binary);
+    return border.makeSubimage(1,1,border.width-1,border.height-1);
+}
+
+void LinearContourLabelChang2004::labelBorder( Gray<S32>& labeled ) {
+    // initialize data structures
+    labeled.reshape(border.width-2,border.height-2);
 
     // labeled image must initially be filled with zeros
     ImageMiscOps::fill(labeled,(S32)0);
@@ -290,33 +393,329 @@ void LinearContourLabelChang2004::process( const Gray<U8>& binary , Gray<S32>& l
     // Outside border is all zeros so it can be ignored
     uint32_t endY = border.height-1, enxX = border.width-1;
     for( y = 1; y < endY; y++ ) {
-        indexIn = border.offset + y*border.stride+1;
-        indexOut = labeled.offset + (y-1)*labeled.stride;
+        uint32_t rowIn = border.offset + y*border.stride;
+        // labeled lacks the border so x = 1 is its first column
+        uint32_t rowOut = labeled.offset + (y-1)*labeled.stride - 1;
+
+        if( useRuns ) {
+            runs.clear();
+            findRuns(&border.data[rowIn], border.width, runs);
+            for( size_t i = 0; i < runs.size(); i += 2 ) {
+                indexIn = rowIn + runs[i];
+                indexOut = rowOut + runs[i];
+                for( x = runs[i]; x < runs[i+1]; x++ , indexIn++ , indexOut++ ) {
+                    handlePixel(labeled);
+                }
+            }
+            continue;
+        }
 
+        indexIn = rowIn + 1;
+        indexOut = rowOut + 1;
         for( x = 1; x < enxX; x++ , indexIn++ , indexOut++) {
-            U8 bit = border.data[indexIn];
-
             // white pixels are ignored
-            if( bit != 1 )
+            if( border.data[indexIn] != 1 )
                 continue;
+            handlePixel(labeled);
+        }
+    }
+
+    if( pool != nullptr ) {
+        // hand the pixels back so that they can be used by something else
+        border = Gray<U8>();
+    }
+}
+
+void LinearContourLabelChang2004::handlePixel( Gray<S32>& labeled ) {
+    auto label = static_cast<uint32_t>(labeled.data[indexOut]);
+    bool handled = false;
+    if( label == 0 && border.data[indexIn - border.stride ] != 1 ) {
+        handleStep1();
+        handled = true;
+        label = static_cast<uint32_t>(contours.size());
+    }
+    // could be an external and internal contour
+    if( border.data[indexIn + border.stride ] == 0 ) {
+        handleStep2(labeled, label);
+        handled = true;
+    }
+    if( !handled ) {
+        handleStep3(labeled);
+    }
+}
+
+void LinearContourLabelChang2004::findRuns( const U8* row , uint32_t length , std::vector<uint32_t>& runs ) {
+    // tracing only ever modifies pixels which aren't 1, so the runs can be found before the row is scanned
+    bool inside = false;
+    uint32_t x = 0;
+#if BOOFCPP_SIMD_AVX2
+    if( CpuFeatures::avx2() ) {
+        x = find_runs_avx2(row, length, runs, inside);
+    }
+#endif
+    // skip 8 pixels at a time while nothing changes
+    const uint64_t ones = 0x0101010101010101ULL;
+    for( ; x + 8 <= length; x += 8 ) {
+        uint64_t word;
+        std::memcpy(&word, &row[x], sizeof(word));
+        if( word == (inside ? ones : 0) )
+            continue;
+        for( uint32_t i = 0; i < 8; i++ ) {
+            bool value = row[x+i] == 1;
+            if( value != inside ) {
+                runs.push_back(x+i);
+                inside = value;
+            }
+        }
+    }
+    for( ; x < length; x++ ) {
+        bool value = row[x] == 1;
+        if( value != inside ) {
+            runs.push_back(x);
+            inside = value;
+        }
+    }
+    if( inside )
+        runs.push_back(length);
+}
+
+void LinearContourLabelChang2004::traceBorder() {
+    packedPoints.clear();
+    contours.clear();
+
+    rowRuns.process(border,ConcurrencyContext());
 
-            auto label = static_cast<uint32_t>(labeled.data[indexOut]);
-            bool handled = false;
-            if( label == 0 && border.data[indexIn - border.stride ] != 1 ) {
-                handleStep1();
-                handled = true;
-                label = static_cast<uint32_t>(contours.size());
+    tracer = rule == ConnectRule::FOUR ? &tracer4 : &tracer8;
+    tracer->set_inputs(border,rowRuns,packedPoints);
+
+    // Every pixel in a run belongs to the same blob. The run is labeled when its first pixel is traced, which
+    // always happens before the scan reaches it, or it's the first pixel of a new blob.
+    uint32_t endY = border.height-1;
+    for( y = 1; y < endY; y++ ) {
+        const std::vector<uint32_t>& bounds = rowRuns.bounds[y];
+        uint32_t rowIn = border.offset + y*border.stride;
+        for( uint32_t j = 1; j + 1 < bounds.size(); j += 2 ) {
+            uint32_t run = rowRuns.offsets[y] + j;
+            indexIn = rowIn + bounds[j];
+            for( x = bounds[j]; x < bounds[j+1]; x++ , indexIn++ ) {
+                if( rowRuns.labels[run] == 0 && border.data[indexIn - border.stride] != 1 ) {
+                    handleStep1();
+                }
+                // could be an external and internal contour
+                if( border.data[indexIn + border.stride] == 0 ) {
+                    traceInternal(static_cast<uint32_t>(rowRuns.labels[run]));
+                }
             }
-            // could be an external and internal contour
-            if( border.data[indexIn + border.stride ] == 0 ) {
-                handleStep2(labeled, label);
-                handled = true;
+        }
+    }
+
+    if( pool != nullptr ) {
+        border = Gray<U8>();
+    }
+}
+
+void LinearContourLabelChang2004::labelBorder( Gray<S32>& labeled , const ConcurrencyContext& context ) {
+    const uint32_t W = border.width, H = border.height;
+    labeled.reshape(W-2,H-2);
+
+    packedPoints.clear();
+    contours.clear();
+
+    // Convert each row into runs
+    rowRuns.process(border,context);
+    seams.assign(H,0);
+    const std::vector<std::vector<uint32_t>>& rowBounds = rowRuns.bounds;
+    const std::vector<uint32_t>& rowOffsets = rowRuns.offsets;
+    std::vector<S32>& runLabels = rowRuns.labels;
+    const uint32_t totalRuns = rowRuns.totalRuns();
+    parents.resize(totalRuns);
+
+    // Connect runs inside each band. Bands only modify their own runs
+    const bool eight = rule == ConnectRule::EIGHT;
+    concurrent_rows(context,H,[&](uint32_t y0, uint32_t y1){
+        seams[y0] = 1;
+        for( uint32_t y = y0; y < y1; y++ ) {
+            for( uint32_t i = rowOffsets[y]; i < rowOffsets[y+1]; i++ ) {
+                parents[i] = i;
             }
-            if( !handled ) {
-                handleStep3(labeled);
+            if( y > y0 )
+                connectRows(y, eight);
+        }
+    });
+    for( uint32_t y = 1; y < H; y++ ) {
+        if( seams[y] )
+            connectRows(y, eight);
+    }
+
+    // Point every run at its root. A parent always has a smaller index so it's already been resolved
+    for( uint32_t i = 0; i < totalRuns; i++ ) {
+        parents[i] = parents[parents[i]];
+    }
+
+    // Roots are the first run in raster order of each set, which is where the sequential labeler finds them,
+    // so numbering them in order gives the same labels. The background set which touches the border has root 0.
+    blobSeeds.clear();
+    holeSeeds.clear();
+    for( uint32_t y = 0; y < H; y++ ) {
+        const std::vector<uint32_t>& bounds = rowBounds[y];
+        for( uint32_t j = 0, i = rowOffsets[y]; i < rowOffsets[y+1]; i++, j++ ) {
+            if( parents[i] != i )
+                continue;
+            if( j % 2 == 1 ) {
+                blobSeeds.push_back({bounds[j],y,static_cast<uint32_t>(blobSeeds.size()),true});
+                runLabels[i] = static_cast<S32>(blobSeeds.size());
+            } else if( i != 0 ) {
+                // hole. Its internal contour is found from the pixel above its first pixel
+                holeSeeds.push_back({bounds[j],y-1,0,false});
+            }
+        }
+    }
+
+    concurrent_rows(context,H-2,[&](uint32_t y0, uint32_t y1){
+        for( uint32_t y = y0+1; y < y1+1; y++ ) {
+            const std::vector<uint32_t>& bounds = rowBounds[y];
+            S32* out = &labeled.data[labeled.offset + (y-1)*labeled.stride];
+            for( uint32_t j = 0, i = rowOffsets[y]; i < rowOffsets[y+1]; i++, j++ ) {
+                S32 label = j % 2 == 1 ? runLabels[parents[i]] : 0;
+                uint32_t x0 = std::max(bounds[j],1U)-1;
+                uint32_t x1 = std::min(bounds[j+1],W-1)-1;
+                std::fill(out+x0,out+std::max(x0,x1),label);
             }
         }
+    });
+
+    // Group the contour seeds by blob. The external contour is first followed by internal contours in raster order
+    const auto numBlobs = static_cast<uint32_t>(blobSeeds.size());
+    blobEvents.assign(numBlobs+1,0);
+    for( ContourSeed& hole : holeSeeds ) {
+        hole.blob = static_cast<uint32_t>(labeled.unsafe_at(hole.x-1,hole.y-1)) - 1;
+        blobEvents[hole.blob+1]++;
+    }
+    for( uint32_t i = 0; i < numBlobs; i++ ) {
+        blobEvents[i+1] += blobEvents[i] + 1;
+    }
+    seeds.resize(numBlobs + holeSeeds.size());
+    for( uint32_t i = 0; i < numBlobs; i++ ) {
+        seeds[blobEvents[i]] = blobSeeds[i];
+    }
+    // the next free location for each blob. Reuses blobSeeds
+    for( uint32_t i = 0; i < numBlobs; i++ ) {
+        blobSeeds[i].x = blobEvents[i]+1;
     }
+    for( const ContourSeed& hole : holeSeeds ) {
+        seeds[blobSeeds[hole.blob].x++] = hole;
+    }
+
+    // Trace each blob's contours concurrently. Marking isn't needed since internal contours have already been found
+    std::mutex mutex;
+    uint32_t usedPoints = 0;
+    seedSets.resize(seeds.size());
+    concurrent_rows(context,numBlobs,[&](uint32_t b0, uint32_t b1){
+        PackedSet<Point2D<S32>>* points;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if( usedPoints == threadPoints.size() )
+                threadPoints.emplace_back(new PackedSet<Point2D<S32>>(2000));
+            points = threadPoints[usedPoints++].get();
+        }
+        points->clear();
+
+        ContourTracer tracer(rule);
+        tracer.markWhite = false;
+        tracer.set_inputs(border,labeled,*points);
+        for( uint32_t i = blobEvents[b0]; i < blobEvents[b1]; i++ ) {
+            const ContourSeed& seed = seeds[i];
+            uint32_t saveMax = seed.external || saveInternalContours ? maxContourSize : 0;
+            seedSets[i] = std::make_pair(points,points->number_of_sets());
+            traceContour(tracer,*points,saveMax,static_cast<int>(seed.blob+1),seed.x,seed.y,seed.external);
+        }
+    });
+
+    // Contours are found in raster order by the sequential labeler, with the external contour first
+    seedOrder.resize(seeds.size());
+    for( uint32_t i = 0; i < seedOrder.size(); i++ ) {
+        seedOrder[i] = i;
+    }
+    if( canonicalOrder ) {
+        std::sort(seedOrder.begin(),seedOrder.end(),[&](uint32_t a, uint32_t b){
+            const ContourSeed& sa = seeds[a];
+            const ContourSeed& sb = seeds[b];
+            if( sa.y != sb.y )
+                return sa.y < sb.y;
+            if( sa.x != sb.x )
+                return sa.x < sb.x;
+            return sa.external && !sb.external;
+        });
+    }
+
+    // Copy the contours into a single set of points
+    contours.resize(numBlobs);
+    for( uint32_t i = 0; i < numBlobs; i++ ) {
+        contours[i].reset();
+        contours[i].id = i+1;
+    }
+    for( uint32_t i : seedOrder ) {
+        const ContourSeed& seed = seeds[i];
+        uint32_t index = packedPoints.number_of_sets();
+        if( seed.external )
+            contours[seed.blob].externalIndex = index;
+        else
+            contours[seed.blob].internalIndexes.push_back(index);
+
+        packedPoints.start_new_set();
+        const PackedSet<Point2D<S32>>& src = *seedSets[i].first;
+        const PackedSetInfo& info = src.set_info[seedSets[i].second];
+        uint32_t location = info.block*src._size_of_block + info.offset;
+        for( uint32_t j = 0; j < info.size; j++, location++ ) {
+            packedPoints.push_tail(src.blocks[location/src._size_of_block][location%src._size_of_block]);
+        }
+    }
+
+    if( pool != nullptr ) {
+        border = Gray<U8>();
+    }
+}
+
+void LinearContourLabelChang2004::connectRows( uint32_t y , bool eight ) {
+    const std::vector<uint32_t>& above = rowRuns.bounds[y-1];
+    const std::vector<uint32_t>& below = rowRuns.bounds[y];
+    const uint32_t idAbove = rowRuns.offsets[y-1], idBelow = rowRuns.offsets[y];
+    const auto numAbove = static_cast<uint32_t>(above.size()) - 1;
+    const auto numBelow = static_cast<uint32_t>(below.size()) - 1;
+
+    uint32_t start = 0;
+    for( uint32_t k = 0; k < numBelow; k++ ) {
+        uint32_t x0 = below[k], x1 = below[k+1];
+        // foreground uses the rule and the background the opposite rule
+        bool diagonal = (k % 2 == 1) == eight;
+
+        // skip runs which end before this one could touch them. Later runs start even further to the right
+        while( start < numAbove && above[start+1] < x0 )
+            start++;
+        for( uint32_t j = start; j < numAbove && above[j] <= x1; j++ ) {
+            if( j % 2 != k % 2 )
+                continue;
+            if( diagonal || (above[j+1] > x0 && above[j] < x1) )
+                join(idAbove+j, idBelow+k);
+        }
+    }
+}
+
+uint32_t LinearContourLabelChang2004::findRoot( uint32_t i ) {
+    while( parents[i] != i ) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+void LinearContourLabelChang2004::join( uint32_t a , uint32_t b ) {
+    a = findRoot(a);
+    b = findRoot(b);
+    if( a < b )
+        parents[b] = a;
+    else if( b < a )
+        parents[a] = b;
 }
 
 /**
@@ -328,18 +727,10 @@ void LinearContourLabelChang2004::handleStep1() {
     contours.push_back(ContourPacked());
     ContourPacked &c = contours.back();
     c.id = static_cast<uint32_t>(contours.size());
-    tracer->setMaxContourSize(maxContourSize);
-    // save the set index for this contour and declare memory for it
+    // save the set index for this contour
     c.externalIndex = packedPoints.number_of_sets();
-    packedPoints.start_new_set();
     c.internalIndexes.clear();
-    tracer->trace(c.id,x,y,true);
-
-    // Keep track that this was a contour, but free up all the points used in defining it
-    if( packedPoints.size_of_tail() >= maxContourSize || packedPoints.size_of_tail() < minContourSize ) {
-        packedPoints.remove_tail();
-        packedPoints.start_new_set();
-    }
+    traceContour(*tracer,packedPoints,maxContourSize,c.id,x,y,true);
 }
 
 /**
@@ -350,17 +741,27 @@ void LinearContourLabelChang2004::handleStep2(Gray<S32>& labeled, uint32_t label
     // if the blob is not labeled and in this state it cannot be against the left side of the image
     if( label == 0 )
         label = static_cast<uint32_t>(labeled.data[indexOut-1]);
+    traceInternal(label);
+}
 
+void LinearContourLabelChang2004::traceInternal(uint32_t label) {
     ContourPacked& c = contours.at(label-1);
     c.internalIndexes.push_back( (uint32_t)packedPoints.set_info.size() );
-    packedPoints.start_new_set();
-    tracer->setMaxContourSize(saveInternalContours?maxContourSize:0);
-    tracer->trace(label,x,y,false);
+    traceContour(*tracer,packedPoints,saveInternalContours?maxContourSize:0,label,x,y,false);
+}
 
-    // See if the inner contour exceeded the maximum  or minimum size. If so free its points
-    if( packedPoints.size_of_tail() >= maxContourSize || packedPoints.size_of_tail() < minContourSize ) {
-        packedPoints.remove_tail();
-        packedPoints.start_new_set();
+void LinearContourLabelChang2004::traceContour( ContourTracer& tracer , PackedSet<Point2D<S32>>& points ,
+                                                uint32_t saveMax , int label , uint32_t x , uint32_t y ,
+                                                bool external ) {
+    points.start_new_set();
+    tracer.setMaxContourSize(saveMax);
+    tracer.trace(label,x,y,external);
+
+    // Keep track that this was a contour, but free up all the points used in defining it if it exceeded the
+    // maximum or minimum size
+    if( points.size_of_tail() >= maxContourSize || points.size_of_tail() < minContourSize ) {
+        points.remove_tail();
+        points.start_new_set();
     }
 }
 
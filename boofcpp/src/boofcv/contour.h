@@ -1,12 +1,17 @@
 #ifndef BOOFCPP_CONTOUR_H
 #define BOOFCPP_CONTOUR_H
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
+#include <vector>
 #include "image_types.h"
 #include "base_types.h"
 #include "packed_sets.h"
 #include "geometry_types.h"
 #include "image_misc_ops.h"
+#include "binary_ops.h"
+#include "concurrency.h"
 
 namespace boofcv {
 
@@ -17,6 +22,36 @@ namespace boofcv {
         FOUR,EIGHT
     };
 
+    /**
+     * Horizontal runs in each row of a zero bordered binary image. Every row starts and ends with a background run
+     * and the runs alternate between background and foreground, so runs with an odd index are foreground. Each
+     * run can be assigned a label, which lets blobs be tracked without a labeled image.
+     */
+    struct RowRuns {
+        // boundaries between the runs in each row. Run j is from bounds[y][j] to bounds[y][j+1]
+        std::vector<std::vector<uint32_t>> bounds;
+        // index of the first run in each row. The last element is the total number of runs
+        std::vector<uint32_t> offsets;
+        // label of each run. 0 if it hasn't been assigned
+        std::vector<S32> labels;
+
+        /**
+         * Finds the runs in every row of the binary image and sets all the labels to 0
+         */
+        void process( const Gray<U8>& binary , const ConcurrencyContext& context );
+
+        // Index of the run in row 'y' which contains pixel 'x'
+        uint32_t find( uint32_t x , uint32_t y ) const {
+            const std::vector<uint32_t>& row = bounds[y];
+            auto j = static_cast<uint32_t>(std::upper_bound(row.begin(),row.end(),x) - row.begin()) - 1;
+            return offsets[y] + j;
+        }
+
+        uint32_t totalRuns() const {
+            return offsets.back();
+        }
+    };
+
     /**
      * Used to trace the external and internal contours around objects for {@link LinearContourLabelChang2004}.  As it
      * is tracing an object it will modify the binary image by labeling.  The input binary image is assumed to have
@@ -30,6 +65,10 @@ namespace boofcv {
         // Stops saving the contour when it meets or exceeds this value
         uint32_t maxContourSize = std::numeric_limits<uint32_t>::max();
 
+        // If true then pixels which aren't 1 are marked with 255 as they are searched. Only needed when the
+        // marks are used to find internal contours, see LinearContourLabelChang2004.
+        bool markWhite = true;
+
         // which connectivity rule is being used. 4 and 8 supported
         ConnectRule rule;
         uint32_t ruleN;
@@ -41,6 +80,9 @@ namespace boofcv {
         Gray<U8>* binary;
         // label image being marked
         Gray<S32>* labeled;
+        // If not null then contour pixels aren't labeled in 'labeled'. Instead the label is saved in the run
+        // which each contour pixel starts.
+        RowRuns* runs;
 
         // coordinate of pixel being examined (x,y)
         uint32_t x,y;
@@ -75,6 +117,13 @@ namespace boofcv {
          */
         void set_inputs( Gray<U8>& binary , Gray<S32>& labeled , PackedSet<Point2D<S32>>& storagePoints );
 
+        /**
+         * Same as the other set_inputs but labels are saved in the runs instead of a labeled image
+         *
+         * @param runs Runs in 'binary'
+         */
+        void set_inputs( Gray<U8>& binary , RowRuns& runs , PackedSet<Point2D<S32>>& storagePoints );
+
         void setOffsets8( int32_t *offsets , uint32_t stride );
 
         void setOffsets4( int32_t *offsets , uint32_t stride );
@@ -143,6 +192,19 @@ namespace boofcv {
         void reset();
     };
 
+    /**
+     * Location where the concurrent version of {@link LinearContourLabelChang2004} starts tracing a contour. This
+     * is the same pixel the sequential version starts tracing it at.
+     */
+    struct ContourSeed {
+        // pixel coordinate in the zero bordered binary image
+        uint32_t x,y;
+        // index of the blob the contour belongs to
+        uint32_t blob;
+        // true for an external contour and false for an internal contour
+        bool external;
+    };
+
     /**
      * <p>
      * Finds objects in a binary image by tracing their contours.  The output is labeled binary image, set of external
@@ -193,6 +255,17 @@ namespace boofcv {
 
         // binary image with a border of zero.
         Gray<U8> border;
+        // If not null then 'border' is taken from this pool for each image and handed back once it's labeled
+        ImagePool* pool = nullptr;
+        // If true each row is first converted into runs of foreground pixels and only the runs are scanned.
+        // Output is identical. Faster for sparse images since background pixels are skipped in bulk.
+        bool useRuns = false;
+        // start (inclusive) and end (exclusive) of each run in the row being scanned, stored in pairs
+        std::vector<uint32_t> runs;
+        // If true then the concurrent labeler stores contours in packedPoints in the same order as the sequential
+        // labeler. Otherwise each blob's external contour is followed by its internal contours. Labels are always
+        // the same as the sequential labeler's.
+        bool canonicalOrder = false;
 
         // predeclared/recycled data structures
         PackedSet<Point2D<S32>> packedPoints;
@@ -201,6 +274,22 @@ namespace boofcv {
         // internal book keeping variables
         uint32_t x,y,indexIn,indexOut;
 
+        // runs in 'border'. Used by the concurrent labeler and when only contours are found
+        RowRuns rowRuns;
+
+        // work space for the concurrent labeler
+        // union-find forest of runs. A root always has the smallest index in its tree
+        std::vector<uint32_t> parents;
+        // set to 1 if a row is the first row in a band and needs to be joined to the row above
+        std::vector<uint8_t> seams;
+        std::vector<ContourSeed> blobSeeds, holeSeeds, seeds;
+        // index in 'seeds' of each blob's external contour
+        std::vector<uint32_t> blobEvents;
+        // where each traced contour was saved
+        std::vector<std::pair<PackedSet<Point2D<S32>>*,uint32_t>> seedSets;
+        std::vector<uint32_t> seedOrder;
+        std::vector<std::unique_ptr<PackedSet<Point2D<S32>>>> threadPoints;
+
         /**
          * Configures the algorithm.
          *
@@ -216,6 +305,77 @@ namespace boofcv {
          */
         void process( const Gray<U8>& binary , Gray<S32>& labeled );
 
+        /**
+         * Thresholds the input image directly into the internal zero bordered binary image and then labels it.
+         * Produces the same output as thresholding into a binary image and passing it to {@link #process} but
+         * without writing then copying a full size binary image.
+         *
+         * @param input Input gray scale image. Not modified.
+         * @param thresholder Converts the input image into a binary image.
+         * @param labeled Output. Labeled image.  Modified.
+         */
+        template<class T>
+        void process( const Gray<T>& input , InputToBinary<Gray<T>>& thresholder , Gray<S32>& labeled ) {
+            Gray<U8> inner = setupBorder(input.width, input.height);
+            thresholder.process(input, inner);
+            labelBorder(labeled);
+        }
+
+        /**
+         * Same as {@link #process} but the image is labeled concurrently. Bands of rows are converted into runs and
+         * connected with union-find, the bands are merged along their seams, then the contours of each blob are
+         * traced concurrently. Labels and contours are the same as the sequential version. See
+         * {@link #canonicalOrder} for the order contours are stored in.
+         *
+         * @param binary Input binary image. Not modified.
+         * @param labeled Output. Labeled image.  Modified.
+         */
+        void process( const Gray<U8>& binary , Gray<S32>& labeled , const ConcurrencyContext& context );
+
+        /**
+         * Finds the contours of blobs without creating a labeled image. Blobs are tracked with a label for each
+         * run of foreground pixels, which is much less memory traffic than writing a label for every pixel.
+         * 'contours' and 'packedPoints' are the same as {@link #process}.
+         *
+         * @param binary Input binary image. Not modified.
+         */
+        void processContours( const Gray<U8>& binary );
+
+        /**
+         * Resizes the zero bordered binary image and returns a subimage of its inside. The binary image
+         * which is to be labeled should be written into the subimage.
+         */
+        Gray<U8> setupBorder( uint32_t width , uint32_t height );
+
+        /**
+         * Labels the binary image which has already been written inside of 'border'.
+         *
+         * @param labeled Output. Labeled image.  Modified.
+         */
+        void labelBorder( Gray<S32>& labeled );
+
+        /**
+         * Finds the contours in the binary image which has already been written inside of 'border' without
+         * creating a labeled image. See {@link #processContours}.
+         */
+        void traceBorder();
+
+        /**
+         * Concurrent version of {@link #labelBorder}. 'border' isn't modified.
+         */
+        void labelBorder( Gray<S32>& labeled , const ConcurrencyContext& context );
+
+        /**
+         * Finds runs of pixels with a value of 1 in a row. The start (inclusive) and end (exclusive) of each run
+         * are appended to 'runs'. All zero and all one sections of the row are skipped many pixels at a time.
+         */
+        static void findRuns( const U8* row , uint32_t length , std::vector<uint32_t>& runs );
+
+        /**
+         * Applies steps 1 to 3 to the foreground pixel at (x,y)
+         */
+        void handlePixel(Gray<S32>& labeled);
+
         /**
          *  Step 1: If the pixel is unlabeled and the pixel above is white, then it
          *          must be an external contour of a newly encountered blob.
@@ -228,12 +388,35 @@ namespace boofcv {
          */
         void handleStep2(Gray<S32>& labeled, uint32_t label);
 
+        /**
+         * Traces the internal contour below the current pixel, which belongs to blob 'label'
+         */
+        void traceInternal(uint32_t label);
+
         /**
          * Step 3: Must not be part of the contour but an inner pixel and the pixel to the left must be
          *         labeled
          */
         void handleStep3(Gray<S32>& labeled);
 
+        /**
+         * Traces a contour into a new set. If the contour is too large or too small its points are discarded
+         * and the set is left empty.
+         *
+         * @param saveMax Maximum number of points which are saved
+         */
+        void traceContour( ContourTracer& tracer , PackedSet<Point2D<S32>>& points , uint32_t saveMax ,
+                           int label , uint32_t x , uint32_t y , bool external );
+
+        /**
+         * Joins runs in row 'y' of 'border' to the runs they touch in the row above
+         */
+        void connectRows( uint32_t y , bool eight );
+
+        // union-find operations on 'parents'
+        uint32_t findRoot( uint32_t i );
+        void join( uint32_t a , uint32_t b );
+
         void setConnectRule( ConnectRule rule );
 
         ConnectRule getConnectRule();
@@ -2,6 +2,7 @@
 #define BOOFCPP_CONVOLVE_H
 
 #include <cstdint>
+#include <algorithm>
 #include <stdexcept>
 #include <cstring>
 #include <initializer_list>
@@ -12,6 +13,9 @@
 #include "sanity_checks.h"
 #include "image_border.h"
 #include "convolve_kernels.h"
+#include "convolve_simd.h"
+#include "concurrency.h"
+#include "image_pool.h"
 
 namespace boofcv {
     /**
@@ -456,15 +460,27 @@ namespace boofcv {
         static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
                               const Gray<E>& input, Gray<E>& output ,
                               typename std::enable_if<std::is_integral<E>::value >::type* = 0 )
+        {
+            vertical(kernel,input,output,0,input.height);
+        }
+
+        /**
+         * Only processes the border in rows y0 (inclusive) to y1 (exclusive)
+         */
+        template<class E>
+        static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                              const Gray<E>& input, Gray<E>& output , uint32_t y0 , uint32_t y1 ,
+                              typename std::enable_if<std::is_integral<E>::value >::type* = 0 )
         {
             typedef typename TypeInfo<E>::signed_type signed_type;
 
             uint32_t offsetL = kernel.offset;
             uint32_t offsetR = kernel.width-offsetL-1;
 
-            uint32_t yEnd = input.height - offsetR;
+            uint32_t yStart = std::max(y0,input.height - offsetR);
+            uint32_t topEnd = std::min(y1,offsetL);
 
-            for (uint32_t y = 0; y < offsetL; y++) {
+            for (uint32_t y = y0; y < topEnd; y++) {
                 uint32_t indexDst = output.offset + y * output.stride;
                 uint32_t i = input.offset + y * input.stride;
                 uint32_t iEnd = i + input.width;
@@ -486,7 +502,7 @@ namespace boofcv {
                 }
             }
 
-            for (uint32_t y = yEnd; y < input.height; y++) {
+            for (uint32_t y = yStart; y < y1; y++) {
                 uint32_t indexDst = output.offset + y * output.stride;
                 uint32_t i = input.offset + y * input.stride;
                 uint32_t iEnd = i + input.width;
@@ -513,15 +529,27 @@ namespace boofcv {
         static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
                               const Gray<E>& input, Gray<E>& output ,
                               typename std::enable_if<std::is_floating_point<E>::value >::type* = 0 )
+        {
+            vertical(kernel,input,output,0,input.height);
+        }
+
+        /**
+         * Only processes the border in rows y0 (inclusive) to y1 (exclusive)
+         */
+        template<class E>
+        static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                              const Gray<E>& input, Gray<E>& output , uint32_t y0 , uint32_t y1 ,
+                              typename std::enable_if<std::is_floating_point<E>::value >::type* = 0 )
         {
             typedef typename TypeInfo<E>::signed_type signed_type;
 
             uint32_t offsetL = kernel.offset;
             uint32_t offsetR = kernel.width-offsetL-1;
 
-            uint32_t yEnd = input.height - offsetR;
+            uint32_t yStart = std::max(y0,input.height - offsetR);
+            uint32_t topEnd = std::min(y1,offsetL);
 
-            for (uint32_t y = 0; y < offsetL; y++) {
+            for (uint32_t y = y0; y < topEnd; y++) {
                 uint32_t indexDst = output.offset + y * output.stride;
                 uint32_t i = input.offset + y * input.stride;
                 uint32_t iEnd = i + input.width;
@@ -543,7 +571,7 @@ namespace boofcv {
                 }
             }
 
-            for (uint32_t y = yEnd; y < input.height; y++) {
+            for (uint32_t y = yStart; y < y1; y++) {
                 uint32_t indexDst = output.offset + y * output.stride;
                 uint32_t i = input.offset + y * input.stride;
                 uint32_t iEnd = i + input.width;
@@ -581,13 +609,16 @@ namespace boofcv {
                                          const Gray<E>& input, Gray<E>& output ,
                                          typename TypeInfo<E>::signed_type divisor)
         {
+            if( ConvolveImage_SIMD::horizontal(kernel,input,output,divisor) )
+                return;
+
             switch( kernel.width ) {
-                case 3:horizontal(kernel,input,output,divisor);return;
-                case 5:horizontal(kernel,input,output,divisor);return;
-                case 7:horizontal(kernel,input,output,divisor);return;
-                case 9:horizontal(kernel,input,output,divisor);return;
-                case 11:horizontal(kernel,input,output,divisor);return;
-                case 13:horizontal(kernel,input,output,divisor);return;
+                case 3:horizontal_fixed<3>(kernel,input,output,divisor);return;
+                case 5:horizontal_fixed<5>(kernel,input,output,divisor);return;
+                case 7:horizontal_fixed<7>(kernel,input,output,divisor);return;
+                case 9:horizontal_fixed<9>(kernel,input,output,divisor);return;
+                case 11:horizontal_fixed<11>(kernel,input,output,divisor);return;
+                case 13:horizontal_fixed<13>(kernel,input,output,divisor);return;
             }
             horizontal(kernel,input,output,divisor);
         }
@@ -647,17 +678,79 @@ namespace boofcv {
             }
         }
 
+        /**
+         * Same as {@link #horizontal} but the kernel's width is a compile time constant. The compiler can then fully
+         * unroll the inner loop and keep the kernel's weights in registers.
+         */
+        template<uint32_t W, class E>
+        static void horizontal_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                      const Gray<E>& input, Gray<E>& output ,
+                                      typename TypeInfo<E>::signed_type divisor ,
+                                      typename std::enable_if<std::is_integral<E>::value >::type* = 0 )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            signed_type halfDivisor = divisor/2;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            for( uint32_t i = 0; i < input.height; i++ ) {
+                E* output_ptr = &output.data[output.offset + i*output.stride + kernel.offset];
+                const E* input_ptr = &input.data[input.offset + i*input.stride];
+                const E* input_end_ptr = &input_ptr[input.width-(W-1)];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k] * weights[k];
+                    }
+                    *output_ptr++ = static_cast<E>((total+halfDivisor)/divisor);
+                }
+            }
+        }
+
+        template<uint32_t W, class E>
+        static void horizontal_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                      const Gray<E>& input, Gray<E>& output ,
+                                      typename TypeInfo<E>::signed_type divisor ,
+                                      typename std::enable_if<std::is_floating_point<E>::value >::type* = 0 )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            for( uint32_t i = 0; i < input.height; i++ ) {
+                E* output_ptr = &output.data[output.offset + i*output.stride + kernel.offset];
+                const E* input_ptr = &input.data[input.offset + i*input.stride];
+                const E* input_end_ptr = &input_ptr[input.width-(W-1)];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k] * weights[k];
+                    }
+                    *output_ptr++ = (E)(total/divisor);
+                }
+            }
+        }
+
         template<typename E, typename R>
         static void horizontal_unrolled( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
                                          const Gray<E>& input, Gray<R>& output )
         {
+            if( ConvolveImage_SIMD::horizontal(kernel,input,output) )
+                return;
+
             switch( kernel.width ) {
-                case 3:horizontal(kernel,input,output);return;
-                case 5:horizontal(kernel,input,output);return;
-                case 7:horizontal(kernel,input,output);return;
-                case 9:horizontal(kernel,input,output);return;
-                case 11:horizontal(kernel,input,output);return;
-                case 13:horizontal(kernel,input,output);return;
+                case 3:horizontal_fixed<3>(kernel,input,output);return;
+                case 5:horizontal_fixed<5>(kernel,input,output);return;
+                case 7:horizontal_fixed<7>(kernel,input,output);return;
+                case 9:horizontal_fixed<9>(kernel,input,output);return;
+                case 11:horizontal_fixed<11>(kernel,input,output);return;
+                case 13:horizontal_fixed<13>(kernel,input,output);return;
             }
             horizontal(kernel,input,output);
         }
@@ -688,18 +781,50 @@ namespace boofcv {
             }
         }
 
+        /**
+         * Same as {@link #horizontal} but the kernel's width is a compile time constant. The compiler can then fully
+         * unroll the inner loop and keep the kernel's weights in registers.
+         */
+        template<uint32_t W, typename E, typename R>
+        static void horizontal_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                      const Gray<E>& input, Gray<R>& output )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            for( uint32_t i = 0; i < input.height; i++ ) {
+                R* output_ptr = &output.data[output.offset + i*output.stride + kernel.offset];
+                const E* input_ptr = &input.data[input.offset + i*input.stride];
+                const E* input_end_ptr = &input_ptr[input.width-(W-1)];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k] * weights[k];
+                    }
+                    *output_ptr++ = static_cast<R>(total);
+                }
+            }
+        }
+
         template<typename E>
         static void vertical_unrolled( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
                                        const Gray<E>& input, Gray<E>& output ,
                                        typename TypeInfo<E>::signed_type divisor )
         {
+            if( ConvolveImage_SIMD::vertical(kernel,input,output,divisor) )
+                return;
+
             switch( kernel.width ) {
-                case 3:vertical(kernel,input,output,divisor);return;
-                case 5:vertical(kernel,input,output,divisor);return;
-                case 7:vertical(kernel,input,output,divisor);return;
-                case 9:vertical(kernel,input,output,divisor);return;
-                case 11:vertical(kernel,input,output,divisor);return;
-                case 13:vertical(kernel,input,output,divisor);return;
+                case 3:vertical_fixed<3>(kernel,input,output,divisor);return;
+                case 5:vertical_fixed<5>(kernel,input,output,divisor);return;
+                case 7:vertical_fixed<7>(kernel,input,output,divisor);return;
+                case 9:vertical_fixed<9>(kernel,input,output,divisor);return;
+                case 11:vertical_fixed<11>(kernel,input,output,divisor);return;
+                case 13:vertical_fixed<13>(kernel,input,output,divisor);return;
             }
             vertical(kernel,input,output,divisor);
         }
@@ -765,17 +890,85 @@ namespace boofcv {
             }
         }
 
+        /**
+         * Same as {@link #vertical} but the kernel's width is a compile time constant. The compiler can then fully
+         * unroll the inner loop and keep the kernel's weights in registers.
+         */
+        template<uint32_t W, class E>
+        static void vertical_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                    const Gray<E>& input, Gray<E>& output ,
+                                    typename TypeInfo<E>::signed_type divisor ,
+                                    typename std::enable_if<std::is_integral<E>::value >::type* = 0 )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            signed_type halfDivisor = divisor/2;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            const uint32_t stride = input.stride;
+            int32_t yEnd = input.height-(W-kernel.offset-1);
+
+            for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+                E* output_ptr = &output.data[output.offset+y*output.stride];
+                const E* input_ptr = &input.data[input.offset + (y-kernel.offset)*stride];
+                const E* input_end_ptr = &input_ptr[input.width];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k*stride] * weights[k];
+                    }
+                    *output_ptr++ = static_cast<E>((total+halfDivisor)/divisor);
+                }
+            }
+        }
+
+        template<uint32_t W, class E>
+        static void vertical_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                    const Gray<E>& input, Gray<E>& output ,
+                                    typename TypeInfo<E>::signed_type divisor ,
+                                    typename std::enable_if<std::is_floating_point<E>::value >::type* = 0 )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            const uint32_t stride = input.stride;
+            int32_t yEnd = input.height-(W-kernel.offset-1);
+
+            for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+                E* output_ptr = &output.data[output.offset+y*output.stride];
+                const E* input_ptr = &input.data[input.offset + (y-kernel.offset)*stride];
+                const E* input_end_ptr = &input_ptr[input.width];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k*stride] * weights[k];
+                    }
+                    *output_ptr++ = (E)(total/divisor);
+                }
+            }
+        }
+
         template<typename E, typename R>
         static void vertical_unrolled( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
                                        const Gray<E>& input, Gray<R>& output )
         {
+            if( ConvolveImage_SIMD::vertical(kernel,input,output) )
+                return;
+
             switch( kernel.width ) {
-                case 3:vertical(kernel,input,output);return;
-                case 5:vertical(kernel,input,output);return;
-                case 7:vertical(kernel,input,output);return;
-                case 9:vertical(kernel,input,output);return;
-                case 11:vertical(kernel,input,output);return;
-                case 13:vertical(kernel,input,output);return;
+                case 3:vertical_fixed<3>(kernel,input,output);return;
+                case 5:vertical_fixed<5>(kernel,input,output);return;
+                case 7:vertical_fixed<7>(kernel,input,output);return;
+                case 9:vertical_fixed<9>(kernel,input,output);return;
+                case 11:vertical_fixed<11>(kernel,input,output);return;
+                case 13:vertical_fixed<13>(kernel,input,output);return;
             }
             vertical(kernel,input,output);
         }
@@ -810,6 +1003,38 @@ namespace boofcv {
             }
         }
 
+        /**
+         * Same as {@link #vertical} but the kernel's width is a compile time constant. The compiler can then fully
+         * unroll the inner loop and keep the kernel's weights in registers.
+         */
+        template<uint32_t W, typename E, typename R>
+        static void vertical_fixed( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                    const Gray<E>& input, Gray<R>& output )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            signed_type weights[W];
+            for( uint32_t k = 0; k < W; k++ )
+                weights[k] = kernel.data.data[k];
+
+            const uint32_t stride = input.stride;
+            int32_t yEnd = input.height-(W-kernel.offset-1);
+
+            for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+                R* output_ptr = &output.data[output.offset+y*output.stride];
+                const E* input_ptr = &input.data[input.offset + (y-kernel.offset)*stride];
+                const E* input_end_ptr = &input_ptr[input.width];
+
+                for( ; input_ptr != input_end_ptr; input_ptr++ ) {
+                    signed_type total = 0;
+                    for( uint32_t k = 0; k < W; k++ ) {
+                        total += input_ptr[k*stride] * weights[k];
+                    }
+                    *output_ptr++ = static_cast<R>(total);
+                }
+            }
+        }
+
         template<class E>
         static void convolve( const Kernel2D<typename TypeInfo<E>::signed_type>& kernel ,
                               const Gray<E>& input, Gray<E>& output ,
@@ -904,6 +1129,16 @@ namespace boofcv {
         template<class E, class R>
         static void horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
                                 const ImageBorder<E>& input, Gray<R>& output )
+        {
+            horizontal(kernel,input,output,0,output.height);
+        }
+
+        /**
+         * Only processes the border in rows y0 (inclusive) to y1 (exclusive)
+         */
+        template<class E, class R>
+        static void horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                const ImageBorder<E>& input, Gray<R>& output , uint32_t y0 , uint32_t y1 )
         {
             typedef typename TypeInfo<E>::signed_type signed_type;
             typedef typename TypeInfo<E>::sum_type sum_type;
@@ -911,7 +1146,7 @@ namespace boofcv {
             int32_t offset = kernel.offset;
             int32_t borderRight = kernel.width-offset-1;
 
-            for (uint32_t y = 0; y < output.height; y++)
+            for (uint32_t y = y0; y < y1; y++)
             {
                 R* output_ptr = &output.data[output.offset + y * output.stride];
                 for ( int32_t x = 0; x < offset; x++ ) {
@@ -940,16 +1175,28 @@ namespace boofcv {
         template<class E, class R>
         static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
                               const ImageBorder<E>& input, Gray<R>& output )
+        {
+            vertical(kernel,input,output,0,output.height);
+        }
+
+        /**
+         * Only processes the border in rows y0 (inclusive) to y1 (exclusive)
+         */
+        template<class E, class R>
+        static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                              const ImageBorder<E>& input, Gray<R>& output , uint32_t y0 , uint32_t y1 )
         {
             typedef typename TypeInfo<E>::signed_type signed_type;
             typedef typename TypeInfo<E>::sum_type sum_type;
 
             int32_t borderBottom = kernel.width-kernel.offset-1;
+            uint32_t topEnd = std::min(y1,(uint32_t)kernel.offset);
+            int32_t bottomStart = std::max((int32_t)y0,(int32_t)output.height-borderBottom);
 
             for ( uint32_t x = 0; x < output.width; x++ ) {
-                uint32_t indexDest = output.offset + x;
+                uint32_t indexDest = output.offset + y0*output.stride + x;
 
-                for (uint32_t y = 0; y < kernel.offset; y++, indexDest += output.stride) {
+                for (uint32_t y = y0; y < topEnd; y++, indexDest += output.stride) {
                     signed_type total = 0;
                     signed_type *kernel_ptr = kernel.data.data;
                     for (uint32_t k = 0; k < kernel.width; k++) {
@@ -958,8 +1205,8 @@ namespace boofcv {
                     output.data[indexDest] = static_cast<R>(total);
                 }
 
-                indexDest = output.offset + (output.height-borderBottom) * output.stride + x;
-                for (int32_t y = output.height-borderBottom; y < output.height; y++, indexDest += output.stride) {
+                indexDest = output.offset + bottomStart * output.stride + x;
+                for (int32_t y = bottomStart; y < (int32_t)y1; y++, indexDest += output.stride) {
                     signed_type total = 0;
                     signed_type *kernel_ptr = kernel.data.data;
                     for (uint32_t k = 0; k < kernel.width; k++ ) {
@@ -973,6 +1220,16 @@ namespace boofcv {
         template<class E, class R>
         static void convolve( const Kernel2D<typename TypeInfo<E>::signed_type>& kernel ,
                               const ImageBorder<E>& input, Gray<R>& output )
+        {
+            convolve(kernel,input,output,0,output.height);
+        }
+
+        /**
+         * Only processes the border in rows y0 (inclusive) to y1 (exclusive)
+         */
+        template<class E, class R>
+        static void convolve( const Kernel2D<typename TypeInfo<E>::signed_type>& kernel ,
+                              const ImageBorder<E>& input, Gray<R>& output , uint32_t y0 , uint32_t y1 )
         {
             typedef typename TypeInfo<E>::signed_type signed_type;
             typedef typename TypeInfo<E>::sum_type sum_type;
@@ -980,9 +1237,11 @@ namespace boofcv {
             // signed so that logic of inner loops isn't messed up
             int32_t offsetL = kernel.offset;
             int32_t offsetR = kernel.width-offsetL-1;
+            int32_t topEnd = std::min((int32_t)y1,offsetL);
+            int32_t bottomStart = std::max((int32_t)y0,(int32_t)output.height-offsetR);
 
             // convolve along the left and right borders
-            for (uint32_t y = 0; y < output.height; y++) {
+            for (uint32_t y = y0; y < y1; y++) {
                 uint32_t indexDest = output.offset + y * output.stride;
 
                 for ( int32_t x = 0; x < offsetL; x++ ) {
@@ -1011,9 +1270,9 @@ namespace boofcv {
 
             // convolve along the top and bottom borders
             for ( uint32_t x = offsetL; x < output.width-offsetR; x++ ) {
-                uint32_t indexDest = output.offset + x;
+                uint32_t indexDest = output.offset + y0*output.stride + x;
 
-                for (int32_t y = 0; y < offsetL; y++, indexDest += output.stride) {
+                for (int32_t y = y0; y < topEnd; y++, indexDest += output.stride) {
                     signed_type total = 0;
                     signed_type *kernel_ptr = kernel.data.data;
                     for( int32_t i = -offsetL; i <= offsetR; i++ ) {
@@ -1024,8 +1283,8 @@ namespace boofcv {
                     output.data[indexDest] = static_cast<R>(total);
                 }
 
-                indexDest = output.offset + (output.height-offsetR) * output.stride + x;
-                for (int32_t y = output.height-offsetR; y < output.height; y++, indexDest += output.stride) {
+                indexDest = output.offset + bottomStart * output.stride + x;
+                for (int32_t y = bottomStart; y < (int32_t)y1; y++, indexDest += output.stride) {
                     signed_type total = 0;
                     signed_type *kernel_ptr = kernel.data.data;
                     for( int32_t i = -offsetL; i <= offsetR; i++ ) {
@@ -1085,6 +1344,154 @@ namespace boofcv {
                 ConvolveImage_Border::convolve(kernel, input, output);
             }
         };
+
+        /**
+         * Same as {@link #horizontal} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template<class E, class R>
+        static void horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                const ImageBorder<E>& input, Gray<R>& output , const ConcurrencyContext& context )
+        {
+            output.reshape(input.getWidth(),input.getHeight());
+
+            if( kernel.width >= output.width ) {
+                ConvolveNaive::horizontal(kernel, input, output);
+                return;
+            }
+
+            const Gray<E>& image = *input.image;
+            concurrent_rows(context,output.height,[&](uint32_t y0, uint32_t y1){
+                Gray<E> input_band = image.makeSubimage(0,y0,image.width,y1);
+                Gray<R> output_band = output.makeSubimage(0,y0,output.width,y1);
+                ConvolveImage_Inner::horizontal_unrolled(kernel, input_band, output_band);
+                ConvolveImage_Border::horizontal(kernel, input, output, y0, y1);
+            });
+        }
+
+        /**
+         * Same as {@link #vertical} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template<class E, class R>
+        static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                              const ImageBorder<E>& input, Gray<R>& output , const ConcurrencyContext& context )
+        {
+            output.reshape(input.getWidth(),input.getHeight());
+
+            if( kernel.width >= output.height ) {
+                ConvolveNaive::vertical(kernel, input, output);
+                return;
+            }
+
+            const Gray<E>& image = *input.image;
+            uint32_t above = kernel.offset;
+            uint32_t below = kernel.width-kernel.offset-1;
+
+            concurrent_rows(context,output.height,[&](uint32_t y0, uint32_t y1){
+                // inner rows in the band plus the rows above and below which the kernel reads
+                uint32_t inner0 = std::max(y0,above);
+                uint32_t inner1 = std::min(y1,output.height-below);
+                if( inner0 < inner1 ) {
+                    Gray<E> input_band = image.makeSubimage(0,inner0-above,image.width,inner1+below);
+                    Gray<R> output_band = output.makeSubimage(0,inner0-above,output.width,inner1+below);
+                    ConvolveImage_Inner::vertical_unrolled(kernel, input_band, output_band);
+                }
+                ConvolveImage_Border::vertical(kernel, input, output, y0, y1);
+            });
+        }
+
+        /**
+         * Same as {@link #convolve} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template<class E, class R>
+        static void convolve( const Kernel2D<typename TypeInfo<E>::signed_type>& kernel ,
+                              const ImageBorder<E>& input, Gray<R>& output , const ConcurrencyContext& context )
+        {
+            output.reshape(input.getWidth(),input.getHeight());
+
+            if( kernel.width >= output.width || kernel.width >= output.height ) {
+                ConvolveNaive::convolve(kernel, input, output);
+                return;
+            }
+
+            const Gray<E>& image = *input.image;
+            uint32_t above = kernel.offset;
+            uint32_t below = kernel.width-kernel.offset-1;
+
+            concurrent_rows(context,output.height,[&](uint32_t y0, uint32_t y1){
+                uint32_t inner0 = std::max(y0,above);
+                uint32_t inner1 = std::min(y1,output.height-below);
+                if( inner0 < inner1 ) {
+                    Gray<E> input_band = image.makeSubimage(0,inner0-above,image.width,inner1+below);
+                    Gray<R> output_band = output.makeSubimage(0,inner0-above,output.width,inner1+below);
+                    ConvolveImage_Inner::convolve(kernel, input_band, output_band);
+                }
+                ConvolveImage_Border::convolve(kernel, input, output, y0, y1);
+            });
+        }
+    };
+
+    /**
+     * Applies a separable convolution without a full size intermediate image. The output of the horizontal pass is
+     * written into a buffer which holds a band of rows plus the rows above and below that the vertical pass reads.
+     * Once a band is done the rows it shares with the next band are moved to the top of the buffer, so each row
+     * is only filtered horizontally once. The buffer is sized to stay in cache. It's provided by the caller so that
+     * it can be reused or taken from an {@link ImagePool}.
+     */
+    class ConvolveSeparableFused {
+    public:
+        // Target size of the row buffer in bytes
+        static const uint32_t BUFFER_BYTES = 128*1024;
+
+        /**
+         * @param above Number of rows above an output row which the vertical pass reads
+         * @param below Number of rows below an output row which the vertical pass reads
+         * @param block_rows Number of output rows in a band. If 0 then it's selected using BUFFER_BYTES.
+         * @param buffer Storage for the horizontally filtered rows. Reshaped. Pixel values don't need to be initialized.
+         * @param horizontal Function (input_rows, buffer_rows) which applies the horizontal pass
+         * @param vertical Function (buffer, output, n0, y0, y1) which applies the vertical pass to output rows y0 to y1.
+         *                 buffer and output are subimages which start at row n0.
+         */
+        template<class E, class Horizontal, class Vertical>
+        static void process( const Gray<E>& input, Gray<E>& output, uint32_t above, uint32_t below,
+                             uint32_t block_rows , Gray<E>& buffer, Horizontal horizontal, Vertical vertical )
+        {
+            const uint32_t width = input.width;
+            const uint32_t height = input.height;
+
+            if( block_rows == 0 )
+                block_rows = std::max(1U,(uint32_t)(BUFFER_BYTES/(width*sizeof(E))));
+
+            buffer.reshape(width,std::min(height,block_rows+above+below));
+
+            // rows in the image which the buffer contains
+            uint32_t b0 = 0, b1 = 0;
+
+            for( uint32_t y0 = 0; y0 < height; y0 += block_rows ) {
+                uint32_t y1 = std::min(height,y0+block_rows);
+                uint32_t n0 = y0 > above ? y0-above : 0;
+                uint32_t n1 = std::min(height,y1+below);
+
+                // move rows which are still needed to the start of the buffer
+                if( b1 > n0 ) {
+                    std::memmove(buffer.data,&buffer.data[(n0-b0)*buffer.stride],sizeof(E)*(b1-n0)*buffer.stride);
+                } else {
+                    b1 = n0;
+                }
+
+                Gray<E> input_rows = input.makeSubimage(0,b1,width,n1);
+                Gray<E> buffer_rows = buffer.makeSubimage(0,b1-n0,width,n1-n0);
+                horizontal(input_rows,buffer_rows);
+                b0 = n0;
+                b1 = n1;
+
+                Gray<E> window = buffer.makeSubimage(0,0,width,n1-n0);
+                Gray<E> output_window = output.makeSubimage(0,n0,width,n1);
+                vertical(window,output_window,n0,y0,y1);
+            }
+        }
     };
 
     /**
@@ -1179,6 +1586,168 @@ namespace boofcv {
             horizontal(kernel,input,workspace);
             vertical(kernel,workspace,output);
         }
+
+        /**
+         * Applies a 1D kernel horizontally then vertically without a full size intermediate image. Only a small
+         * band of horizontally filtered rows is kept, see {@link ConvolveSeparableFused}. The results are
+         * identical to the version which uses a workspace.
+         *
+         * @param kernel 1D kernel
+         * @param input Input image that convolution is applied to
+         * @param output Where the output is written to. Resized
+         * @param block_rows Number of rows in a band. 0 selects it automatically
+         */
+        template<class E>
+        static void convolve( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                              const Gray<E>& input, Gray<E>& output, uint32_t block_rows = 0 )
+        {
+            convolve_fused(kernel,input,output,block_rows,ImageAllocation::uninitialized());
+        }
+
+        /**
+         * Same as {@link #convolve} but the row buffer is taken from the pool and handed back to it afterwards
+         */
+        template<class E>
+        static void convolve( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                              const Gray<E>& input, Gray<E>& output, ImagePool& pool, uint32_t block_rows = 0 )
+        {
+            convolve_fused(kernel,input,output,block_rows,ImageAllocation(false,false,&pool));
+        }
+
+        /**
+         * Same as {@link #horizontal} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template<class E>
+        static void horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel, const Gray<E>& input,
+                                Gray<E>& output , const ConcurrencyContext& context )
+        {
+            boofcv::checkSameShape(input, output);
+
+            // rows are independent so each band can be treated as its own image
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                Gray<E> input_band = input.makeSubimage(0,y0,input.width,y1);
+                Gray<E> output_band = output.makeSubimage(0,y0,output.width,y1);
+                horizontal(kernel,input_band,output_band);
+            });
+        }
+
+        /**
+         * Same as {@link #vertical} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template<class E>
+        static void vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel, const Gray<E>& input,
+                              Gray<E>& output , const ConcurrencyContext& context )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            boofcv::checkSameShape(input, output);
+
+            if( kernel.width >= input.height ) {
+                ConvolveNormalizedNaive::vertical(kernel, input, output);
+                return;
+            }
+
+            uint32_t above = kernel.offset;
+            uint32_t below = kernel.width-kernel.offset-1;
+            signed_type sum = kernel.sum();
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                // inner rows in the band plus the rows above and below which the kernel reads
+                uint32_t inner0 = std::max(y0,above);
+                uint32_t inner1 = std::min(y1,input.height-below);
+                if( inner0 < inner1 ) {
+                    Gray<E> input_band = input.makeSubimage(0,inner0-above,input.width,inner1+below);
+                    Gray<E> output_band = output.makeSubimage(0,inner0-above,output.width,inner1+below);
+                    vertical_inner(kernel,input_band,output_band,sum);
+                }
+                ConvolveNormalized_JustBorder::vertical(kernel, input, output, y0, y1);
+            });
+        }
+
+        /**
+         * Same as {@link #convolve} but each pass is processed concurrently.
+         */
+        template<class E>
+        static void convolve( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                              const Gray<E>& input, Gray<E>& output, Gray<E>& workspace ,
+                              const ConcurrencyContext& context )
+        {
+            output.reshape(input.width,input.height);
+            workspace.reshape(input.width,input.height);
+
+            horizontal(kernel,input,workspace,context);
+            vertical(kernel,workspace,output,context);
+        }
+
+    private:
+        /**
+         * Implementation of the fused {@link #convolve}. Scratch images are created with 'scratch'
+         */
+        template<class E>
+        static void convolve_fused( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                                    const Gray<E>& input, Gray<E>& output, uint32_t block_rows ,
+                                    const ImageAllocation& scratch )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            output.reshape(input.width,input.height);
+
+            const uint32_t height = input.height;
+            if( kernel.width >= height ) {
+                Gray<E> workspace(input.width,input.height,scratch);
+                convolve(kernel,input,output,workspace);
+                return;
+            }
+
+            uint32_t above = kernel.offset;
+            uint32_t below = kernel.width-kernel.offset-1;
+            signed_type sum = kernel.sum();
+
+            Gray<E> buffer(0,0,scratch);
+            ConvolveSeparableFused::process(input,output,above,below,block_rows,buffer,
+                    [&](const Gray<E>& input_rows, Gray<E>& buffer_rows) {
+                        horizontal(kernel,input_rows,buffer_rows);
+                    },
+                    [&](const Gray<E>& window, Gray<E>& output_window, uint32_t n0, uint32_t y0, uint32_t y1) {
+                        uint32_t inner0 = std::max(y0,above);
+                        uint32_t inner1 = std::min(y1,height-below);
+                        if( inner0 < inner1 ) {
+                            Gray<E> input_band = window.makeSubimage(0,inner0-above-n0,window.width,inner1+below-n0);
+                            Gray<E> output_band = output_window.makeSubimage(0,inner0-above-n0,window.width,inner1+below-n0);
+                            vertical_inner(kernel,input_band,output_band,sum);
+                        }
+                        if( y0 < above ) {
+                            ConvolveNormalized_JustBorder::vertical(kernel,window,output_window,y0-n0,std::min(y1,above)-n0);
+                        }
+                        uint32_t bottom0 = std::max(y0,height-below);
+                        if( bottom0 < y1 ) {
+                            ConvolveNormalized_JustBorder::vertical(kernel,window,output_window,bottom0-n0,y1-n0);
+                        }
+                    });
+        }
+
+        template<class E>
+        static void vertical_inner( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                                    const Gray<E>& input, Gray<E>& output ,
+                                    typename TypeInfo<E>::signed_type sum ,
+                                    typename std::enable_if<std::is_integral<E>::value >::type* = 0)
+        {
+            ConvolveImage_Inner::vertical_unrolled(kernel, input, output, sum);
+        }
+
+        template<class E>
+        static void vertical_inner( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel,
+                                    const Gray<E>& input, Gray<E>& output ,
+                                    typename TypeInfo<E>::signed_type sum ,
+                                    typename std::enable_if<std::is_floating_point<E>::value >::type* = 0)
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            if( sum == (signed_type)1) {
+                ConvolveImage_Inner::vertical_unrolled(kernel, input, output);
+            } else {
+                ConvolveImage_Inner::vertical_unrolled(kernel, input, output, sum);
+            }
+        }
     };
 }
 
@@ -0,0 +1,727 @@
+#include <cstring>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "convolve_simd.h"
+#include "cpu_features.h"
+
+#if BOOFCPP_SIMD_AVX2
+#include <immintrin.h>
+#define BOOFCPP_SIMD_TARGET __attribute__((target("avx2")))
+#elif BOOFCPP_SIMD_NEON
+#include <arm_neon.h>
+#define BOOFCPP_SIMD_TARGET
+#endif
+
+using namespace boofcv;
+
+namespace {
+
+    // Output is the sum cast into the output type
+    template<class R>
+    struct StoreSum {
+        template<class S>
+        R scalar( S total ) const {
+            return static_cast<R>(total);
+        }
+    };
+
+    // Output is the sum divided by an integer divisor with rounding
+    template<class E>
+    struct StoreDivideInt {
+        S32 halfDivisor;
+        S32 divisor;
+
+        explicit StoreDivideInt( S32 divisor ) : halfDivisor(divisor/2), divisor(divisor) {}
+
+        E scalar( S32 total ) const {
+            return static_cast<E>((total+halfDivisor)/divisor);
+        }
+    };
+
+    // Output is the sum divided by a floating point divisor
+    struct StoreDivideFloat {
+        F32 divisor;
+
+        explicit StoreDivideFloat( F32 divisor ) : divisor(divisor) {}
+
+        F32 scalar( F32 total ) const {
+            return total/divisor;
+        }
+    };
+
+    /**
+     * The vectorized integer division converts to float, divides, then truncates. That's only identical to
+     * integer division when the numerator and divisor are small enough to be exactly represented by a float
+     * and can't cause a quotient to be rounded across an integer.
+     */
+    template<class E>
+    bool isDivisorSafe( const Kernel1D<S32>& kernel , S32 divisor ) {
+        if( divisor == 0 )
+            return false;
+
+        int64_t max_input = std::max(std::llabs(std::numeric_limits<E>::min()),
+                                     std::llabs(std::numeric_limits<E>::max()));
+        int64_t abs_sum = 0;
+        for( uint32_t i = 0; i < kernel.width; i++ ) {
+            abs_sum += std::llabs(kernel.data[i]);
+        }
+        int64_t bound = max_input*abs_sum + std::llabs(divisor/2) + std::llabs(divisor);
+        return bound <= (1 << 24);
+    }
+
+#if BOOFCPP_SIMD_AVX2 || BOOFCPP_SIMD_NEON
+
+#if BOOFCPP_SIMD_AVX2
+    typedef __m256i vint;
+    typedef __m256 vfloat;
+    const uint32_t LANES = 8;
+
+    bool simdAvailable() {
+        return CpuFeatures::avx2();
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint zero( S32 ) {
+        return _mm256_setzero_si256();
+    }
+
+    BOOFCPP_SIMD_TARGET inline vfloat zero( F32 ) {
+        return _mm256_setzero_ps();
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint load( const U8* ptr ) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint load( const S16* ptr ) {
+        return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vfloat load( const F32* ptr ) {
+        return _mm256_loadu_ps(ptr);
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint multiply_add( vint total , vint value , S32 weight ) {
+        return _mm256_add_epi32(total,_mm256_mullo_epi32(value,_mm256_set1_epi32(weight)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vfloat multiply_add( vfloat total , vfloat value , F32 weight ) {
+        return _mm256_add_ps(total,_mm256_mul_ps(value,_mm256_set1_ps(weight)));
+    }
+
+    // Stores the lower 8-bits of each value, i.e. the same as a static_cast
+    BOOFCPP_SIMD_TARGET inline void store( U8* ptr , vint value ) {
+        const __m256i shuffle = _mm256_setr_epi8(
+                0,4,8,12,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+                0,4,8,12,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1);
+        __m256i packed = _mm256_shuffle_epi8(value,shuffle);
+        packed = _mm256_permutevar8x32_epi32(packed,_mm256_setr_epi32(0,4,0,0,0,0,0,0));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr),_mm256_castsi256_si128(packed));
+    }
+
+    // Stores the lower 16-bits of each value, i.e. the same as a static_cast
+    BOOFCPP_SIMD_TARGET inline void store( S16* ptr , vint value ) {
+        const __m256i shuffle = _mm256_setr_epi8(
+                0,1,4,5,8,9,12,13,-1,-1,-1,-1,-1,-1,-1,-1,
+                0,1,4,5,8,9,12,13,-1,-1,-1,-1,-1,-1,-1,-1);
+        __m256i packed = _mm256_shuffle_epi8(value,shuffle);
+        packed = _mm256_permutevar8x32_epi32(packed,_mm256_setr_epi32(0,1,4,5,0,0,0,0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr),_mm256_castsi256_si128(packed));
+    }
+
+    BOOFCPP_SIMD_TARGET inline void store( S32* ptr , vint value ) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr),value);
+    }
+
+    BOOFCPP_SIMD_TARGET inline void store( F32* ptr , vfloat value ) {
+        _mm256_storeu_ps(ptr,value);
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint divide( vint total , S32 halfDivisor , S32 divisor ) {
+        __m256 numerator = _mm256_cvtepi32_ps(_mm256_add_epi32(total,_mm256_set1_epi32(halfDivisor)));
+        __m256 quotient = _mm256_div_ps(numerator,_mm256_set1_ps(static_cast<float>(divisor)));
+        return _mm256_cvttps_epi32(quotient);
+    }
+
+    BOOFCPP_SIMD_TARGET inline vfloat divide( vfloat total , F32 divisor ) {
+        return _mm256_div_ps(total,_mm256_set1_ps(divisor));
+    }
+#else
+    typedef int32x4_t vint;
+    typedef float32x4_t vfloat;
+    const uint32_t LANES = 4;
+
+    bool simdAvailable() {
+        return CpuFeatures::neon();
+    }
+
+    inline vint zero( S32 ) {
+        return vdupq_n_s32(0);
+    }
+
+    inline vfloat zero( F32 ) {
+        return vdupq_n_f32(0);
+    }
+
+    inline vint load( const U8* ptr ) {
+        uint32_t packed;
+        std::memcpy(&packed,ptr,4);
+        uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(packed)));
+        return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(wide)));
+    }
+
+    inline vint load( const S16* ptr ) {
+        return vmovl_s16(vld1_s16(ptr));
+    }
+
+    inline vfloat load( const F32* ptr ) {
+        return vld1q_f32(ptr);
+    }
+
+    inline vint multiply_add( vint total , vint value , S32 weight ) {
+        return vmlaq_n_s32(total,value,weight);
+    }
+
+    inline vfloat multiply_add( vfloat total , vfloat value , F32 weight ) {
+        return vaddq_f32(total,vmulq_n_f32(value,weight));
+    }
+
+    // Narrowing moves truncate, i.e. the same as a static_cast
+    inline void store( U8* ptr , vint value ) {
+        int16x4_t narrow = vmovn_s32(value);
+        uint8x8_t bytes = vreinterpret_u8_s8(vmovn_s16(vcombine_s16(narrow,narrow)));
+        uint32_t packed = vget_lane_u32(vreinterpret_u32_u8(bytes),0);
+        std::memcpy(ptr,&packed,4);
+    }
+
+    inline void store( S16* ptr , vint value ) {
+        vst1_s16(ptr,vmovn_s32(value));
+    }
+
+    inline void store( S32* ptr , vint value ) {
+        vst1q_s32(ptr,value);
+    }
+
+    inline void store( F32* ptr , vfloat value ) {
+        vst1q_f32(ptr,value);
+    }
+
+    inline vint divide( vint total , S32 halfDivisor , S32 divisor ) {
+        float32x4_t numerator = vcvtq_f32_s32(vaddq_s32(total,vdupq_n_s32(halfDivisor)));
+        return vcvtq_s32_f32(vdivq_f32(numerator,vdupq_n_f32(static_cast<float>(divisor))));
+    }
+
+    inline vfloat divide( vfloat total , F32 divisor ) {
+        return vdivq_f32(total,vdupq_n_f32(divisor));
+    }
+#endif
+
+    template<class R, class V>
+    BOOFCPP_SIMD_TARGET inline void finish( const StoreSum<R>& , R* ptr , V total ) {
+        store(ptr,total);
+    }
+
+    template<class E>
+    BOOFCPP_SIMD_TARGET inline void finish( const StoreDivideInt<E>& f , E* ptr , vint total ) {
+        store(ptr,divide(total,f.halfDivisor,f.divisor));
+    }
+
+    BOOFCPP_SIMD_TARGET inline void finish( const StoreDivideFloat& f , F32* ptr , vfloat total ) {
+        store(ptr,divide(total,f.divisor));
+    }
+
+    template<uint32_t W, class E, class R, class K, class Finish>
+    BOOFCPP_SIMD_TARGET void horizontal_simd( const Kernel1D<K>& kernel , const Gray<E>& input, Gray<R>& output ,
+                                              const Finish& finisher )
+    {
+        // if W is not zero the width is a constant and the compiler can unroll the kernel loop
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const K* weights = kernel.data.data;
+        const uint32_t N = input.width-(width-1);
+
+        for( uint32_t i = 0; i < input.height; i++ ) {
+            const E* input_row = &input.data[input.offset + i*input.stride];
+            R* output_row = &output.data[output.offset + i*output.stride + kernel.offset];
+
+            uint32_t x = 0;
+            for( ; x + LANES <= N; x += LANES ) {
+                const E* input_ptr = &input_row[x];
+                auto total = zero(K());
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total = multiply_add(total,load(&input_ptr[k]),weights[k]);
+                }
+                finish(finisher,&output_row[x],total);
+            }
+
+            // handle the tail with scalar code
+            for( ; x < N; x++ ) {
+                const E* input_ptr = &input_row[x];
+                K total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k]*weights[k];
+                }
+                output_row[x] = finisher.scalar(total);
+            }
+        }
+    }
+
+    template<uint32_t W, class E, class R, class K, class Finish>
+    BOOFCPP_SIMD_TARGET void vertical_simd( const Kernel1D<K>& kernel , const Gray<E>& input, Gray<R>& output ,
+                                            const Finish& finisher )
+    {
+        // if W is not zero the width is a constant and the compiler can unroll the kernel loop
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const K* weights = kernel.data.data;
+        const uint32_t stride = input.stride;
+        const int32_t yEnd = input.height-(width-kernel.offset-1);
+
+        for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+            const E* input_row = &input.data[input.offset + (y-kernel.offset)*stride];
+            R* output_row = &output.data[output.offset + y*output.stride];
+
+            uint32_t x = 0;
+            for( ; x + LANES <= input.width; x += LANES ) {
+                const E* input_ptr = &input_row[x];
+                auto total = zero(K());
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total = multiply_add(total,load(&input_ptr[k*stride]),weights[k]);
+                }
+                finish(finisher,&output_row[x],total);
+            }
+
+            // handle the tail with scalar code
+            for( ; x < input.width; x++ ) {
+                const E* input_ptr = &input_row[x];
+                K total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k*stride]*weights[k];
+                }
+                output_row[x] = finisher.scalar(total);
+            }
+        }
+    }
+
+#if BOOFCPP_SIMD_AVX2
+    // _mm256_mullo_epi32 is slow. When the input and kernel fit inside of 16-bits _mm256_madd_epi16 is used
+    // instead, which multiplies two taps and adds them together in one instruction
+
+    BOOFCPP_SIMD_TARGET inline __m128i load16( const U8* ptr ) {
+        return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline __m128i load16( const S16* ptr ) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint multiply_add_pair( vint total , __m128i valueA , __m128i valueB , S32 weights ) {
+        __m256i pairs = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_unpacklo_epi16(valueA,valueB)),_mm_unpackhi_epi16(valueA,valueB),1);
+        return _mm256_add_epi32(total,_mm256_madd_epi16(pairs,_mm256_set1_epi32(weights)));
+    }
+
+    /**
+     * Packs adjacent weights into the format used by madd. If the kernel has an odd width then the last
+     * weight is paired with zero. Returns false if a weight can't be represented with 16-bits.
+     */
+    bool packWeightPairs( const Kernel1D<S32>& kernel , std::vector<S32>& pairs ) {
+        pairs.clear();
+        for( uint32_t k = 0; k < kernel.width; k += 2 ) {
+            S32 a = kernel.data[k];
+            S32 b = k+1 < kernel.width ? kernel.data[k+1] : 0;
+            if( a < INT16_MIN || a > INT16_MAX || b < INT16_MIN || b > INT16_MAX )
+                return false;
+            pairs.push_back((S32)(((uint32_t)(uint16_t)b << 16) | (uint16_t)a));
+        }
+        return true;
+    }
+
+    template<uint32_t W, class E, class R, class Finish>
+    BOOFCPP_SIMD_TARGET void horizontal_pairs( const Kernel1D<S32>& kernel , const S32* pairs ,
+                                               const Gray<E>& input, Gray<R>& output , const Finish& finisher )
+    {
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const S32* weights = kernel.data.data;
+        const uint32_t N = input.width-(width-1);
+
+        for( uint32_t i = 0; i < input.height; i++ ) {
+            const E* input_row = &input.data[input.offset + i*input.stride];
+            R* output_row = &output.data[output.offset + i*output.stride + kernel.offset];
+
+            uint32_t x = 0;
+            for( ; x + LANES <= N; x += LANES ) {
+                const E* input_ptr = &input_row[x];
+                vint total = _mm256_setzero_si256();
+                for( uint32_t k = 0; k+1 < width; k += 2 ) {
+                    total = multiply_add_pair(total,load16(&input_ptr[k]),load16(&input_ptr[k+1]),pairs[k/2]);
+                }
+                // reading past the last tap could go outside the image
+                if( width % 2 == 1 ) {
+                    total = multiply_add_pair(total,load16(&input_ptr[width-1]),_mm_setzero_si128(),pairs[width/2]);
+                }
+                finish(finisher,&output_row[x],total);
+            }
+
+            for( ; x < N; x++ ) {
+                const E* input_ptr = &input_row[x];
+                S32 total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k]*weights[k];
+                }
+                output_row[x] = finisher.scalar(total);
+            }
+        }
+    }
+
+    template<uint32_t W, class E, class R, class Finish>
+    BOOFCPP_SIMD_TARGET void vertical_pairs( const Kernel1D<S32>& kernel , const S32* pairs ,
+                                             const Gray<E>& input, Gray<R>& output , const Finish& finisher )
+    {
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const S32* weights = kernel.data.data;
+        const uint32_t stride = input.stride;
+        const int32_t yEnd = input.height-(width-kernel.offset-1);
+
+        for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+            const E* input_row = &input.data[input.offset + (y-kernel.offset)*stride];
+            R* output_row = &output.data[output.offset + y*output.stride];
+
+            uint32_t x = 0;
+            for( ; x + LANES <= input.width; x += LANES ) {
+                const E* input_ptr = &input_row[x];
+                vint total = _mm256_setzero_si256();
+                for( uint32_t k = 0; k+1 < width; k += 2 ) {
+                    total = multiply_add_pair(total,load16(&input_ptr[k*stride]),
+                                              load16(&input_ptr[(k+1)*stride]),pairs[k/2]);
+                }
+                if( width % 2 == 1 ) {
+                    total = multiply_add_pair(total,load16(&input_ptr[(width-1)*stride]),
+                                              _mm_setzero_si128(),pairs[width/2]);
+                }
+                finish(finisher,&output_row[x],total);
+            }
+
+            for( ; x < input.width; x++ ) {
+                const E* input_ptr = &input_row[x];
+                S32 total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k*stride]*weights[k];
+                }
+                output_row[x] = finisher.scalar(total);
+            }
+        }
+    }
+
+    template<class E, class R, class Finish>
+    bool run_pairs( bool horizontal , const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<R>& output ,
+                    const Finish& finisher )
+    {
+        std::vector<S32> pairs;
+        if( !packWeightPairs(kernel,pairs) )
+            return false;
+
+        if( horizontal ) {
+            switch( kernel.width ) {
+                case 3:horizontal_pairs<3>(kernel,pairs.data(),input,output,finisher);break;
+                case 5:horizontal_pairs<5>(kernel,pairs.data(),input,output,finisher);break;
+                case 7:horizontal_pairs<7>(kernel,pairs.data(),input,output,finisher);break;
+                case 9:horizontal_pairs<9>(kernel,pairs.data(),input,output,finisher);break;
+                case 11:horizontal_pairs<11>(kernel,pairs.data(),input,output,finisher);break;
+                case 13:horizontal_pairs<13>(kernel,pairs.data(),input,output,finisher);break;
+                default:horizontal_pairs<0>(kernel,pairs.data(),input,output,finisher);break;
+            }
+        } else {
+            switch( kernel.width ) {
+                case 3:vertical_pairs<3>(kernel,pairs.data(),input,output,finisher);break;
+                case 5:vertical_pairs<5>(kernel,pairs.data(),input,output,finisher);break;
+                case 7:vertical_pairs<7>(kernel,pairs.data(),input,output,finisher);break;
+                case 9:vertical_pairs<9>(kernel,pairs.data(),input,output,finisher);break;
+                case 11:vertical_pairs<11>(kernel,pairs.data(),input,output,finisher);break;
+                case 13:vertical_pairs<13>(kernel,pairs.data(),input,output,finisher);break;
+                default:vertical_pairs<0>(kernel,pairs.data(),input,output,finisher);break;
+            }
+        }
+        return true;
+    }
+
+    template<class R, class Finish>
+    bool try_pairs( bool horizontal , const Kernel1D<S32>& kernel , const Gray<U8>& input, Gray<R>& output ,
+                    const Finish& finisher ) {
+        return run_pairs(horizontal,kernel,input,output,finisher);
+    }
+
+    template<class R, class Finish>
+    bool try_pairs( bool horizontal , const Kernel1D<S32>& kernel , const Gray<S16>& input, Gray<R>& output ,
+                    const Finish& finisher ) {
+        return run_pairs(horizontal,kernel,input,output,finisher);
+    }
+
+    // When the output is 8 or 16-bit and isn't divided, only the lower 16-bits of the sum matter. The sum can
+    // then be computed with 16-bit arithmetic, which processes twice as many pixels at once
+
+    BOOFCPP_SIMD_TARGET inline __m256i load16x16( const U8* ptr ) {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline __m256i load16x16( const S16* ptr ) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    }
+
+    BOOFCPP_SIMD_TARGET inline __m256i multiply_add16( __m256i total , __m256i value , S32 weight ) {
+        return _mm256_add_epi16(total,_mm256_mullo_epi16(value,_mm256_set1_epi16(static_cast<S16>(weight))));
+    }
+
+    BOOFCPP_SIMD_TARGET inline void store16x16( U8* ptr , __m256i value ) {
+        __m256i bytes = _mm256_packus_epi16(_mm256_and_si256(value,_mm256_set1_epi16(0xFF)),_mm256_setzero_si256());
+        bytes = _mm256_permute4x64_epi64(bytes,0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr),_mm256_castsi256_si128(bytes));
+    }
+
+    BOOFCPP_SIMD_TARGET inline void store16x16( S16* ptr , __m256i value ) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr),value);
+    }
+
+    template<uint32_t W, class E, class R>
+    BOOFCPP_SIMD_TARGET void horizontal_low16( const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<R>& output )
+    {
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const S32* weights = kernel.data.data;
+        const uint32_t N = input.width-(width-1);
+
+        for( uint32_t i = 0; i < input.height; i++ ) {
+            const E* input_row = &input.data[input.offset + i*input.stride];
+            R* output_row = &output.data[output.offset + i*output.stride + kernel.offset];
+
+            uint32_t x = 0;
+            for( ; x + 16 <= N; x += 16 ) {
+                const E* input_ptr = &input_row[x];
+                __m256i total = _mm256_setzero_si256();
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total = multiply_add16(total,load16x16(&input_ptr[k]),weights[k]);
+                }
+                store16x16(&output_row[x],total);
+            }
+
+            for( ; x < N; x++ ) {
+                const E* input_ptr = &input_row[x];
+                S32 total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k]*weights[k];
+                }
+                output_row[x] = static_cast<R>(total);
+            }
+        }
+    }
+
+    template<uint32_t W, class E, class R>
+    BOOFCPP_SIMD_TARGET void vertical_low16( const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<R>& output )
+    {
+        const uint32_t width = W > 0 ? W : kernel.width;
+        const S32* weights = kernel.data.data;
+        const uint32_t stride = input.stride;
+        const int32_t yEnd = input.height-(width-kernel.offset-1);
+
+        for( int32_t y = kernel.offset; y < yEnd; y++ ) {
+            const E* input_row = &input.data[input.offset + (y-kernel.offset)*stride];
+            R* output_row = &output.data[output.offset + y*output.stride];
+
+            uint32_t x = 0;
+            for( ; x + 16 <= input.width; x += 16 ) {
+                const E* input_ptr = &input_row[x];
+                __m256i total = _mm256_setzero_si256();
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total = multiply_add16(total,load16x16(&input_ptr[k*stride]),weights[k]);
+                }
+                store16x16(&output_row[x],total);
+            }
+
+            for( ; x < input.width; x++ ) {
+                const E* input_ptr = &input_row[x];
+                S32 total = 0;
+                for( uint32_t k = 0; k < width; k++ ) {
+                    total += input_ptr[k*stride]*weights[k];
+                }
+                output_row[x] = static_cast<R>(total);
+            }
+        }
+    }
+
+    template<class E, class R>
+    bool run_low16( bool horizontal , const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<R>& output )
+    {
+        if( horizontal ) {
+            switch( kernel.width ) {
+                case 3:horizontal_low16<3>(kernel,input,output);break;
+                case 5:horizontal_low16<5>(kernel,input,output);break;
+                case 7:horizontal_low16<7>(kernel,input,output);break;
+                case 9:horizontal_low16<9>(kernel,input,output);break;
+                case 11:horizontal_low16<11>(kernel,input,output);break;
+                case 13:horizontal_low16<13>(kernel,input,output);break;
+                default:horizontal_low16<0>(kernel,input,output);break;
+            }
+        } else {
+            switch( kernel.width ) {
+                case 3:vertical_low16<3>(kernel,input,output);break;
+                case 5:vertical_low16<5>(kernel,input,output);break;
+                case 7:vertical_low16<7>(kernel,input,output);break;
+                case 9:vertical_low16<9>(kernel,input,output);break;
+                case 11:vertical_low16<11>(kernel,input,output);break;
+                case 13:vertical_low16<13>(kernel,input,output);break;
+                default:vertical_low16<0>(kernel,input,output);break;
+            }
+        }
+        return true;
+    }
+
+    template<class E>
+    bool try_low16( bool horizontal , const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<U8>& output ,
+                    const StoreSum<U8>& ) {
+        return run_low16(horizontal,kernel,input,output);
+    }
+
+    template<class E>
+    bool try_low16( bool horizontal , const Kernel1D<S32>& kernel , const Gray<E>& input, Gray<S16>& output ,
+                    const StoreSum<S16>& ) {
+        return run_low16(horizontal,kernel,input,output);
+    }
+#endif
+
+    // Output types which need more than the lower 16-bits of the sum
+    template<class E, class R, class K, class Finish>
+    bool try_low16( bool , const Kernel1D<K>& , const Gray<E>& , Gray<R>& , const Finish& ) {
+        return false;
+    }
+
+    // Input types which can't use the 16-bit multiply-add
+    template<class E, class R, class K, class Finish>
+    bool try_pairs( bool , const Kernel1D<K>& , const Gray<E>& , Gray<R>& , const Finish& ) {
+        return false;
+    }
+
+    template<class E, class R, class K, class Finish>
+    bool run_horizontal( const Kernel1D<K>& kernel , const Gray<E>& input, Gray<R>& output , const Finish& finisher ) {
+        if( !simdAvailable() )
+            return false;
+        if( try_low16(true,kernel,input,output,finisher) || try_pairs(true,kernel,input,output,finisher) )
+            return true;
+        switch( kernel.width ) {
+            case 3:horizontal_simd<3>(kernel,input,output,finisher);break;
+            case 5:horizontal_simd<5>(kernel,input,output,finisher);break;
+            case 7:horizontal_simd<7>(kernel,input,output,finisher);break;
+            case 9:horizontal_simd<9>(kernel,input,output,finisher);break;
+            case 11:horizontal_simd<11>(kernel,input,output,finisher);break;
+            case 13:horizontal_simd<13>(kernel,input,output,finisher);break;
+            default:horizontal_simd<0>(kernel,input,output,finisher);break;
+        }
+        return true;
+    }
+
+    template<class E, class R, class K, class Finish>
+    bool run_vertical( const Kernel1D<K>& kernel , const Gray<E>& input, Gray<R>& output , const Finish& finisher ) {
+        if( !simdAvailable() )
+            return false;
+        if( try_low16(false,kernel,input,output,finisher) || try_pairs(false,kernel,input,output,finisher) )
+            return true;
+        switch( kernel.width ) {
+            case 3:vertical_simd<3>(kernel,input,output,finisher);break;
+            case 5:vertical_simd<5>(kernel,input,output,finisher);break;
+            case 7:vertical_simd<7>(kernel,input,output,finisher);break;
+            case 9:vertical_simd<9>(kernel,input,output,finisher);break;
+            case 11:vertical_simd<11>(kernel,input,output,finisher);break;
+            case 13:vertical_simd<13>(kernel,input,output,finisher);break;
+            default:vertical_simd<0>(kernel,input,output,finisher);break;
+        }
+        return true;
+    }
+#else
+    template<class E, class R, class K, class Finish>
+    bool run_horizontal( const Kernel1D<K>& , const Gray<E>& , Gray<R>& , const Finish& ) {
+        return false;
+    }
+
+    template<class E, class R, class K, class Finish>
+    bool run_vertical( const Kernel1D<K>& , const Gray<E>& , Gray<R>& , const Finish& ) {
+        return false;
+    }
+#endif
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<U8>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S16>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<S16>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S32>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<S32>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<S16>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S32>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<S32>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output ) {
+    return run_horizontal(kernel,input,output,StoreSum<F32>());
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output , S32 divisor ) {
+    if( !isDivisorSafe<U8>(kernel,divisor) )
+        return false;
+    return run_horizontal(kernel,input,output,StoreDivideInt<U8>(divisor));
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output , S32 divisor ) {
+    if( !isDivisorSafe<S16>(kernel,divisor) )
+        return false;
+    return run_horizontal(kernel,input,output,StoreDivideInt<S16>(divisor));
+}
+
+bool ConvolveImage_SIMD::horizontal( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output , F32 divisor ) {
+    return run_horizontal(kernel,input,output,StoreDivideFloat(divisor));
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<U8>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S16>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<S16>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S32>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<S32>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<S16>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S32>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<S32>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output ) {
+    return run_vertical(kernel,input,output,StoreSum<F32>());
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output , S32 divisor ) {
+    if( !isDivisorSafe<U8>(kernel,divisor) )
+        return false;
+    return run_vertical(kernel,input,output,StoreDivideInt<U8>(divisor));
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output , S32 divisor ) {
+    if( !isDivisorSafe<S16>(kernel,divisor) )
+        return false;
+    return run_vertical(kernel,input,output,StoreDivideInt<S16>(divisor));
+}
+
+bool ConvolveImage_SIMD::vertical( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output , F32 divisor ) {
+    return run_vertical(kernel,input,output,StoreDivideFloat(divisor));
+}
@@ -0,0 +1,74 @@
+#ifndef BOOFCPP_CONVOLVE_SIMD_H
+#define BOOFCPP_CONVOLVE_SIMD_H
+
+#include <cstdint>
+
+#include "base_types.h"
+#include "image_types.h"
+#include "convolve_kernels.h"
+
+namespace boofcv {
+    /**
+     * SIMD implementations of the inner image convolution in {@link ConvolveImage_Inner}. The instruction set
+     * is selected at run time using {@link CpuFeatures}. Each function returns true if it processed the image.
+     * False is returned if the image type isn't supported, the CPU lacks the required instructions, or the
+     * vectorized arithmetic can't be guaranteed to match the scalar code. The caller must then fall back
+     * onto the scalar code.
+     *
+     * Integer results are identical to the scalar code. Floating point results are computed with the same
+     * operations in the same order.
+     */
+    class ConvolveImage_SIMD {
+    public:
+        // Types without a SIMD implementation end up here
+        template<typename E, typename R>
+        static bool horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& /*kernel*/ ,
+                                const Gray<E>& /*input*/, Gray<R>& /*output*/ ) {
+            return false;
+        }
+
+        template<typename E>
+        static bool horizontal( const Kernel1D<typename TypeInfo<E>::signed_type>& /*kernel*/ ,
+                                const Gray<E>& /*input*/, Gray<E>& /*output*/ ,
+                                typename TypeInfo<E>::signed_type /*divisor*/ ) {
+            return false;
+        }
+
+        template<typename E, typename R>
+        static bool vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& /*kernel*/ ,
+                              const Gray<E>& /*input*/, Gray<R>& /*output*/ ) {
+            return false;
+        }
+
+        template<typename E>
+        static bool vertical( const Kernel1D<typename TypeInfo<E>::signed_type>& /*kernel*/ ,
+                              const Gray<E>& /*input*/, Gray<E>& /*output*/ ,
+                              typename TypeInfo<E>::signed_type /*divisor*/ ) {
+            return false;
+        }
+
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output );
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S16>& output );
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S32>& output );
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output );
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S32>& output );
+        static bool horizontal( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output );
+
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output , S32 divisor );
+        static bool horizontal( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output , S32 divisor );
+        static bool horizontal( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output , F32 divisor );
+
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output );
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S16>& output );
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<S32>& output );
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output );
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S32>& output );
+        static bool vertical( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output );
+
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<U8>& input, Gray<U8>& output , S32 divisor );
+        static bool vertical( const Kernel1D<S32>& kernel, const Gray<S16>& input, Gray<S16>& output , S32 divisor );
+        static bool vertical( const Kernel1D<F32>& kernel, const Gray<F32>& input, Gray<F32>& output , F32 divisor );
+    };
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include <atomic>
+
+#include "cpu_features.h"
+
+using namespace boofcv;
+
+static std::atomic<bool> simd_enabled(true);
+
+static bool detect_avx2() {
+#if BOOFCPP_SIMD_AVX2
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+static bool detect_neon() {
+#if BOOFCPP_SIMD_NEON
+    // NEON is a mandatory part of ARMv8-A
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool boofcv::CpuFeatures::avx2() {
+    static const bool supported = detect_avx2();
+    return supported && simd_enabled;
+}
+
+bool boofcv::CpuFeatures::neon() {
+    static const bool supported = detect_neon();
+    return supported && simd_enabled;
+}
+
+bool boofcv::CpuFeatures::simd() {
+    return avx2() || neon();
+}
+
+void boofcv::CpuFeatures::setSimdEnabled( bool enabled ) {
+    simd_enabled = enabled;
+}
+
+bool boofcv::CpuFeatures::isSimdEnabled() {
+    return simd_enabled;
+}
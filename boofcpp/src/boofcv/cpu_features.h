@@ -0,0 +1,46 @@
+#ifndef BOOFCPP_CPU_FEATURES_H
+#define BOOFCPP_CPU_FEATURES_H
+
+// Select which SIMD instruction set optimized code is compiled for. Define BOOFCPP_DISABLE_SIMD to build
+// only the scalar code.
+#if !defined(BOOFCPP_DISABLE_SIMD)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BOOFCPP_SIMD_AVX2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define BOOFCPP_SIMD_NEON 1
+#endif
+#endif
+
+namespace boofcv {
+
+    /**
+     * Run time detection of instruction sets which optimized code paths can be selected from. All SIMD code
+     * can be turned off, which is useful when testing against or benchmarking the scalar code.
+     */
+    class CpuFeatures {
+    public:
+        /**
+         * True if AVX2 SIMD code can be used. The CPU must support it and SIMD must be enabled.
+         */
+        static bool avx2();
+
+        /**
+         * True if NEON SIMD code can be used. The CPU must support it and SIMD must be enabled.
+         */
+        static bool neon();
+
+        /**
+         * True if any of the supported SIMD instruction sets can be used.
+         */
+        static bool simd();
+
+        /**
+         * Turns SIMD code on or off. On by default.
+         */
+        static void setSimdEnabled( bool enabled );
+
+        static bool isSimdEnabled();
+    };
+}
+
+#endif
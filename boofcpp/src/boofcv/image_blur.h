@@ -2,8 +2,10 @@
 #define BOOFCPP_IMAGE_BLUR_H
 
 #include "convolve.h"
+#include "image_pool.h"
 #include "sanity_checks.h"
 #include <math.h>
+#include <vector>
 
 namespace boofcv {
     /**
@@ -194,13 +196,188 @@ namespace boofcv {
             typedef typename TypeInfo<E>::signed_type signed_type;
 
             Kernel1D<signed_type> kernel = FactoryKernel::mean1D<signed_type>(radius*2+1);
-            if( kernel.width > input.width ) {
+            if( kernel.width > input.height ) {
                 ConvolveNormalized::vertical(kernel,input,output);
             } else {
                 ConvolveNormalized_JustBorder::vertical(kernel, input ,output );
                 inner_vertical(input, output, radius);
             }
         }
+
+        /**
+         * Same as {@link #horizontal} but the image is split into bands of rows which are processed concurrently.
+         * The results are identical to the single threaded version.
+         */
+        template< class E>
+        static void horizontal(const Gray<E>& input, Gray<E>& output, uint32_t radius ,
+                               const ConcurrencyContext& context )
+        {
+            checkSameShape(input,output);
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                Gray<E> input_band = input.makeSubimage(0,y0,input.width,y1);
+                Gray<E> output_band = output.makeSubimage(0,y0,output.width,y1);
+                horizontal(input_band,output_band,radius);
+            });
+        }
+
+        /**
+         * Same as {@link #vertical} but the image is split into bands of rows which are processed concurrently.
+         * Each band starts its own running total, so floating point images can differ from the single threaded
+         * version by round off error. Integer images are identical.
+         */
+        template< class E>
+        static void vertical(const Gray<E>& input, Gray<E>& output, uint32_t radius ,
+                             const ConcurrencyContext& context )
+        {
+            checkSameShape(input,output);
+
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            Kernel1D<signed_type> kernel = FactoryKernel::mean1D<signed_type>(radius*2+1);
+            if( kernel.width > input.height ) {
+                ConvolveNormalized::vertical(kernel,input,output,context);
+                return;
+            }
+
+            const uint32_t height = input.height;
+            concurrent_rows(context,height,[&](uint32_t y0, uint32_t y1){
+                uint32_t inner0 = std::max(y0,radius);
+                uint32_t inner1 = std::min(y1,height-radius);
+                if( inner0 < inner1 ) {
+                    Gray<E> input_band = input.makeSubimage(0,inner0-radius,input.width,inner1+radius);
+                    Gray<E> output_band = output.makeSubimage(0,inner0-radius,output.width,inner1+radius);
+                    inner_vertical(input_band,output_band,radius);
+                }
+                ConvolveNormalized_JustBorder::vertical(kernel,input,output,y0,y1);
+            });
+        }
+
+        /**
+         * Applies the mean filter horizontally then vertically without a full size intermediate image. The
+         * vertical pass keeps a running total for each column across bands of rows, see
+         * {@link ConvolveSeparableFused}. The results are identical to calling horizontal() then vertical().
+         *
+         * @param block_rows Number of rows in a band. 0 selects it automatically
+         */
+        template< class E>
+        static void convolve(const Gray<E>& input, Gray<E>& output, uint32_t radius , uint32_t block_rows = 0 )
+        {
+            convolve_fused(input,output,radius,block_rows,ImageAllocation::uninitialized());
+        }
+
+        /**
+         * Same as {@link #convolve} but the row buffer and running totals are taken from the pool and handed back
+         * to it afterwards
+         */
+        template< class E>
+        static void convolve(const Gray<E>& input, Gray<E>& output, uint32_t radius , ImagePool& pool,
+                             uint32_t block_rows = 0 )
+        {
+            convolve_fused(input,output,radius,block_rows,ImageAllocation(false,false,&pool));
+        }
+
+    private:
+        /**
+         * Implementation of the fused {@link #convolve}. Scratch images are created with 'scratch'
+         */
+        template< class E>
+        static void convolve_fused(const Gray<E>& input, Gray<E>& output, uint32_t radius , uint32_t block_rows ,
+                                   const ImageAllocation& scratch )
+        {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+            typedef typename TypeInfo<E>::sum_type sum_type;
+
+            output.reshape(input.width,input.height);
+
+            const uint32_t width = input.width;
+            const uint32_t height = input.height;
+            const uint32_t kernelWidth = radius*2+1;
+
+            if( kernelWidth > width || kernelWidth > height ) {
+                Gray<E> storage(width,height,scratch);
+                horizontal(input, storage, radius);
+                vertical(storage, output, radius);
+                return;
+            }
+
+            Kernel1D<signed_type> kernel = FactoryKernel::mean1D<signed_type>(kernelWidth);
+            Gray<sum_type> totals(width,1,scratch);
+
+            // The row before the kernel is also needed to update the running total
+            Gray<E> buffer(0,0,scratch);
+            ConvolveSeparableFused::process(input,output,radius+1,radius,block_rows,buffer,
+                    [&](const Gray<E>& input_rows, Gray<E>& buffer_rows) {
+                        horizontal(input_rows, buffer_rows, radius);
+                    },
+                    [&](const Gray<E>& window, Gray<E>& output_window, uint32_t n0, uint32_t y0, uint32_t y1) {
+                        uint32_t inner0 = std::max(y0,radius);
+                        uint32_t inner1 = std::min(y1,height-radius);
+                        for( uint32_t y = inner0; y < inner1; y++ ) {
+                            vertical_row(window,output_window,y-n0,radius,y==radius,totals.data);
+                        }
+                        if( y0 < radius ) {
+                            ConvolveNormalized_JustBorder::vertical(kernel,window,output_window,y0-n0,std::min(y1,radius)-n0);
+                        }
+                        uint32_t bottom0 = std::max(y0,height-radius);
+                        if( bottom0 < y1 ) {
+                            ConvolveNormalized_JustBorder::vertical(kernel,window,output_window,bottom0-n0,y1-n0);
+                        }
+                    });
+        }
+
+        /**
+         * Computes a single row in the inner image using the same arithmetic as inner_vertical()
+         *
+         * @param y Row in input and output
+         * @param first If true the running totals are initialized
+         */
+        template< class E>
+        static void vertical_row(const Gray<E>& input, Gray<E>& output, uint32_t y, uint32_t radius, bool first,
+                                 typename TypeInfo<E>::sum_type* totals )
+        {
+            typedef typename TypeInfo<E>::sum_type sum_type;
+            sum_type kernelWidth = radius*2 + 1;
+            uint32_t backStep = kernelWidth*input.stride;
+            sum_type divisor = kernelWidth;
+
+            E* ptr_out = &output.data[output.offset + y*output.stride];
+
+            if( first ) {
+                for( uint32_t x = 0; x < input.width; x++ ) {
+                    uint32_t indexIn = input.offset + (y-radius)*input.stride + x;
+
+                    sum_type total = 0;
+                    uint32_t indexEnd = indexIn + input.stride*kernelWidth;
+                    for( ; indexIn < indexEnd; indexIn += input.stride) {
+                        total += input.data[indexIn];
+                    }
+                    totals[x] = total;
+                    ptr_out[x] = static_cast<E>(divide(total,divisor));
+                }
+            } else {
+                uint32_t indexIn = input.offset + (y+radius)*input.stride;
+                E* ptr_front = &input.data[ indexIn - backStep ];
+                E* ptr_back = &input.data[ indexIn ];
+
+                for( uint32_t x = 0; x < input.width; x++) {
+                    sum_type total = totals[ x ]  - *ptr_front++;
+                    totals[ x ] = total += *ptr_back++;
+
+                    ptr_out[x] = static_cast<E>(divide(total,divisor));
+                }
+            }
+        }
+
+        template< class S>
+        static S divide( S total , S divisor , typename std::enable_if<std::is_integral<S>::value >::type* = 0 ) {
+            return (total+divisor/2)/divisor;
+        }
+
+        template< class S>
+        static S divide( S total , S divisor , typename std::enable_if<std::is_floating_point<S>::value >::type* = 0 ) {
+            return total/divisor;
+        }
     };
 
     class BlurImageOps {
@@ -227,6 +404,40 @@ namespace boofcv {
             ConvolveImageMean::vertical(storage, output, radius);
         }
 
+        /**
+         * Applies a mean box filter without needing storage for intermediate results. Produces the same output
+         * as the version with storage.
+         *
+         * @param input Input image.  Not modified.
+         * @param output Storage for output image.
+         * @param radius Radius of the box blur function.
+         */
+        template<class E>
+        static void mean(const Gray<E> &input, Gray<E> &output, uint32_t radius) {
+
+            if (radius <= 0)
+                throw invalid_argument("Radius must be > 0");
+
+            ConvolveImageMean::convolve(input, output, radius);
+        }
+
+        /**
+         * Same as {@link #mean} but each pass is processed concurrently
+         */
+        template<class E>
+        static void mean(const Gray<E> &input, Gray<E> &output, uint32_t radius, Gray<E> &storage,
+                         const ConcurrencyContext& context ) {
+
+            if (radius <= 0)
+                throw invalid_argument("Radius must be > 0");
+
+            output.reshape(input.width, input.height);
+            storage.reshape(input.width, input.height);
+
+            ConvolveImageMean::horizontal(input, storage, radius, context);
+            ConvolveImageMean::vertical(storage, output, radius, context);
+        }
+
         /**
          * Applies a Gaussian filter.
          *
@@ -249,7 +460,78 @@ namespace boofcv {
             ConvolveNormalized::horizontal(kernel, input, storage);
             ConvolveNormalized::vertical(kernel, storage, output);
         }
+
+        /**
+         * Applies a Gaussian filter without needing storage for intermediate results. Produces the same output
+         * as the version with storage.
+         *
+         * @param input Input image.  Not modified.
+         * @param output Storage for output image.
+         * @param sigma Distribution's sigma. If <= 0 then sigma is determined from width
+         * @param width Width of the kernel. If <= 0 then width is determined from sigma
+         */
+        template<class E>
+        static void gaussian(const Gray<E> &input, Gray<E> &output, double sigma, int32_t width) {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            Kernel1D<signed_type> kernel = FactoryKernel::gaussian1D<signed_type>(sigma,width);
+
+            ConvolveNormalized::convolve(kernel, input, output);
+        }
+
+        /**
+         * Same as {@link #gaussian} but each pass is processed concurrently. The results are identical.
+         */
+        template<class E>
+        static void gaussian(const Gray<E> &input, Gray<E> &output, double sigma, int32_t width, Gray<E> &storage,
+                             const ConcurrencyContext& context ) {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            Kernel1D<signed_type> kernel = FactoryKernel::gaussian1D<signed_type>(sigma,width);
+
+            ConvolveNormalized::convolve(kernel, input, output, storage, context);
+        }
+
+        /**
+         * Same as {@link #mean} but storage for intermediate results is taken from the pool and handed back to it
+         * afterwards.
+         */
+        template<class E>
+        static void mean(const Gray<E> &input, Gray<E> &output, uint32_t radius, ImagePool& pool) {
+
+            if (radius <= 0)
+                throw invalid_argument("Radius must be > 0");
+
+            ConvolveImageMean::convolve(input, output, radius, pool);
+        }
+
+        template<class E>
+        static void mean(const Gray<E> &input, Gray<E> &output, uint32_t radius, ImagePool& pool,
+                         const ConcurrencyContext& context ) {
+            Gray<E> storage = pool.gray<E>(input.width, input.height);
+            mean(input, output, radius, storage, context);
+        }
+
+        /**
+         * Same as {@link #gaussian} but storage for intermediate results is taken from the pool and handed back
+         * to it afterwards.
+         */
+        template<class E>
+        static void gaussian(const Gray<E> &input, Gray<E> &output, double sigma, int32_t width, ImagePool& pool) {
+            typedef typename TypeInfo<E>::signed_type signed_type;
+
+            Kernel1D<signed_type> kernel = FactoryKernel::gaussian1D<signed_type>(sigma,width);
+
+            ConvolveNormalized::convolve(kernel, input, output, pool);
+        }
+
+        template<class E>
+        static void gaussian(const Gray<E> &input, Gray<E> &output, double sigma, int32_t width, ImagePool& pool,
+                             const ConcurrencyContext& context ) {
+            Gray<E> storage = pool.gray<E>(input.width, input.height);
+            gaussian(input, output, sigma, width, storage, context);
+        }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,118 @@
+#include <cctype>
+#include <stdexcept>
+
+#include "image_mapping.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace boofcv;
+
+namespace {
+#if !defined(_WIN32)
+    /**
+     * Maps 'bytes' of the file descriptor then closes it. The mapping stays valid after the descriptor is closed.
+     */
+    std::shared_ptr<MappedImageBuffer> map_descriptor( int fd , size_t bytes , int protection , int flags ,
+                                                       const std::string& name ) {
+        void* ptr = nullptr;
+        if( bytes > 0 ) {
+            ptr = mmap(nullptr, bytes, protection, flags, fd, 0);
+        }
+        close(fd);
+        if( ptr == MAP_FAILED )
+            throw std::runtime_error("Failed to map "+name);
+        return std::make_shared<MappedImageBuffer>(ptr,bytes);
+    }
+#endif
+
+    /**
+     * Reads the next number in a PGM header. Skips white space and comments.
+     */
+    uint32_t read_header_number( const char* header , size_t length , size_t& location ) {
+        while( location < length ) {
+            char c = header[location];
+            if( c == '#' ) {
+                while( location < length && header[location] != '\n' )
+                    location++;
+            } else if( std::isspace(static_cast<unsigned char>(c)) ) {
+                location++;
+            } else {
+                break;
+            }
+        }
+        if( location >= length || !std::isdigit(static_cast<unsigned char>(header[location])) )
+            throw std::runtime_error("Bad PGM header");
+        uint32_t value = 0;
+        while( location < length && std::isdigit(static_cast<unsigned char>(header[location])) ) {
+            value = value*10 + static_cast<uint32_t>(header[location]-'0');
+            location++;
+        }
+        return value;
+    }
+}
+
+MappedImageBuffer::~MappedImageBuffer() {
+#if !defined(_WIN32)
+    if( pixels != nullptr )
+        munmap(pixels,bytes);
+#endif
+}
+
+std::shared_ptr<MappedImageBuffer> ImageMapping::mapFile( const std::string& path , bool writable ) {
+#if defined(_WIN32)
+    throw std::runtime_error("Memory mapped files are not supported on this platform");
+#else
+    int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+    if( fd < 0 )
+        throw std::runtime_error("Failed to open "+path);
+    struct stat info;
+    if( fstat(fd,&info) != 0 ) {
+        close(fd);
+        throw std::runtime_error("Failed to read the size of "+path);
+    }
+    // a private mapping is copy on write, so the pixels can be modified without changing the file
+    return map_descriptor(fd, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE,
+                          writable ? MAP_SHARED : MAP_PRIVATE, path);
+#endif
+}
+
+std::shared_ptr<MappedImageBuffer> ImageMapping::mapSharedMemory( const std::string& name , size_t bytes ,
+                                                                  bool writable ) {
+#if defined(_WIN32)
+    throw std::runtime_error("Shared memory is not supported on this platform");
+#else
+    int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if( fd < 0 )
+        throw std::runtime_error("Failed to open shared memory "+name);
+    struct stat info;
+    if( fstat(fd,&info) != 0 || static_cast<size_t>(info.st_size) < bytes ) {
+        close(fd);
+        throw std::runtime_error("Shared memory "+name+" is smaller than requested");
+    }
+    return map_descriptor(fd, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, name);
+#endif
+}
+
+Gray<U8> ImageMapping::mapPGM( const std::string& path , bool writable ) {
+    std::shared_ptr<MappedImageBuffer> mapping = mapFile(path,writable);
+    const char* header = static_cast<const char*>(mapping->pixels);
+    size_t length = mapping->bytes;
+
+    if( length < 2 || header[0] != 'P' || header[1] != '5' )
+        throw std::runtime_error("Not a binary PGM file: "+path);
+    size_t location = 2;
+    uint32_t width = read_header_number(header,length,location);
+    uint32_t height = read_header_number(header,length,location);
+    uint32_t max_value = read_header_number(header,length,location);
+    if( max_value > 255 )
+        throw std::runtime_error("Only 8-bit PGM files can be mapped");
+    // exactly one white space character comes before the pixels
+    location++;
+
+    return wrap<U8>(mapping,width,height,location);
+}
@@ -0,0 +1,124 @@
+#ifndef BOOFCPP_IMAGE_MAPPING_H
+#define BOOFCPP_IMAGE_MAPPING_H
+
+#include <memory>
+#include <string>
+
+#include "base_types.h"
+#include "image_types.h"
+
+namespace boofcv {
+
+    /**
+     * Memory which has been mapped into the process, e.g. a file or a shared memory segment. It's unmapped
+     * once the last image which references it is destroyed.
+     */
+    class MappedImageBuffer : public ImageBuffer {
+    public:
+        MappedImageBuffer( void* pixels , size_t bytes ) : ImageBuffer(pixels,bytes) {
+        }
+
+        ~MappedImageBuffer() override;
+    };
+
+    /**
+     * Wraps images around memory mapped files and shared memory without copying the pixels. The returned
+     * images are views, see Gray::wrap, which keep the mapping alive for as long as they or any of their
+     * sub-images exist.
+     *
+     * Mappings are read only by default. Pixels in a read only file mapping can still be modified, but the
+     * changes are private to the process and are never written to the file. Modifying a read only shared
+     * memory mapping will crash.
+     */
+    class ImageMapping {
+    public:
+        /**
+         * Maps an entire file into memory
+         *
+         * @param writable If true then changes to the pixels are written back to the file
+         */
+        static std::shared_ptr<MappedImageBuffer> mapFile( const std::string& path , bool writable = false );
+
+        /**
+         * Maps the first 'bytes' of a POSIX shared memory object, see shm_open(), into memory
+         *
+         * @param name Name of the shared memory object, e.g. "/camera0"
+         * @param bytes Number of bytes which are mapped. Must not be larger than the object.
+         * @param writable If true the memory is mapped with write access
+         */
+        static std::shared_ptr<MappedImageBuffer> mapSharedMemory( const std::string& name , size_t bytes ,
+                                                                   bool writable = false );
+
+        /**
+         * Creates a view of a gray scale image which is stored inside of a mapping.
+         *
+         * @param mapping The memory
+         * @param byte_offset Location of the first pixel in bytes. Must be aligned to the pixel size.
+         * @param stride Number of elements between the start of each row. If 0 then it's the same as width.
+         */
+        template<class T>
+        static Gray<T> wrap( const std::shared_ptr<MappedImageBuffer>& mapping , uint32_t width , uint32_t height ,
+                             size_t byte_offset = 0 , uint32_t stride = 0 ) {
+            T* data = locate<T>(*mapping,byte_offset,stride == 0 ? width : stride,width,height);
+            return Gray<T>::wrap(data,width,height,stride,mapping);
+        }
+
+        /**
+         * Creates a view of an interleaved image which is stored inside of a mapping. See {@link #wrap}.
+         */
+        template<class T>
+        static Interleaved<T> wrapInterleaved( const std::shared_ptr<MappedImageBuffer>& mapping ,
+                                               uint32_t width , uint32_t height , uint32_t num_bands ,
+                                               size_t byte_offset = 0 , uint32_t stride = 0 ) {
+            T* data = locate<T>(*mapping,byte_offset,stride == 0 ? width*num_bands : stride,
+                                width*num_bands,height);
+            return Interleaved<T>::wrap(data,width,height,num_bands,stride,mapping);
+        }
+
+        /**
+         * Maps a file which contains nothing but raw pixels, e.g. a frame dump, and creates a view of it
+         */
+        template<class T>
+        static Gray<T> mapRaw( const std::string& path , uint32_t width , uint32_t height ,
+                               size_t byte_offset = 0 , uint32_t stride = 0 , bool writable = false ) {
+            return wrap<T>(mapFile(path,writable),width,height,byte_offset,stride);
+        }
+
+        /**
+         * Maps a binary 8-bit PGM (P5) file and creates a view of its pixels
+         */
+        static Gray<U8> mapPGM( const std::string& path , bool writable = false );
+
+        /**
+         * Maps a gray scale image which has been written into shared memory by another process, e.g. a capture
+         * process, and creates a view of it
+         */
+        template<class T>
+        static Gray<T> mapSharedMemory( const std::string& name , uint32_t width , uint32_t height ,
+                                        size_t byte_offset = 0 , uint32_t stride = 0 , bool writable = false ) {
+            uint32_t s = stride == 0 ? width : stride;
+            size_t bytes = byte_offset + sizeof(T)*(static_cast<size_t>(s)*(height-1) + width);
+            return wrap<T>(mapSharedMemory(name,height == 0 ? byte_offset : bytes,writable),
+                           width,height,byte_offset,stride);
+        }
+
+    private:
+        /**
+         * Makes sure the image lies inside of the mapping and returns a pointer to its first pixel
+         */
+        template<class T>
+        static T* locate( const MappedImageBuffer& mapping , size_t byte_offset , uint32_t stride ,
+                          uint32_t row_length , uint32_t height ) {
+            if( stride < row_length )
+                throw invalid_argument("stride must be at least the length of a row");
+            if( byte_offset % sizeof(T) != 0 )
+                throw invalid_argument("byte_offset must be a multiple of the pixel size");
+            size_t elements = height == 0 ? 0 : static_cast<size_t>(stride)*(height-1) + row_length;
+            if( byte_offset + sizeof(T)*elements > mapping.bytes )
+                throw invalid_argument("Image extends past the end of the mapping");
+            return reinterpret_cast<T*>(static_cast<uint8_t*>(mapping.pixels) + byte_offset);
+        }
+    };
+}
+
+#endif
@@ -9,17 +9,9 @@ namespace boofcv {
     public:
         template<class E>
         static void fill( Gray<E>& image , E value ) {
-            if( image.subimage ) {
-                for( uint32_t y = 0; y < image.height; y++ ) {
-                    E *ptr = &image.data[image.offset + y*image.stride];
-                    E *end = &ptr[image.width];
-                    while (ptr != end) {
-                        *ptr++ = value;
-                    }
-                }
-            } else {
-                E *ptr = image.data;
-                E *end = &ptr[image.total_pixels()];
+            for( uint32_t y = 0; y < image.height; y++ ) {
+                E *ptr = &image.data[image.offset + y*image.stride];
+                E *end = &ptr[image.width];
                 while (ptr != end) {
                     *ptr++ = value;
                 }
@@ -60,10 +52,12 @@ namespace boofcv {
 
         template<class E>
         static void fill( Interleaved<E>& image , E value ) {
-            E* ptr = image.data;
-            E* end = &ptr[image.total_pixels()*image.num_bands];
-            while( ptr != end ) {
-                *ptr++ = value;
+            for( uint32_t y = 0; y < image.height; y++ ) {
+                E* ptr = &image.data[image.offset + y*image.stride];
+                E* end = &ptr[image.width*image.num_bands];
+                while( ptr != end ) {
+                    *ptr++ = value;
+                }
             }
         }
 
@@ -80,10 +74,12 @@ namespace boofcv {
 
             std::uniform_int_distribution<E> dis(min_value, max_value-1);
 
-            E* ptr = image.data;
-            E* end = &ptr[image.total_pixels()];
-            while( ptr != end ) {
-                *ptr++ = dis(rng);
+            for( uint32_t y = 0; y < image.height; y++ ) {
+                E* ptr = &image.data[image.offset + y*image.stride];
+                E* end = &ptr[image.width];
+                while( ptr != end ) {
+                    *ptr++ = dis(rng);
+                }
             }
         }
 
@@ -91,10 +87,12 @@ namespace boofcv {
         static void fill_uniform( Gray<E>& image , E min_value , E max_value , RNG& rng, typename std::enable_if<std::is_floating_point<E>::value >::type* = 0) {
             std::uniform_real_distribution<E> dis(min_value, max_value);
 
-            E* ptr = image.data;
-            E* end = &ptr[image.total_pixels()];
-            while( ptr != end ) {
-                *ptr++ = dis(rng);
+            for( uint32_t y = 0; y < image.height; y++ ) {
+                E* ptr = &image.data[image.offset + y*image.stride];
+                E* end = &ptr[image.width];
+                while( ptr != end ) {
+                    *ptr++ = dis(rng);
+                }
             }
         }
     };
@@ -0,0 +1,143 @@
+#ifndef BOOFCPP_IMAGE_POOL_H
+#define BOOFCPP_IMAGE_POOL_H
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "image_types.h"
+
+namespace boofcv {
+
+    /**
+     * Recycles the pixel arrays of images. Images which are allocated by the pool hand their pixels back to it
+     * when they are destroyed or reshaped, instead of to the heap. The next request for an array of the same
+     * size, i.e. the same pixel type and shape, gets the recycled array. Algorithms use it for scratch images
+     * which only live for a single frame, so once every shape has been seen a video loop doesn't allocate any
+     * more pixel memory. The counters can be used to check this.
+     *
+     * Thread safe. The pool must outlive every image it has allocated.
+     */
+    class ImagePool : public ImageAllocator {
+    public:
+        /**
+         * @param backing Allocator which new arrays come from. If null then the built in aligned allocator is used.
+         */
+        explicit ImagePool( ImageAllocator* backing = nullptr ) : backing(backing) {
+        }
+
+        ImagePool( const ImagePool& ) = delete;
+        ImagePool& operator=( const ImagePool& ) = delete;
+
+        ~ImagePool() override {
+            clear();
+        }
+
+        void* allocate( size_t bytes ) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<void*>& available = free_arrays[bytes];
+            void* ptr;
+            if( !available.empty() ) {
+                ptr = available.back();
+                available.pop_back();
+                cached_bytes -= bytes;
+                reused++;
+            } else {
+                ptr = getBacking().allocate(bytes);
+                heap_allocations++;
+            }
+            outstanding++;
+            return ptr;
+        }
+
+        void deallocate( void* ptr , size_t bytes ) override {
+            std::lock_guard<std::mutex> lock(mutex);
+            outstanding--;
+            free_arrays[bytes].push_back(ptr);
+            cached_bytes += bytes;
+        }
+
+        /**
+         * Creates a scratch image. Pixel values are not initialized.
+         */
+        template<class T>
+        Gray<T> gray( uint32_t width , uint32_t height , bool pad_rows = false ) {
+            return Gray<T>(width,height,ImageAllocation(pad_rows,false,this));
+        }
+
+        /**
+         * Creates a scratch image. Pixel values are not initialized.
+         */
+        template<class T>
+        Interleaved<T> interleaved( uint32_t width , uint32_t height , uint32_t num_bands , bool pad_rows = false ) {
+            return Interleaved<T>(width,height,num_bands,ImageAllocation(pad_rows,false,this));
+        }
+
+        /**
+         * Frees all the arrays which are not being used by an image
+         */
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for( auto& entry : free_arrays ) {
+                for( void* ptr : entry.second ) {
+                    getBacking().deallocate(ptr,entry.first);
+                }
+            }
+            free_arrays.clear();
+            cached_bytes = 0;
+        }
+
+        /**
+         * Sets the counters back to zero. Typically called after the first frame has been processed.
+         */
+        void resetCounters() {
+            std::lock_guard<std::mutex> lock(mutex);
+            heap_allocations = 0;
+            reused = 0;
+        }
+
+        // Number of arrays which had to be allocated from the backing allocator
+        uint64_t getHeapAllocations() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return heap_allocations;
+        }
+
+        // Number of requests which were filled with a recycled array
+        uint64_t getReused() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return reused;
+        }
+
+        // Number of arrays which are currently in use by images
+        uint64_t getOutstanding() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return outstanding;
+        }
+
+        // Total size of the arrays which are waiting to be reused
+        size_t getCachedBytes() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cached_bytes;
+        }
+
+    private:
+        ImageAllocator* backing;
+        AlignedImageAllocator aligned;
+        // arrays which can be reused. Key is the size in bytes
+        std::unordered_map<size_t,std::vector<void*>> free_arrays;
+
+        uint64_t heap_allocations = 0;
+        uint64_t reused = 0;
+        uint64_t outstanding = 0;
+        size_t cached_bytes = 0;
+
+        mutable std::mutex mutex;
+
+        ImageAllocator& getBacking() {
+            return backing == nullptr ? aligned : *backing;
+        }
+    };
+}
+
+#endif
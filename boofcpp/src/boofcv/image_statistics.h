@@ -2,8 +2,11 @@
 #define BOOFCPP_IMAGE_STATISTICS_H
 
 #include <limits>
+#include <mutex>
+#include <algorithm>
 #include "image_types.h"
 #include "base_types.h"
+#include "concurrency.h"
 
 namespace boofcv {
     class ImageStatistics {
@@ -12,12 +15,14 @@ namespace boofcv {
         static T min( const Gray<T>& input) {
             T min_value = std::numeric_limits<T>::max();
 
-            const T* ptr = input.data;
-            const T* end = &ptr[input.total_pixels()];
-            while( ptr != end ) {
-                const T& v = *ptr++;
-                if( v < min_value ) {
-                    min_value = v;
+            for( uint32_t y = 0; y < input.height; y++ ) {
+                const T* ptr = &input.data[input.offset + y*input.stride];
+                const T* end = &ptr[input.width];
+                while( ptr != end ) {
+                    const T& v = *ptr++;
+                    if( v < min_value ) {
+                        min_value = v;
+                    }
                 }
             }
 
@@ -28,12 +33,14 @@ namespace boofcv {
         static T max( const Gray<T>& input) {
             T max_value = std::numeric_limits<T>::min();
 
-            const T* ptr = input.data;
-            const T* end = &ptr[input.total_pixels()];
-            while( ptr != end ) {
-                const T& v = *ptr++;
-                if( v > max_value ) {
-                    max_value = v;
+            for( uint32_t y = 0; y < input.height; y++ ) {
+                const T* ptr = &input.data[input.offset + y*input.stride];
+                const T* end = &ptr[input.width];
+                while( ptr != end ) {
+                    const T& v = *ptr++;
+                    if( v > max_value ) {
+                        max_value = v;
+                    }
                 }
             }
 
@@ -72,6 +79,110 @@ namespace boofcv {
                 }
             }
         }
+
+        /**
+         * Same as {@link #min} but bands of rows are processed concurrently
+         */
+        template<class T>
+        static T min( const Gray<T>& input, const ConcurrencyContext& context ) {
+            T min_value = std::numeric_limits<T>::max();
+            std::mutex mutex;
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                T band_value = std::numeric_limits<T>::max();
+                for( uint32_t y = y0; y < y1; y++ ) {
+                    const T* ptr = &input.data[input.offset + y*input.stride];
+                    const T* end = ptr + input.width;
+                    while( ptr != end ) {
+                        const T& v = *ptr++;
+                        if( v < band_value ) {
+                            band_value = v;
+                        }
+                    }
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                min_value = std::min(min_value,band_value);
+            });
+
+            return min_value;
+        }
+
+        /**
+         * Same as {@link #max} but bands of rows are processed concurrently
+         */
+        template<class T>
+        static T max( const Gray<T>& input, const ConcurrencyContext& context ) {
+            T max_value = std::numeric_limits<T>::min();
+            std::mutex mutex;
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                T band_value = std::numeric_limits<T>::min();
+                for( uint32_t y = y0; y < y1; y++ ) {
+                    const T* ptr = &input.data[input.offset + y*input.stride];
+                    const T* end = ptr + input.width;
+                    while( ptr != end ) {
+                        const T& v = *ptr++;
+                        if( v > band_value ) {
+                            band_value = v;
+                        }
+                    }
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                max_value = std::max(max_value,band_value);
+            });
+
+            return max_value;
+        }
+
+        /**
+         * Same as {@link #sum} but bands of rows are processed concurrently. With floating point images the
+         * order values are added in changes, so the results can differ by round off error.
+         */
+        template<class T>
+        static typename TypeInfo<T>::sum_type sum( const Gray<T>& input, const ConcurrencyContext& context ) {
+            typedef typename TypeInfo<T>::sum_type sum_type;
+            sum_type total = 0;
+            std::mutex mutex;
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                Gray<T> band = input.makeSubimage(0,y0,input.width,y1);
+                sum_type band_total = sum(band);
+                std::lock_guard<std::mutex> lock(mutex);
+                total += band_total;
+            });
+            return total;
+        }
+
+        /**
+         * Same as {@link #mean} but bands of rows are processed concurrently
+         */
+        template<class T>
+        static T mean( const Gray<T>& input, const ConcurrencyContext& context ) {
+            typename TypeInfo<T>::sum_type a = sum(input,context);
+            return static_cast<T>(a / (input.width * input.height));
+        }
+
+        /**
+         * Same as {@link #histogram} but bands of rows are processed concurrently. Each band fills in its own
+         * histogram, which are then added together.
+         */
+        template<class T>
+        static void histogram( const Gray<T>& input , T minValue , GrowArray<uint32_t>& histogram ,
+                               const ConcurrencyContext& context ) {
+            histogram.fill(0);
+            std::mutex mutex;
+
+            concurrent_rows(context,input.height,[&](uint32_t y0, uint32_t y1){
+                GrowArray<uint32_t> band_histogram(histogram.size);
+                Gray<T> band = input.makeSubimage(0,y0,input.width,y1);
+                ImageStatistics::histogram(band,minValue,band_histogram);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                for( uint32_t i = 0; i < histogram.size; i++ ) {
+                    histogram[i] += band_histogram[i];
+                }
+            });
+        }
     };
 }
 
@@ -0,0 +1,207 @@
+#ifndef BOOFCPP_IMAGE_STREAM_H
+#define BOOFCPP_IMAGE_STREAM_H
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#include "image_types.h"
+#include "image_misc_ops.h"
+#include "convolve.h"
+#include "binary_ops.h"
+
+namespace boofcv {
+
+    /**
+     * Applies a filter to an image which arrives as a sequence of strips, e.g. from a line scan camera. The caller
+     * pushes strips from top to bottom and output rows are passed to the consumer as soon as the input rows
+     * they depend on have arrived. Only the rows which are still needed are kept, so memory is proportional to
+     * the strip height plus the filter's radius and not to the image's height.
+     *
+     * The filter must be one where output row y only depends on input rows y-radius to y+radius and on where the
+     * top and bottom of the image are, e.g. a convolution, binary morphology or a per pixel operation. It's
+     * applied to a window of rows and only the rows which aren't affected by the window's edges are kept.
+     * That way the output is identical to filtering the whole image. The cost is that the 2*radius rows
+     * which overlap between windows are filtered twice.
+     *
+     * @tparam I Input pixel type
+     * @tparam O Output pixel type
+     */
+    template<class I, class O>
+    class RowStream {
+    public:
+        // Filters the whole input image. The output must be reshaped to the same shape as the input.
+        typedef std::function<void(const Gray<I>& input, Gray<O>& output)> Filter;
+        // Receives finished output rows. 'y0' is the row in the full image of the first row
+        typedef std::function<void(const Gray<O>& rows, uint32_t y0)> Consumer;
+
+        /**
+         * @param radius Number of rows above and below an output row which the filter reads
+         * @param filter The filter
+         * @param consumer Receives the output rows
+         */
+        RowStream( uint32_t radius , Filter filter , Consumer consumer ) :
+                radius(radius), filter(std::move(filter)), consumer(std::move(consumer)) {
+        }
+
+        /**
+         * Adds the next strip of rows. Every strip must have the same width.
+         */
+        void push( const Gray<I>& strip ) {
+            if( finished )
+                throw invalid_argument("The image has been finished. Call reset() to start a new image");
+            if( strip.height == 0 )
+                return;
+            if( received == 0 )
+                width = strip.width;
+            else if( strip.width != width )
+                throw invalid_argument("All strips must have the same width");
+
+            uint32_t rows = window_rows + strip.height;
+            window.reserve(width,rows);
+            window.reshape(width,rows);
+            window.makeSubimage(0,window_rows,width,rows).copy(strip);
+            window_rows = rows;
+            received += strip.height;
+
+            if( received > radius )
+                emit(received - radius);
+        }
+
+        /**
+         * Called after the last strip. The remaining rows at the bottom of the image are passed to the consumer.
+         */
+        void finish() {
+            if( finished )
+                return;
+            finished = true;
+            emit(received);
+        }
+
+        /**
+         * Discards all the rows so that a new image can be processed. Memory is kept.
+         */
+        void reset() {
+            received = 0;
+            emitted = 0;
+            window_y0 = 0;
+            window_rows = 0;
+            finished = false;
+        }
+
+        // Number of input rows pushed so far
+        uint32_t getRowsReceived() const {
+            return received;
+        }
+
+        // Number of output rows passed to the consumer so far
+        uint32_t getRowsEmitted() const {
+            return emitted;
+        }
+
+        // Number of input rows currently being held
+        uint32_t getRowsBuffered() const {
+            return window_rows;
+        }
+
+    private:
+        uint32_t radius;
+        Filter filter;
+        Consumer consumer;
+
+        uint32_t width = 0;
+        uint32_t received = 0;
+        uint32_t emitted = 0;
+        bool finished = false;
+
+        // input rows which are still needed. Row 0 is row window_y0 in the image.
+        Gray<I> window;
+        uint32_t window_y0 = 0;
+        uint32_t window_rows = 0;
+        // filtered window
+        Gray<O> output;
+
+        /**
+         * Computes output rows up to y1 (exclusive) and passes them to the consumer
+         */
+        void emit( uint32_t y1 ) {
+            uint32_t y0 = emitted;
+            if( y1 <= y0 )
+                return;
+
+            // input rows which are read. Rows next to the window's edges are only correct at the image's edges
+            uint32_t n0 = y0 > radius ? y0 - radius : 0;
+            uint32_t n1 = std::min(received, y1 + radius);
+
+            Gray<I> input_rows = window.makeSubimage(0,n0-window_y0,width,n1-window_y0);
+            filter(input_rows,output);
+            consumer(output.makeSubimage(0,y0-n0,width,y1-n0),y0);
+            emitted = y1;
+
+            // throw away rows which the next output rows don't read
+            uint32_t keep0 = y1 > radius ? y1 - radius : 0;
+            uint32_t discard = keep0 - window_y0;
+            if( discard > 0 ) {
+                window_rows -= discard;
+                std::memmove(window.data, &window.data[discard*window.stride], sizeof(I)*window_rows*window.stride);
+                window.reshape(width,window_rows);
+                window_y0 = keep0;
+            }
+        }
+    };
+
+    /**
+     * Creates streaming versions of common filters. See {@link RowStream}.
+     */
+    class FactoryRowStream {
+    public:
+        /**
+         * Streaming version of ThresholdOps::threshold
+         */
+        template<class T>
+        static RowStream<T,U8> threshold( T threshold , bool down , typename RowStream<T,U8>::Consumer consumer ) {
+            return RowStream<T,U8>(0,[threshold,down](const Gray<T>& input, Gray<U8>& output){
+                ThresholdOps::threshold(input,threshold,down,output);
+            },std::move(consumer));
+        }
+
+        /**
+         * Streaming version of ConvolveNormalized::convolve. The kernel is applied horizontally then vertically.
+         */
+        template<class E>
+        static RowStream<E,E> convolve( const Kernel1D<typename TypeInfo<E>::signed_type>& kernel ,
+                                        typename RowStream<E,E>::Consumer consumer ) {
+            typedef Kernel1D<typename TypeInfo<E>::signed_type> Kernel;
+            std::shared_ptr<Kernel> copy(new Kernel());
+            *copy = kernel;
+            uint32_t radius = std::max(kernel.offset,kernel.width-kernel.offset-1);
+            return RowStream<E,E>(radius,[copy](const Gray<E>& input, Gray<E>& output){
+                ConvolveNormalized::convolve(*copy,input,output);
+            },std::move(consumer));
+        }
+
+        /**
+         * Streaming version of BinaryImageOps::erode4. Pixels along the image border are set to zero.
+         */
+        static RowStream<U8,U8> erode4( RowStream<U8,U8>::Consumer consumer ) {
+            return RowStream<U8,U8>(1,[](const Gray<U8>& input, Gray<U8>& output){
+                output.reshape(input.width,input.height);
+                ImageMiscOps::fill_border(output,(U8)0,1);
+                BinaryImageOps::erode4(input,output);
+            },std::move(consumer));
+        }
+
+        /**
+         * Streaming version of BinaryImageOps::dilate4. Pixels along the image border are set to zero.
+         */
+        static RowStream<U8,U8> dilate4( RowStream<U8,U8>::Consumer consumer ) {
+            return RowStream<U8,U8>(1,[](const Gray<U8>& input, Gray<U8>& output){
+                output.reshape(input.width,input.height);
+                ImageMiscOps::fill_border(output,(U8)0,1);
+                BinaryImageOps::dilate4(input,output);
+            },std::move(consumer));
+        }
+    };
+}
+
+#endif
@@ -1,19 +1,177 @@
 #ifndef BOOFCPP_IMAGE_TYPES_H
 #define BOOFCPP_IMAGE_TYPES_H
 
+#include <atomic>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 using namespace std;
 
-// TODO Design issue. What happens if the parent of a subimage is deleted or resized? The subimage will now
-//      point to bad data. Would be nice if this was caught and prevented
+// Pixel arrays are aligned to this many bytes. Large enough for aligned AVX2 loads and a full cache line.
+#ifndef BOOFCPP_IMAGE_ALIGNMENT
+#define BOOFCPP_IMAGE_ALIGNMENT 64
+#endif
+
+// If true, accessing a sub-image after the image it came from has been reshaped throws an exception.
+// On by default in debug builds.
+#ifndef BOOFCPP_CHECK_SUBIMAGES
+#ifdef NDEBUG
+#define BOOFCPP_CHECK_SUBIMAGES 0
+#else
+#define BOOFCPP_CHECK_SUBIMAGES 1
+#endif
+#endif
 
 namespace boofcv {
 
+    /**
+     * Allocates the pixel arrays inside of images. Images use {@link #getDefault} unless they are given a
+     * different allocator, which makes it possible to track or recycle image memory.
+     */
+    class ImageAllocator {
+    public:
+        virtual ~ImageAllocator() = default;
+
+        /**
+         * Allocates memory which is aligned to BOOFCPP_IMAGE_ALIGNMENT bytes. Throws std::bad_alloc on failure.
+         */
+        virtual void* allocate( size_t bytes ) = 0;
+
+        /**
+         * Frees memory returned by {@link #allocate}. 'bytes' is the same value it was allocated with.
+         */
+        virtual void deallocate( void* ptr , size_t bytes ) = 0;
+
+        /**
+         * Allocator used by images which haven't been assigned one
+         */
+        static ImageAllocator& getDefault();
+
+        /**
+         * Changes the default allocator. Memory is always freed by the allocator which allocated it, so
+         * existing images are not affected.
+         *
+         * @param allocator The new default. If null then the built in aligned allocator is used.
+         */
+        static void setDefault( ImageAllocator* allocator ) {
+            defaultPointer() = allocator;
+        }
+
+    private:
+        static ImageAllocator*& defaultPointer() {
+            static ImageAllocator* allocator = nullptr;
+            return allocator;
+        }
+    };
+
+    /**
+     * The built in allocator. Allocates memory from the heap aligned to BOOFCPP_IMAGE_ALIGNMENT bytes.
+     */
+    class AlignedImageAllocator : public ImageAllocator {
+    public:
+        void* allocate( size_t bytes ) override {
+            void* ptr = nullptr;
+#if defined(_WIN32)
+            ptr = _aligned_malloc(bytes == 0 ? 1 : bytes, BOOFCPP_IMAGE_ALIGNMENT);
+#else
+            if( posix_memalign(&ptr, BOOFCPP_IMAGE_ALIGNMENT, bytes == 0 ? 1 : bytes) != 0 )
+                ptr = nullptr;
+#endif
+            if( ptr == nullptr )
+                throw std::bad_alloc();
+            return ptr;
+        }
+
+        void deallocate( void* ptr , size_t /*bytes*/ ) override {
+#if defined(_WIN32)
+            _aligned_free(ptr);
+#else
+            free(ptr);
+#endif
+        }
+    };
+
+    inline ImageAllocator& ImageAllocator::getDefault() {
+        static AlignedImageAllocator aligned;
+        ImageAllocator* allocator = defaultPointer();
+        return allocator == nullptr ? aligned : *allocator;
+    }
+
+    /**
+     * Pixel array which is shared between an image and all the sub-images created from it. The memory is freed
+     * once the last image which references it is destroyed, so a sub-image remains safe to use after its
+     * parent has been destroyed or has moved onto a larger array.
+     */
+    class ImageBuffer {
+    public:
+        void* const pixels;
+        const size_t bytes;
+        // Incremented each time the owning image changes shape. Sub-images created before then are stale.
+        std::atomic<uint32_t> generation{0};
+
+        ImageBuffer( void* pixels , size_t bytes ) : pixels(pixels), bytes(bytes) {
+        }
+
+        ImageBuffer( const ImageBuffer& ) = delete;
+        ImageBuffer& operator=( const ImageBuffer& ) = delete;
+
+        virtual ~ImageBuffer() = default;
+    };
+
+    /**
+     * Pixel array which was allocated by an ImageAllocator
+     */
+    class AllocatedImageBuffer : public ImageBuffer {
+    public:
+        ImageAllocator& allocator;
+
+        AllocatedImageBuffer( ImageAllocator& allocator , size_t bytes ) :
+                ImageBuffer(allocator.allocate(bytes),bytes), allocator(allocator) {
+        }
+
+        ~AllocatedImageBuffer() override {
+            allocator.deallocate(pixels,bytes);
+        }
+    };
+
+    /**
+     * Specifies how an image allocates its pixels.
+     */
+    struct ImageAllocation {
+        // Allocates the pixels. If null then ImageAllocator::getDefault() is used
+        ImageAllocator* allocator;
+        // If true the stride is rounded up so that every row starts on a BOOFCPP_IMAGE_ALIGNMENT byte boundary.
+        // That way each row can be processed with aligned SIMD loads and rows don't share cache lines.
+        bool pad_rows;
+        // If true new pixels are set to zero, both when the image is created and when reshape() grows it.
+        // Turn off when every pixel is about to be overwritten.
+        bool zero;
+
+        explicit ImageAllocation( bool pad_rows = false , bool zero = true , ImageAllocator* allocator = nullptr )
+                : allocator(allocator), pad_rows(pad_rows), zero(zero) {}
+
+        /**
+         * Pixels are not initialized.
+         */
+        static ImageAllocation uninitialized( bool pad_rows = false ) {
+            return ImageAllocation(pad_rows,false);
+        }
+
+        /**
+         * Each row is aligned and starts on its own cache line.
+         */
+        static ImageAllocation padded( bool zero = true ) {
+            return ImageAllocation(true,zero);
+        }
+    };
+
     /**
      * Base class for all image types
      */
@@ -25,6 +183,13 @@ namespace boofcv {
         uint32_t stride;
         bool subimage;
 
+        // Allocates the pixels. If null then ImageAllocator::getDefault() is used.
+        ImageAllocator* allocator = nullptr;
+        // If true the stride is rounded up so that each row starts on a BOOFCPP_IMAGE_ALIGNMENT byte boundary
+        bool pad_rows = false;
+        // If true arrays allocated by the constructor or when the image grows are filled with zeros
+        bool zero_pixels = true;
+
         ImageBase() {
             this->width = 0;
             this->height = 0;
@@ -32,6 +197,9 @@ namespace boofcv {
             this->subimage = false;
         }
 
+        // allows an image to be deleted through a pointer to one of its base classes
+        virtual ~ImageBase() = default;
+
         /**
          * Total number of pixels in the image
          */
@@ -48,7 +216,8 @@ namespace boofcv {
         }
 
         /**
-         * Changes the image's shapes. Value of pixels after this function is called is undefined.
+         * Changes the image's shapes. Value of pixels after this function is called is undefined, except
+         * that if the pixel array had to grow it's filled with zeros unless zero_pixels is false.
          * @param width New image width
          * @param height New image height
          */
@@ -68,6 +237,118 @@ namespace boofcv {
     public:
         // data type of a pixel value
         typedef _PT pixel_type;
+
+        /**
+         * Returns false if this is a sub-image and the image it came from has been reshaped since it was
+         * created. Its pixels are still valid memory but no longer line up with the parent's pixels.
+         */
+        bool isValid() const {
+            return !buffer || buffer->generation.load(std::memory_order_relaxed) == generation;
+        }
+
+    protected:
+        // Pixel array owned by this image or shared with the image this sub-image came from. Null if the
+        // pixels belong to someone else, e.g. a wrapped array.
+        std::shared_ptr<ImageBuffer> buffer;
+        // value of buffer->generation when this image was created or last reshaped
+        uint32_t generation = 0;
+
+        void setAllocation( const ImageAllocation& allocation ) {
+            this->allocator = allocation.allocator;
+            this->pad_rows = allocation.pad_rows;
+            this->zero_pixels = allocation.zero;
+        }
+
+        /**
+         * Number of elements between the start of each row for a row with 'length' elements
+         */
+        uint32_t strideFor( uint32_t length ) const {
+            if( !this->pad_rows )
+                return length;
+            const uint32_t elements = BOOFCPP_IMAGE_ALIGNMENT/sizeof(_PT);
+            return (length + elements - 1)/elements*elements;
+        }
+
+        /**
+         * Allocates an aligned array for the pixels. The previous array is released.
+         */
+        _PT* allocatePixels( uint32_t length , bool zero ) {
+            buffer.reset();
+            generation = 0;
+            if( length == 0 )
+                return nullptr;
+            ImageAllocator& a = this->allocator == nullptr ? ImageAllocator::getDefault() : *this->allocator;
+            buffer = std::make_shared<AllocatedImageBuffer>(a,sizeof(_PT)*length);
+            auto* pixels = static_cast<_PT*>(buffer->pixels);
+            if( zero )
+                std::memset(pixels,0,sizeof(_PT)*length);
+            return pixels;
+        }
+
+        /**
+         * Releases this image's reference to the pixels. They are freed once no sub-image references them.
+         */
+        void freePixels() {
+            buffer.reset();
+            generation = 0;
+        }
+
+        /**
+         * Moves the pixels into a larger array. The old pixel values are copied over.
+         */
+        _PT* reallocatePixels( const _PT* pixels , uint32_t length , uint32_t desired ) {
+            std::shared_ptr<ImageBuffer> old = buffer;
+            _PT* larger = allocatePixels(desired,false);
+            if( pixels != nullptr )
+                std::memcpy(larger,pixels,sizeof(_PT)*length);
+            if( this->zero_pixels )
+                std::memset(larger+length,0,sizeof(_PT)*(desired-length));
+            if( old )
+                old->generation++;
+            return larger;
+        }
+
+        /**
+         * Called when the shape of an image changes. Sub-images created before now will no longer be valid.
+         */
+        void invalidateSubimages() {
+            if( buffer )
+                generation = ++buffer->generation;
+        }
+
+        /**
+         * Makes 'view' reference the same pixel array as this image
+         */
+        void shareBuffer( ImageBaseT<_PT>& view ) const {
+            view.buffer = buffer;
+            view.generation = generation;
+        }
+
+        /**
+         * Throws an exception if sub-image checks are enabled and this sub-image is stale
+         */
+        void checkSubimage() const {
+#if BOOFCPP_CHECK_SUBIMAGES
+            if( !isValid() )
+                throw logic_error("Sub-image is stale. Its parent was reshaped after it was created");
+#endif
+        }
+
+        /**
+         * Swaps the shape and allocation settings with another image. Used to implement swap() and moves.
+         */
+        void swapBase( ImageBaseT<_PT>& other ) noexcept {
+            std::swap(this->width,other.width);
+            std::swap(this->height,other.height);
+            std::swap(this->offset,other.offset);
+            std::swap(this->stride,other.stride);
+            std::swap(this->subimage,other.subimage);
+            std::swap(this->allocator,other.allocator);
+            std::swap(this->pad_rows,other.pad_rows);
+            std::swap(this->zero_pixels,other.zero_pixels);
+            std::swap(this->buffer,other.buffer);
+            std::swap(this->generation,other.generation);
+        }
     };
 
 
@@ -84,13 +365,20 @@ namespace boofcv {
         // length of the array. This might be larger than the number of elements in the image because of reshaping
         uint32_t data_length;
 
-        Gray( uint32_t width , uint32_t height ) {
+        Gray( uint32_t width , uint32_t height ) : Gray(width,height,ImageAllocation()) {
+        }
+
+        /**
+         * Creates an image with the specified allocator, row padding and initialization
+         */
+        Gray( uint32_t width , uint32_t height , const ImageAllocation& allocation ) {
+            this->setAllocation(allocation);
             this->width = width;
             this->height = height;
-            this->data = new T[width*height]();
-            this->data_length = width*height;
             this->offset = 0;
-            this->stride = width;
+            this->stride = this->strideFor(width);
+            this->data_length = this->stride*height;
+            this->data = this->allocatePixels(this->data_length,allocation.zero);
             this->subimage = false;
         }
 
@@ -107,6 +395,28 @@ namespace boofcv {
             this->subimage = true;
         }
 
+        /**
+         * Creates a view of pixels which belong to someone else, e.g. a frame in shared memory or a memory mapped
+         * file. Nothing is copied and the image never frees the pixels. Views can't be reshaped, but reshaping
+         * to the same shape does nothing so a view can be passed to algorithms as their output.
+         *
+         * @param data Pointer to the first pixel
+         * @param stride Number of elements between the start of each row. If 0 then it's the same as width.
+         * @param owner (Optional) Owner of the pixels. The view and its sub-images keep it alive.
+         */
+        static Gray<T> wrap( T* data , uint32_t width , uint32_t height , uint32_t stride = 0 ,
+                             std::shared_ptr<ImageBuffer> owner = nullptr ) {
+            if( stride == 0 )
+                stride = width;
+            else if( stride < width )
+                throw invalid_argument("stride must be at least the width");
+            Gray<T> view(data,stride*height,width,height,0,stride);
+            view.buffer = std::move(owner);
+            if( view.buffer )
+                view.generation = view.buffer->generation;
+            return view;
+        }
+
         Gray(std::initializer_list<std::initializer_list<T>> l ){
             this->height = static_cast<uint32_t >(l.size());
 
@@ -115,12 +425,12 @@ namespace boofcv {
             } else {
                 this->width = static_cast<uint32_t >(l.begin()->size());
             }
-            this->data = new T[this->width*this->height]();
             this->data_length = this->width*this->height;
+            this->data = this->allocatePixels(this->data_length,false);
             this->offset = 0;
             this->stride = this->width;
             this->subimage = false;
-            
+
             T* ptr = this->data;
             for (auto& x : l ) {
                 if( x.size() != this->width ) {
@@ -135,10 +445,24 @@ namespace boofcv {
         Gray() : Gray(0,0) {
         }
 
+        /**
+         * Copies a sub-image by referencing the same pixels. Any other image is deep copied using the same
+         * allocator and row padding. Same behavior as the copy assignment.
+         */
+        Gray( const Gray<T>& other ) : Gray(0,0,ImageAllocation(other.pad_rows,other.zero_pixels,other.allocator)) {
+            *this = other;
+        }
+
+        /**
+         * Takes ownership of the other image's pixels. The other image is left as an empty image.
+         */
+        Gray( Gray<T>&& other ) noexcept : Gray(nullptr,0,0,0,0,0) {
+            this->subimage = false;
+            swap(other);
+        }
+
         ~Gray() {
-            if( !this->subimage ) {
-                delete[]this->data;
-            }
+            this->freePixels();
             this->width = 0;
             this->height = 0;
             this->data_length = 0;
@@ -153,21 +477,51 @@ namespace boofcv {
             else if( this->subimage ) {
                 throw invalid_argument("Can't reshape a subimage");
             }
+            this->invalidateSubimages();
 
-            uint32_t desired_length = width*height;
+            uint32_t stride = this->strideFor(width);
+            uint32_t desired_length = stride*height;
             if( desired_length > this->data_length ) {
-                delete []this->data;
-                this->data = new T[desired_length]();
+                this->freePixels();
+                this->data = nullptr;
+                this->data_length = 0;
+                this->data = this->allocatePixels(desired_length,this->zero_pixels);
                 this->data_length = desired_length;
             }
             this->width = width;
             this->height = height;
-            this->stride = width;
+            this->stride = stride;
+        }
+
+        /**
+         * Grows the pixel array so that the image can be reshaped to any size up to width x height without
+         * allocating memory. The image's shape and pixel values are not modified.
+         */
+        void reserve( uint32_t width , uint32_t height ) {
+            if( this->subimage ) {
+                throw invalid_argument("Can't reserve a subimage");
+            }
+            uint32_t desired_length = this->strideFor(width)*height;
+            if( desired_length <= this->data_length )
+                return;
+
+            this->data = this->reallocatePixels(this->data,this->data_length,desired_length);
+            this->data_length = desired_length;
+        }
+
+        /**
+         * Swaps the pixels, shape and allocation settings of the two images without copying any pixels
+         */
+        void swap( Gray<T>& other ) noexcept {
+            std::swap(this->data,other.data);
+            std::swap(this->data_length,other.data_length);
+            this->swapBase(other);
         }
 
         T& at( uint32_t x , uint32_t y ) const {
             if( x >= this->width || y >= this->height )
                 throw invalid_argument("out of range");
+            this->checkSubimage();
             return data[this->offset + y*this->stride + x];
         }
 
@@ -187,10 +541,17 @@ namespace boofcv {
             }
         }
 
+        /**
+         * Creates a sub-image which references this image's pixels. The sub-image keeps the pixels alive
+         * even if this image is destroyed or reshaped, so it can be safely handed to another thread.
+         */
         Gray<T> makeSubimage( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 ) const {
             if( x1 > this->width || y1 > this->height || x1 < x0 || y1 < y0 )
                 throw invalid_argument("Bounds are illegal");
-            return Gray<T>(this->data,this->data_length,x1-x0,y1-y0,this->offset + y0*this->stride+x0, this->stride );
+            this->checkSubimage();
+            Gray<T> sub(this->data,this->data_length,x1-x0,y1-y0,this->offset + y0*this->stride+x0, this->stride );
+            this->shareBuffer(sub);
+            return sub;
         }
 
         uint32_t index_of( uint32_t x , uint32_t y ) const {
@@ -201,6 +562,7 @@ namespace boofcv {
         {
             if (this != &other) { // self-assignment check expected
                 if( other.subimage ) {
+                    other.shareBuffer(*this);
                     this->data = other.data;
                     this->data_length = other.data_length;
                     this->width = other.width;
@@ -214,8 +576,30 @@ namespace boofcv {
             }
             return *this;
         }
+
+        /**
+         * Move assignment. The pixels are handed over without being copied, unless this is a sub-image and
+         * the other image isn't. Then the pixels are copied into the sub-image, just like the copy assignment.
+         */
+        Gray<T>& operator=(Gray<T>&& other)
+        {
+            if (this != &other) {
+                if( this->subimage && !other.subimage ) {
+                    this->copy(other);
+                } else {
+                    // the other image frees this image's old pixels when it's destroyed
+                    swap(other);
+                }
+            }
+            return *this;
+        }
     };
 
+    template<class T>
+    void swap( Gray<T>& a , Gray<T>& b ) noexcept {
+        a.swap(b);
+    }
+
     /**
      * Planar image. Each band in a planar image is a Gray image.
      * @tparam T A Gray image.
@@ -223,36 +607,47 @@ namespace boofcv {
     template<class T>
     class Planar : public ImageBaseT<typename T::pixel_type> {
     public:
-        T** bands;
+        // Each band is allocated separately so references to a band remain valid when bands are added or removed
+        std::vector<std::unique_ptr<T>> bands;
         uint32_t num_bands;
 
-        Planar( uint32_t width , uint32_t height , uint32_t num_bands ) {
+        Planar( uint32_t width , uint32_t height , uint32_t num_bands ) :
+                Planar(width,height,num_bands,ImageAllocation()) {
+        }
+
+        /**
+         * Creates an image with the specified allocator, row padding and initialization. Applies to every band.
+         */
+        Planar( uint32_t width , uint32_t height , uint32_t num_bands , const ImageAllocation& allocation ) {
+            this->setAllocation(allocation);
             this->width = width;
             this->height = height;
             this->offset = 0;
-            this->stride = width;
+            this->stride = this->strideFor(width);
             this->subimage = false;
 
             this->num_bands = num_bands;
-            bands = new T*[this->num_bands];
+            bands.reserve(num_bands);
             for( uint32_t i = 0; i < this->num_bands; i++ ) {
-                bands[i] = new T(width,height);
+                bands.emplace_back(new T(width,height,allocation));
             }
         }
 
         Planar() : Planar(0,0,0) {
         }
 
-        ~Planar() {
-            this->width = 0;
-            this->height = 0;
-            this->offset = 0;
-            this->stride = 0;
-            for( uint32_t i = 0; i < num_bands; i++ ) {
-                delete bands;
-            }
-            delete []bands;
-            bands = NULL;
+        /**
+         * Deep copy of every band using the same allocator and row padding
+         */
+        Planar( const Planar<T>& other ) : Planar(0,0,0,ImageAllocation(other.pad_rows,other.zero_pixels,other.allocator)) {
+            setTo(other);
+        }
+
+        /**
+         * Takes ownership of the other image's bands. The other image is left as an empty image.
+         */
+        Planar( Planar<T>&& other ) noexcept : Planar() {
+            swap(other);
         }
 
         void reshape( uint32_t width , uint32_t height ) override {
@@ -264,36 +659,37 @@ namespace boofcv {
             }
             this->width = width;
             this->height = height;
-            this->stride = width;
+            this->stride = this->strideFor(width);
+        }
+
+        /**
+         * Grows every band so that the image can be reshaped to any size up to width x height without
+         * allocating memory. The image's shape and pixel values are not modified.
+         */
+        void reserve( uint32_t width , uint32_t height ) {
+            if( this->subimage ) {
+                throw invalid_argument("Can't reserve a subimage");
+            }
+            for( uint32_t i = 0; i < num_bands; i++ ) {
+                bands[i]->reserve(width,height);
+            }
         }
 
         void setNumberOfBands( uint32_t desired ) {
-            T* new_bands;
-            if( desired > this->num_bands ) {
-                new_bands = new T*[desired];
-                for( uint32_t i = 0; i < this->num_bands; i++ ) {
-                    new_bands[i] = this->bands[i];
-                }
+            if( desired == this->num_bands )
+                return;
+            if( desired < this->num_bands ) {
+                bands.resize(desired);
+            } else {
+                bands.reserve(desired);
                 for( uint32_t i = num_bands; i < desired; i++ ) {
-                    new_bands[i] = new T(this->width,this->height);
+                    bands.emplace_back(new T(this->width,this->height,ImageAllocation(this->pad_rows,this->zero_pixels,this->allocator)));
                 }
-            } else if( desired < this->num_bands ) {
-                new_bands = new T*[desired];
-                for( uint32_t i = 0; i < desired; i++ ) {
-                    new_bands[i] = this->bands[i];
-                }
-                for( uint32_t i = desired; i < this->num_bands; i++ ) {
-                    delete this->bands[i];
-                }
-            } else {
-                return;
             }
-            delete []this->bands;
-            this->bands = new_bands;
             this->num_bands = desired;
         }
 
-        T& at( uint32_t x , uint32_t y , uint32_t band ) const {
+        typename T::pixel_type& at( uint32_t x , uint32_t y , uint32_t band ) const {
             if( band >= this->num_bands )
                 throw invalid_argument("Band out of range");
 
@@ -308,7 +704,7 @@ namespace boofcv {
             }
             setNumberOfBands(src.num_bands);
             for( uint32_t i = 0; i < this->num_bands; i++ ) {
-                this->bands[i]->setTo(src.bands[i]);
+                this->bands[i]->copy(*src.bands[i]);
             }
         }
 
@@ -317,8 +713,38 @@ namespace boofcv {
                 throw invalid_argument("Requested an out of bounds band");
             return *(this->bands[which]);
         }
+
+        /**
+         * Swaps the bands, shape and allocation settings of the two images without copying any pixels
+         */
+        void swap( Planar<T>& other ) noexcept {
+            std::swap(this->bands,other.bands);
+            std::swap(this->num_bands,other.num_bands);
+            this->swapBase(other);
+        }
+
+        Planar<T>& operator=(const Planar<T>& other)
+        {
+            if (this != &other) {
+                setTo(other);
+            }
+            return *this;
+        }
+
+        Planar<T>& operator=(Planar<T>&& other) noexcept
+        {
+            if (this != &other) {
+                swap(other);
+            }
+            return *this;
+        }
     };
 
+    template<class T>
+    void swap( Planar<T>& a , Planar<T>& b ) noexcept {
+        a.swap(b);
+    }
+
     /**
      * Banded interleaved image
      *
@@ -335,14 +761,22 @@ namespace boofcv {
         // number of bands in the image
         uint32_t num_bands;
 
-        Interleaved( uint32_t width , uint32_t height , uint32_t num_bands ) {
+        Interleaved( uint32_t width , uint32_t height , uint32_t num_bands ) :
+                Interleaved(width,height,num_bands,ImageAllocation()) {
+        }
+
+        /**
+         * Creates an image with the specified allocator, row padding and initialization
+         */
+        Interleaved( uint32_t width , uint32_t height , uint32_t num_bands , const ImageAllocation& allocation ) {
+            this->setAllocation(allocation);
             this->width = width;
             this->height = height;
             this->num_bands = num_bands;
-            this->data_length = width*height*num_bands;
-            this->data = new T[this->data_length]();
+            this->stride = this->strideFor(width*num_bands);
+            this->data_length = this->stride*height;
+            this->data = this->allocatePixels(this->data_length,allocation.zero);
             this->offset = 0;
-            this->stride = width*num_bands;
             this->subimage = false;
         }
 
@@ -360,10 +794,46 @@ namespace boofcv {
             this->subimage = true;
         }
 
+        /**
+         * Creates a view of pixels which belong to someone else. See Gray::wrap.
+         *
+         * @param stride Number of elements between the start of each row. If 0 then it's width*num_bands.
+         */
+        static Interleaved<T> wrap( T* data , uint32_t width , uint32_t height , uint32_t num_bands ,
+                                    uint32_t stride = 0 , std::shared_ptr<ImageBuffer> owner = nullptr ) {
+            if( stride == 0 )
+                stride = width*num_bands;
+            else if( stride < width*num_bands )
+                throw invalid_argument("stride must be at least the width times the number of bands");
+            Interleaved<T> view(data,stride*height,width,height,num_bands,0,stride);
+            view.buffer = std::move(owner);
+            if( view.buffer )
+                view.generation = view.buffer->generation;
+            return view;
+        }
+
         Interleaved() : Interleaved(0,0,0) {
         }
 
+        /**
+         * Copies a sub-image by referencing the same pixels. Any other image is deep copied using the same
+         * allocator and row padding. Same behavior as the copy assignment.
+         */
+        Interleaved( const Interleaved<T>& other ) :
+                Interleaved(0,0,other.num_bands,ImageAllocation(other.pad_rows,other.zero_pixels,other.allocator)) {
+            *this = other;
+        }
+
+        /**
+         * Takes ownership of the other image's pixels. The other image is left as an empty image.
+         */
+        Interleaved( Interleaved<T>&& other ) noexcept : Interleaved(nullptr,0,0,0,0,0,0) {
+            this->subimage = false;
+            swap(other);
+        }
+
         ~Interleaved() {
+            this->freePixels();
             if( !this->subimage ) {
                 this->width = 0;
                 this->height = 0;
@@ -371,7 +841,6 @@ namespace boofcv {
                 this->data_length = 0;
                 this->offset = 0;
                 this->stride = 0;
-                delete[]this->data;
                 this->data = NULL;
             }
         }
@@ -383,20 +852,13 @@ namespace boofcv {
                 throw invalid_argument("Can't reshape a subimage");
             }
 
-            uint32_t new_length = width*height*bands;
-            if( new_length > data_length ) {
-                if( this->subimage ) {
-                    throw invalid_argument("Grow the data array in a subimage");
-                }
-                delete []data;
-                data = new T[new_length]();
-                this->data_length = new_length;
-            }
+            uint32_t stride = this->strideFor(width*bands);
+            growPixels(stride*height);
 
             this->width = width;
             this->height = height;
             this->num_bands = bands;
-            this->stride = width*bands;
+            this->stride = stride;
         }
 
         void reshape( uint32_t width , uint32_t height ) override {
@@ -406,20 +868,37 @@ namespace boofcv {
                 throw invalid_argument("Can't reshape a subimage");
             }
 
-            uint32_t desired_length = width*height*this->num_bands;
-            if( desired_length > this->data_length ) {
-                delete []data;
-                this->data = new T[desired_length]();
-                this->data_length = desired_length;
-            }
+            uint32_t stride = this->strideFor(width*this->num_bands);
+            growPixels(stride*height);
+
             this->width = width;
             this->height = height;
-            this->stride = width*this->num_bands;
+            this->stride = stride;
+        }
+
+        /**
+         * Grows the pixel array so that the image can be reshaped to any size up to width x height x bands
+         * without allocating memory. The image's shape and pixel values are not modified.
+         */
+        void reserve( uint32_t width , uint32_t height , uint32_t bands ) {
+            if( this->subimage ) {
+                throw invalid_argument("Can't reserve a subimage");
+            }
+            uint32_t desired_length = this->strideFor(width*bands)*height;
+            if( desired_length <= this->data_length )
+                return;
+            this->data = this->reallocatePixels(this->data,this->data_length,desired_length);
+            this->data_length = desired_length;
+        }
+
+        void reserve( uint32_t width , uint32_t height ) {
+            reserve(width,height,this->num_bands);
         }
 
         T& at( uint32_t x , uint32_t y , uint32_t band ) const {
             if( x >= this->width || y >= this->height )
                 throw invalid_argument("out of range");
+            this->checkSubimage();
             return data[this->offset + y*this->stride + x*this->num_bands + band];
         }
 
@@ -434,17 +913,11 @@ namespace boofcv {
                 throw invalid_argument("Can't reshape a subimage");
             }
 
-            uint32_t new_length = this->width*this->height*desired;
-            if( new_length > data_length ) {
-                if( this->subimage ) {
-                    throw invalid_argument("Grow the data array in a subimage");
-                }
-                delete []data;
-                data = new T[new_length]();
-                this->data_length = new_length;
-            }
+            uint32_t stride = this->strideFor(this->width*desired);
+            growPixels(stride*this->height);
+
             this->num_bands = desired;
-            this->stride = this->width*desired;
+            this->stride = stride;
         }
 
         void setTo( const Interleaved<T>& src ) {
@@ -456,24 +929,99 @@ namespace boofcv {
             }
             // This will handle the situation where all of some of the images are sub-images
             for( uint32_t y = 0; y < this->height; y++ ) {
-                memcpy(this->data+this->offset+y*this->stride,src.data+src.offset+y*src.stride,src.width*this->num_bands);
+                memcpy(this->data+this->offset+y*this->stride,src.data+src.offset+y*src.stride,sizeof(T)*src.width*this->num_bands);
             }
         }
 
-        Interleaved<T> makeSubimage( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 ) {
+        /**
+         * Creates a sub-image which references this image's pixels. The sub-image keeps the pixels alive
+         * even if this image is destroyed or reshaped, so it can be safely handed to another thread.
+         */
+        Interleaved<T> makeSubimage( uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1 ) const {
             if( x1 < x0 || y1 < y0 )
                 throw invalid_argument("Upper bounds can't be lower than lower bounds");
             if( x1 > this->width || y1 > this->height )
                 throw invalid_argument("Subimage must be inside the image");
+            this->checkSubimage();
 
-            return Interleaved<T>(this->data,this->data_length,x1-x0,y1-y0,
-                                  this->num_bands,this->offset + y0*this->stride+x0*num_bands, this->stride );
+            Interleaved<T> sub(this->data,this->data_length,x1-x0,y1-y0,
+                               this->num_bands,this->offset + y0*this->stride+x0*num_bands, this->stride );
+            this->shareBuffer(sub);
+            return sub;
         }
 
         uint32_t index_of( uint32_t x , uint32_t y , uint32_t band) const {
             return this->offset + y*this->stride + x*this->num_bands + band;
         }
+
+        /**
+         * Swaps the pixels, shape and allocation settings of the two images without copying any pixels
+         */
+        void swap( Interleaved<T>& other ) noexcept {
+            std::swap(this->data,other.data);
+            std::swap(this->data_length,other.data_length);
+            std::swap(this->num_bands,other.num_bands);
+            this->swapBase(other);
+        }
+
+        Interleaved<T>& operator=(const Interleaved<T>& other) // copy assignment
+        {
+            if (this != &other) {
+                if( other.subimage ) {
+                    other.shareBuffer(*this);
+                    this->data = other.data;
+                    this->data_length = other.data_length;
+                    this->width = other.width;
+                    this->height = other.height;
+                    this->num_bands = other.num_bands;
+                    this->offset = other.offset;
+                    this->stride = other.stride;
+                    this->subimage = true;
+                } else {
+                    this->setTo(other);
+                }
+            }
+            return *this;
+        }
+
+        /**
+         * Move assignment. The pixels are handed over without being copied, unless this is a sub-image and
+         * the other image isn't. Then the pixels are copied into the sub-image, just like the copy assignment.
+         */
+        Interleaved<T>& operator=(Interleaved<T>&& other)
+        {
+            if (this != &other) {
+                if( this->subimage && !other.subimage ) {
+                    this->setTo(other);
+                } else {
+                    // the other image frees this image's old pixels when it's destroyed
+                    swap(other);
+                }
+            }
+            return *this;
+        }
+
+    private:
+        /**
+         * Called whenever the shape changes. Makes sure the pixel array has at least 'length' elements. The
+         * value of pixels is undefined afterwards.
+         */
+        void growPixels( uint32_t length ) {
+            this->invalidateSubimages();
+            if( length <= this->data_length )
+                return;
+            this->freePixels();
+            this->data = nullptr;
+            this->data_length = 0;
+            this->data = this->allocatePixels(length,this->zero_pixels);
+            this->data_length = length;
+        }
     };
+
+    template<class T>
+    void swap( Interleaved<T>& a , Interleaved<T>& b ) noexcept {
+        a.swap(b);
+    }
 }
 
 
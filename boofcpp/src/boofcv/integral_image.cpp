@@ -0,0 +1,142 @@
+#include <cstring>
+
+#include "integral_image.h"
+#include "cpu_features.h"
+
+#if BOOFCPP_SIMD_AVX2
+#include <immintrin.h>
+#define BOOFCPP_SIMD_TARGET __attribute__((target("avx2")))
+#elif BOOFCPP_SIMD_NEON
+#include <arm_neon.h>
+#define BOOFCPP_SIMD_TARGET
+#endif
+
+using namespace boofcv;
+
+namespace {
+
+#if BOOFCPP_SIMD_AVX2 || BOOFCPP_SIMD_NEON
+
+#if BOOFCPP_SIMD_AVX2
+    typedef __m256i vint;
+    const uint32_t LANES = 8;
+
+    bool simdAvailable() {
+        return CpuFeatures::avx2();
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint load( const U8* ptr ) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint load( const uint32_t* ptr ) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    }
+
+    BOOFCPP_SIMD_TARGET inline void store( uint32_t* ptr , vint value ) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr),value);
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint add( vint a , vint b ) {
+        return _mm256_add_epi32(a,b);
+    }
+
+    // Inclusive prefix sum across the lanes. Shifts inside each 128-bit half then carries the low half's
+    // total into the high half.
+    BOOFCPP_SIMD_TARGET inline vint prefix_sum( vint x ) {
+        x = _mm256_add_epi32(x,_mm256_slli_si256(x,4));
+        x = _mm256_add_epi32(x,_mm256_slli_si256(x,8));
+        __m256i low = _mm256_permute2x128_si256(x,x,0x08);
+        return _mm256_add_epi32(x,_mm256_shuffle_epi32(low,0xFF));
+    }
+
+    // Copies the last lane into all the lanes
+    BOOFCPP_SIMD_TARGET inline vint broadcast_last( vint x ) {
+        return _mm256_permutevar8x32_epi32(x,_mm256_set1_epi32(7));
+    }
+
+    BOOFCPP_SIMD_TARGET inline vint zero() {
+        return _mm256_setzero_si256();
+    }
+#else
+    typedef uint32x4_t vint;
+    const uint32_t LANES = 4;
+
+    bool simdAvailable() {
+        return CpuFeatures::neon();
+    }
+
+    inline vint load( const U8* ptr ) {
+        uint32_t packed;
+        std::memcpy(&packed,ptr,4);
+        uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(packed)));
+        return vmovl_u16(vget_low_u16(wide));
+    }
+
+    inline vint load( const uint32_t* ptr ) {
+        return vld1q_u32(ptr);
+    }
+
+    inline void store( uint32_t* ptr , vint value ) {
+        vst1q_u32(ptr,value);
+    }
+
+    inline vint add( vint a , vint b ) {
+        return vaddq_u32(a,b);
+    }
+
+    inline vint zero() {
+        return vdupq_n_u32(0);
+    }
+
+    // Inclusive prefix sum across the lanes
+    inline vint prefix_sum( vint x ) {
+        x = vaddq_u32(x,vextq_u32(zero(),x,3));
+        return vaddq_u32(x,vextq_u32(zero(),x,2));
+    }
+
+    // Copies the last lane into all the lanes. vdupq_laneq_u32 would be one instruction but only exists on AArch64
+    inline vint broadcast_last( vint x ) {
+        return vdupq_n_u32(vgetq_lane_u32(x,3));
+    }
+#endif
+
+    template<class E>
+    BOOFCPP_SIMD_TARGET void transform_simd( const Gray<E>& input , Gray<uint32_t>& integral ) {
+        for( uint32_t y = 0; y < input.height; y++ ) {
+            const E* ptr_in = &input.data[input.offset + y*input.stride];
+            const uint32_t* ptr_prev = &integral.data[integral.offset + y*integral.stride + 1];
+            uint32_t* ptr_out = &integral.data[integral.offset + (y+1)*integral.stride];
+            *ptr_out++ = 0;
+
+            // sum of all the pixels in the row before x, copied into every lane
+            vint carry = zero();
+            uint32_t x = 0;
+            for( ; x + LANES <= input.width; x += LANES ) {
+                vint total = add(prefix_sum(load(&ptr_in[x])),carry);
+                carry = broadcast_last(total);
+                store(&ptr_out[x],add(total,load(&ptr_prev[x])));
+            }
+
+            // handle the tail with scalar code
+            uint32_t total = x > 0 ? ptr_out[x-1] - ptr_prev[x-1] : 0;
+            for( ; x < input.width; x++ ) {
+                total += ptr_in[x];
+                ptr_out[x] = total + ptr_prev[x];
+            }
+        }
+    }
+
+#endif
+}
+
+bool IntegralImage_SIMD::transform( const Gray<U8>& input , Gray<uint32_t>& integral ) {
+#if BOOFCPP_SIMD_AVX2 || BOOFCPP_SIMD_NEON
+    if( !simdAvailable() )
+        return false;
+    transform_simd(input,integral);
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef BOOFCPP_INTEGRAL_IMAGE_H
+#define BOOFCPP_INTEGRAL_IMAGE_H
+
+#include <type_traits>
+
+#include "base_types.h"
+#include "image_types.h"
+
+namespace boofcv {
+
+    /**
+     * Specifies the pixel type of an integral image computed from an image with pixels of type T.
+     *
+     * Integer images use an unsigned version of TypeInfo<T>::sum_type. Unsigned arithmetic wraps around instead
+     * of overflowing, so the sum inside of a rectangle is correct even after the integral image itself has
+     * wrapped around. The only requirement is that the rectangle's sum fits inside of sum_type. Floating point
+     * images always use F64 since the round off error in F32 grows with the size of the image.
+     */
+    template<class T>
+    struct IntegralImageType {
+        typedef typename TypeInfo<T>::sum_type sum_type;
+        typedef typename std::conditional<std::is_integral<sum_type>::value,
+                std::make_unsigned<sum_type>, std::common_type<F64>>::type::type type;
+    };
+
+    /**
+     * SIMD implementation of {@link IntegralImageOps#transform}. The instruction set is selected at run time
+     * using {@link CpuFeatures}. Returns true if it processed the image and false if the caller must fall back
+     * onto the scalar code. Results are identical to the scalar code.
+     */
+    class IntegralImage_SIMD {
+    public:
+        // Types without a SIMD implementation end up here
+        template<typename E, typename I>
+        static bool transform( const Gray<E>& /*input*/ , Gray<I>& /*integral*/ ) {
+            return false;
+        }
+
+        static bool transform( const Gray<U8>& input , Gray<uint32_t>& integral );
+    };
+
+    /**
+     * Functions for computing and sampling integral images, also known as summed area tables. The integral
+     * image has one more row and column than the input image. The first row and column are zero and
+     * integral(x,y) is the sum of all input pixels which are to the left of x and above y. The sum inside any
+     * rectangle can then be found with four lookups, no matter how large the rectangle is.
+     */
+    class IntegralImageOps {
+    public:
+        /**
+         * Computes the integral image. Each row is a prefix sum of the input row added to the previous row
+         * of the integral image.
+         *
+         * @param input Input image. Not modified.
+         * @param integral (Output) Integral image. Reshaped to (width+1) x (height+1)
+         */
+        template<class E, class I>
+        static void transform( const Gray<E>& input , Gray<I>& integral ) {
+            integral.reshape(input.width+1,input.height+1);
+
+            I* row0 = &integral.data[integral.offset];
+            for( uint32_t x = 0; x <= input.width; x++ ) {
+                row0[x] = 0;
+            }
+
+            if( IntegralImage_SIMD::transform(input,integral) )
+                return;
+
+            for( uint32_t y = 0; y < input.height; y++ ) {
+                const E* ptr_in = &input.data[input.offset + y*input.stride];
+                const I* ptr_prev = &integral.data[integral.offset + y*integral.stride];
+                I* ptr_out = &integral.data[integral.offset + (y+1)*integral.stride];
+
+                I total = 0;
+                *ptr_out++ = 0;
+                ptr_prev++;
+                for( uint32_t i = input.width; i; i-- ) {
+                    total += static_cast<I>(*ptr_in++);
+                    *ptr_out++ = total + *ptr_prev++;
+                }
+            }
+        }
+
+        /**
+         * Sum of all input pixels inside the rectangle from (x0,y0) inclusive to (x1,y1) exclusive
+         */
+        template<class I>
+        static I block_sum( const Gray<I>& integral , uint32_t x0 , uint32_t y0 , uint32_t x1 , uint32_t y1 ) {
+            const I* top = &integral.data[integral.offset + y0*integral.stride];
+            const I* bottom = &integral.data[integral.offset + y1*integral.stride];
+            return (bottom[x1] - bottom[x0]) - (top[x1] - top[x0]);
+        }
+    };
+}
+
+#endif
@@ -8,18 +8,14 @@
 namespace boofcv {
 
     /**
-     * Returns a subimage which is equivalent to the input image. There will be a memory leak unless you
-     * set "subimage" to false in the returned subimage
+     * Returns a subimage which is equivalent to the input image. The subimage keeps the larger image's
+     * pixels alive after the larger image goes out of scope.
      */
     template<class E>
     Gray<E> create_subimage( const Gray<E>& input ) {
-        Gray<E> *larger = new Gray<E>(input.width+4, input.height+6);
-        Gray<E> sub = larger->makeSubimage(2,3,2+input.width,3+input.height);
+        Gray<E> larger(input.width+4, input.height+6);
+        Gray<E> sub = larger.makeSubimage(2,3,2+input.width,3+input.height);
         sub.copy(input);
-//        sub.subimage = false;
-        // hack it so it doesn't delete the array in the de-constructor
-        larger->subimage = true;
-        delete larger;
         return sub;
     }
 
@@ -2,6 +2,7 @@
 #define BOOFCPP_THRESHOLD_BLOCK_FILTERS_H
 
 #include <algorithm>
+#include <cstring>
 
 #include "image_types.h"
 #include "base_types.h"
@@ -9,6 +10,7 @@
 #include "sanity_checks.h"
 #include "binary_ops.h"
 #include "image_misc_ops.h"
+#include "concurrency.h"
 
 namespace boofcv
 {
@@ -47,6 +49,9 @@ namespace boofcv
         // Should it use the local 3x3 block region
         bool thresholdFromLocalBlocks;
 
+        // Should the threshold be bilinearly interpolated between the centers of blocks
+        bool interpolateThresholds = false;
+
     public:
         /**
          * Configures the detector
@@ -100,10 +105,21 @@ namespace boofcv
         }
 
         /**
-         * Applies the dynamically computed threshold to each pixel in the image, one block at a time
+         * Applies the dynamically computed threshold to each pixel in the image, one block at a time. Rows of
+         * blocks are processed concurrently if enabled.
          */
         void applyThreshold( const T& input, Gray<U8>& output ) {
-            for (uint32_t blockY = 0; blockY < stats.height; blockY++) {
+            parallel_for(blockConcurrency(),0,stats.height,[&](uint32_t blockY0, uint32_t blockY1){
+                applyThreshold(input,output,blockY0,blockY1);
+            });
+        }
+
+        /**
+         * Applies the threshold to rows of blocks from blockY0 (inclusive) to blockY1 (exclusive). Can be called
+         * from multiple threads at once with different rows.
+         */
+        virtual void applyThreshold( const T& input, Gray<U8>& output, uint32_t blockY0, uint32_t blockY1 ) {
+            for (uint32_t blockY = blockY0; blockY < blockY1; blockY++) {
                 for (uint32_t blockX = 0; blockX < stats.width; blockX++) {
                     thresholdBlock(blockX,blockY,input,output);
                 }
@@ -111,33 +127,24 @@ namespace boofcv
         }
 
         /**
-         * Computes the min-max value for each block in the image
+         * Computes the statistics for each block in the image. Rows of blocks are processed concurrently if enabled.
          */
         virtual void computeStatistics( const T& input, uint32_t innerWidth, uint32_t innerHeight) {
-            int statPixelStride = stats.num_bands;
+            parallel_for(blockConcurrency(),0,stats.height,[&](uint32_t blockY0, uint32_t blockY1){
+                computeStatistics(input,innerWidth,innerHeight,blockY0,blockY1);
+            });
+        }
 
-            uint32_t indexStats = 0;
-            for (uint32_t y = 0; y < innerHeight; y += blockHeight) {
-                for (uint32_t x = 0; x < innerWidth; x += blockWidth, indexStats += statPixelStride) {
-                    computeBlockStatistics(x,y,blockWidth,blockHeight,indexStats,input);
-                }
-                // handle the case where the image's width isn't evenly divisible by the block's width
-                if( innerWidth != input.width ) {
-                    computeBlockStatistics(innerWidth,y,input.width-innerWidth,blockHeight,indexStats,input);
-                    indexStats += statPixelStride;
-                }
-            }
-            // handle the case where the image's height isn't evenly divisible by the block's height
-            if( innerHeight != input.height ) {
-                uint32_t y = innerHeight;
-                uint32_t blockHeight = input.height-innerHeight;
-                for (uint32_t x = 0; x < innerWidth; x += blockWidth, indexStats += statPixelStride) {
-                    computeBlockStatistics(x,y,blockWidth,blockHeight,indexStats,input);
-                }
-                if( innerWidth != input.width ) {
-                    computeBlockStatistics(innerWidth,y,input.width-innerWidth,blockHeight,indexStats,input);
-                }
-            }
+        /**
+         * Computes the statistics for rows of blocks from blockY0 (inclusive) to blockY1 (exclusive). Each
+         * block writes to its own pixel in stats, so different rows can be processed at the same time.
+         */
+        virtual void computeStatistics( const T& input, uint32_t innerWidth, uint32_t innerHeight,
+                                        uint32_t blockY0 , uint32_t blockY1 ) {
+            forEachBlock(input,innerWidth,innerHeight,blockY0,blockY1,
+                         [&](uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, uint32_t indexStats) {
+                             computeBlockStatistics(x0,y0,width,height,indexStats,input);
+                         });
         }
 
         /**
@@ -169,6 +176,196 @@ namespace boofcv
         void setThresholdFromLocalBlocks(bool thresholdFromLocalBlocks) {
             this->thresholdFromLocalBlocks = thresholdFromLocalBlocks;
         }
+
+        bool isInterpolateThresholds() {
+            return interpolateThresholds;
+        }
+
+        /**
+         * If true the threshold changes smoothly across the image. Each block's threshold is used at its center
+         * and bilinearly interpolated between block centers. This removes the seams between blocks, so larger
+         * blocks can be used. Not every filter supports it.
+         */
+        void setInterpolateThresholds(bool interpolateThresholds) {
+            this->interpolateThresholds = interpolateThresholds;
+        }
+
+    protected:
+        /**
+         * Calls block(x0,y0,width,height,indexStats) for each block in rows blockY0 (inclusive) to
+         * blockY1 (exclusive)
+         */
+        template<class Block>
+        void forEachBlock( const T& input, uint32_t innerWidth, uint32_t innerHeight,
+                           uint32_t blockY0 , uint32_t blockY1 , Block block ) {
+            uint32_t statPixelStride = stats.num_bands;
+
+            for (uint32_t blockY = blockY0; blockY < blockY1; blockY++) {
+                uint32_t y = blockY*blockHeight;
+                // handle the case where the image's height isn't evenly divisible by the block's height
+                uint32_t height = y < innerHeight ? blockHeight : input.height-innerHeight;
+
+                uint32_t indexStats = blockY*stats.width*statPixelStride;
+                for (uint32_t x = 0; x < innerWidth; x += blockWidth, indexStats += statPixelStride) {
+                    block(x,y,blockWidth,height,indexStats);
+                }
+                // handle the case where the image's width isn't evenly divisible by the block's width
+                if( innerWidth != input.width ) {
+                    block(innerWidth,y,input.width-innerWidth,height,indexStats);
+                }
+            }
+        }
+
+        /**
+         * The user specifies the grain in image rows. This converts it into rows of blocks.
+         */
+        ConcurrencyContext blockConcurrency() const {
+            ConcurrencyContext context = this->concurrency;
+            context.grain = std::max(1U,context.grain/std::max(1U,blockHeight));
+            return context;
+        }
+    };
+
+    /**
+     * Block threshold where the per block functions are resolved at compile time. The filter passes itself in
+     * as Derived and its computeBlockStatistics() and thresholdBlock() are called directly instead of through
+     * the virtual functions in {@link ThresholdBlockCommon}. That way they can be inlined into the loop over
+     * blocks. There's only a virtual call for each band of blocks.
+     *
+     * To support interpolated thresholds, Derived provides blockThreshold(blockX,blockY), the threshold for a
+     * block as a double, and isDown().
+     *
+     * @tparam Derived The filter which extends this class
+     */
+    template<class T, class S, class Derived>
+    class ThresholdBlockCRTP : public ThresholdBlockCommon<T,S> {
+    public:
+        using ThresholdBlockCommon<T,S>::computeStatistics;
+        using ThresholdBlockCommon<T,S>::applyThreshold;
+
+        ThresholdBlockCRTP(const ConfigLength& requestedBlockWidth, bool thresholdFromLocalBlocks )
+                : ThresholdBlockCommon<T,S>(requestedBlockWidth,thresholdFromLocalBlocks) {}
+
+        void computeStatistics( const T& input, uint32_t innerWidth, uint32_t innerHeight,
+                                uint32_t blockY0 , uint32_t blockY1 ) override {
+            Derived& derived = static_cast<Derived&>(*this);
+            this->forEachBlock(input,innerWidth,innerHeight,blockY0,blockY1,
+                         [&](uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, uint32_t indexStats) {
+                             derived.Derived::computeBlockStatistics(x0,y0,width,height,indexStats,input);
+                         });
+        }
+
+        void applyThreshold( const T& input, Gray<U8>& output, uint32_t blockY0, uint32_t blockY1 ) override {
+            if( this->interpolateThresholds ) {
+                applyInterpolated(input,output,blockY0,blockY1);
+                return;
+            }
+            Derived& derived = static_cast<Derived&>(*this);
+            for (uint32_t blockY = blockY0; blockY < blockY1; blockY++) {
+                for (uint32_t blockX = 0; blockX < this->stats.width; blockX++) {
+                    derived.Derived::thresholdBlock(blockX,blockY,input,output);
+                }
+            }
+        }
+
+        /**
+         * Thresholds the pixels in rows of blocks from blockY0 (inclusive) to blockY1 (exclusive) using a threshold
+         * which is bilinearly interpolated between block centers. Outside the first and last center the closest
+         * block's threshold is used. The rows of blocks above and below are interpolated along x once, by adding
+         * a constant step to the previous pixel's threshold. Each pixel row is then a linear combination of the
+         * two. The output doesn't depend on how rows are split between threads.
+         */
+        void applyInterpolated( const T& input, Gray<U8>& output, uint32_t blockY0, uint32_t blockY1 ) {
+            Derived& derived = static_cast<Derived&>(*this);
+            const uint32_t W = this->stats.width, H = this->stats.height;
+            const bool down = derived.Derived::isDown();
+
+            // thresholds for the rows of blocks above and below the current row
+            Gray<float> blocks(W,2,this->scratchAllocation());
+            float* blocksA = blocks.data;
+            float* blocksB = &blocks.data[blocks.stride];
+            // threshold of every pixel at the upper block center, how much it changes each pixel row, and the
+            // threshold of every pixel in the current row
+            Gray<float> work(input.width,3,this->scratchAllocation());
+            float* upper = work.data;
+            float* step = &work.data[work.stride];
+            float* row = &work.data[2*work.stride];
+
+            const uint32_t y0 = blockY0*this->blockHeight;
+            const uint32_t y1 = blockY1 == H ? input.height : blockY1*this->blockHeight;
+
+            // index of the first block whose center is below the current row
+            uint32_t below = 0;
+            bool outdated = true;
+            float centerA = 0;
+            for (uint32_t y = y0; y < y1; y++) {
+                while( below < H && blockCenter(below,this->blockHeight,H,input.height) <= y ) {
+                    below++;
+                    outdated = true;
+                }
+
+                if( outdated ) {
+                    uint32_t rowA = below > 0 ? below-1 : 0;
+                    uint32_t rowB = below < H ? below : H-1;
+                    centerA = blockCenter(rowA,this->blockHeight,H,input.height);
+                    float centerB = blockCenter(rowB,this->blockHeight,H,input.height);
+                    for (uint32_t blockX = 0; blockX < W; blockX++) {
+                        blocksA[blockX] = static_cast<float>(derived.Derived::blockThreshold(blockX,rowA));
+                        blocksB[blockX] = static_cast<float>(derived.Derived::blockThreshold(blockX,rowB));
+                    }
+                    interpolateRow(blocksA,input.width,upper);
+                    interpolateRow(blocksB,input.width,step);
+                    float scale = rowA == rowB ? 0.0f : 1.0f/(centerB-centerA);
+                    for (uint32_t x = 0; x < input.width; x++) {
+                        step[x] = (step[x]-upper[x])*scale;
+                    }
+                    outdated = false;
+                }
+
+                const float offset = y-centerA;
+                for (uint32_t x = 0; x < input.width; x++) {
+                    row[x] = upper[x] + offset*step[x];
+                }
+
+                ThresholdOps::thresholdRowPixels(&input.data[input.offset + y*input.stride],row,down,
+                                                 &output.data[output.offset + y*output.stride],input.width);
+            }
+        }
+
+    private:
+        /**
+         * Center of a block along one axis. The last block also contains the pixels left over at the border.
+         */
+        static float blockCenter( uint32_t block , uint32_t blockLength , uint32_t blocks , uint32_t imageLength ) {
+            uint32_t lower = block*blockLength;
+            uint32_t upper = block+1 == blocks ? imageLength : lower+blockLength;
+            return (lower+upper-1)*0.5f;
+        }
+
+        /**
+         * Linearly interpolates the thresholds of a row of blocks between block centers along a row of pixels
+         */
+        void interpolateRow( const float* column , uint32_t width , float* row ) const {
+            const uint32_t W = this->stats.width;
+            uint32_t x = 0;
+            for (uint32_t blockX = 0; blockX < W; blockX++) {
+                float center = blockCenter(blockX,this->blockWidth,W,width);
+                if( blockX == 0 ) {
+                    for (; x <= center; x++)
+                        row[x] = column[0];
+                    continue;
+                }
+                float previous = blockCenter(blockX-1,this->blockWidth,W,width);
+                float step = (column[blockX]-column[blockX-1])/(center-previous);
+                float value = column[blockX-1] + (x-previous)*step;
+                for (; x <= center; x++) {
+                    row[x] = value;
+                    value += step;
+                }
+            }
+            for (; x < width; x++)
+                row[x] = column[W-1];
+        }
     };
 
     /**
@@ -183,7 +380,7 @@ namespace boofcv
      * @author Peter Abeles
      */
     template<class E>
-    class ThresholdBlockMean : public ThresholdBlockCommon<Gray<E>,Interleaved<E>>
+    class ThresholdBlockMean : public ThresholdBlockCRTP<Gray<E>,Interleaved<E>,ThresholdBlockMean<E>>
     {
     public:
         float scale; // in the java version U8 uses double and F32 uses float. using double causes slight diff in float results
@@ -191,7 +388,7 @@ namespace boofcv
 
         ThresholdBlockMean(const ConfigLength &requestedBlockWidth, bool thresholdFromLocalBlocks,
                            double scale , bool down)
-                : ThresholdBlockCommon<Gray<E>,Interleaved<E>>(requestedBlockWidth, thresholdFromLocalBlocks) {
+                : ThresholdBlockCRTP<Gray<E>,Interleaved<E>,ThresholdBlockMean<E>>(requestedBlockWidth, thresholdFromLocalBlocks) {
             this->scale = (float)scale;
             this->down = down;
             this->stats.setNumberOfBands(1);
@@ -207,6 +404,20 @@ namespace boofcv
             uint32_t x1 = blockX0==this->stats.width-1 ? input.width : (blockX0+1)*this->blockWidth;
             uint32_t y1 = blockY0==this->stats.height-1 ? input.height: (blockY0+1)*this->blockHeight;
 
+            E mean = localMean(blockX0,blockY0);
+
+            // apply threshold
+            for (uint32_t y = y0; y < y1; y++) {
+                E* inptr = &input.data[input.offset + y*input.stride + x0];
+                U8* outptr = &output.data[output.offset + y*output.stride + x0];
+                ThresholdOps::thresholdRow(inptr,mean,down,outptr,x1-x0);
+            }
+        }
+
+        /**
+         * Mean of the block, or of the block's local 3x3 region if thresholdFromLocalBlocks is true
+         */
+        E localMean( uint32_t blockX0 , uint32_t blockY0 ) const {
             // define the local 3x3 region in blocks, taking in account the image border
             uint32_t blockX1, blockY1;
             if(this->thresholdFromLocalBlocks) {
@@ -228,24 +439,15 @@ namespace boofcv
                     sum += this->stats.unsafe_at(x,y,0);
                 }
             }
-            E mean = sum/((blockY1-blockY0+1)*(blockX1-blockX0+1));
+            return sum/((blockY1-blockY0+1)*(blockX1-blockX0+1));
+        }
 
-            // apply threshold
-            for (uint32_t y = y0; y < y1; y++) {
-//                uint32_t indexInput = input.offset + y*input.stride + x0;
-//                uint32_t indexOutput = output.offset + y*output.stride + x0;
-//                uint32_t end = indexOutput + (x1-x0);
-//                for (; indexOutput < end; indexOutput++, indexInput++ ) {
-//                    output.data[indexOutput] = (U8)(down == (input.data[indexInput] <= mean));
-//                }
-                E* inptr = &input.data[input.offset + y*input.stride + x0];
-                U8* outptr = &output.data[output.offset + y*output.stride + x0];
-                E* end = &inptr[x1-x0];
+        double blockThreshold( uint32_t blockX , uint32_t blockY ) const {
+            return localMean(blockX,blockY);
+        }
 
-                while( inptr != end ) {
-                    *outptr++ = static_cast<U8>(down == (*inptr++ <= mean));
-                }
-            }
+        bool isDown() const {
+            return down;
         }
 
         void computeBlockStatistics(uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, uint32_t indexStats,
@@ -283,52 +485,163 @@ namespace boofcv
      * <p>NOTE: This produces visually different results from {@link ThresholdBlockOtsu} because the block algorithm
      * combines histograms from its neighboring blocks. That's why it appears to have a wider effective block.</p>
      *
+     * <p>The histogram can have fewer than 256 bins to reduce memory and bandwidth. With N bins each bin covers
+     * 256/N pixel values and the threshold is placed at the upper edge of a bin. Usually it's within a bin of the
+     * threshold found with 256 bins, but in blocks without two clearly separated modes a different split can be
+     * selected. On a noisy test image 64 bins changed about 1% of the output pixels and 16 bins about 5%.
+     * When every block has fewer than 2^16 pixels, the counts are stored with 16-bits in {@link #compactStats}.
+     * 64 bins with 16-bit counts use 1/8 of the memory.</p>
+     *
      * @see GThresholdImageOps#computeOtsu(ImageGray, double, double)
      *
      * @author Peter Abeles
      */
     template<class E>
-    class ThresholdBlockOtsu : public ThresholdBlockCommon<Gray<E>,Interleaved<S32>> {
+    class ThresholdBlockOtsu : public ThresholdBlockCRTP<Gray<E>,Interleaved<S32>,ThresholdBlockOtsu<E>> {
     public:
 
         GrowArray<uint32_t> histogram;
 
         ComputeOtsu otsu;
 
+        // threshold for each block. Computed once for all blocks before any pixels are thresholded
+        Gray<F64> thresholds;
+
+        // Histograms with 16-bit counts. Used instead of the bands in stats when they can't overflow. stats then
+        // has a single band with the number of pixels in each block
+        Interleaved<U16> compactStats;
+
+        // true if the histograms are stored in compactStats
+        bool compactCounters = false;
+
+    private:
+        // pixel values are shifted by this amount to get their bin
+        uint32_t binShift;
+
+    public:
         /**
          * Configures the detector
          *
          * @param requestedBlockWidth About how wide and tall you wish a block to be in pixels.
          * @param tuning Tuning parameter. 0 = standard Otsu. Greater than 0 will penalize zero texture.
+         * @param histogramBins Number of bins in each block's histogram. Power of two from 16 to 256.
          */
          ThresholdBlockOtsu(bool otsu2, ConfigLength requestedBlockWidth, double tuning, double scale, bool down,
-                            bool thresholdFromLocalBlocks )
-                 : ThresholdBlockCommon<Gray<E>,Interleaved<S32>>(requestedBlockWidth, thresholdFromLocalBlocks),
-                   histogram(256) , otsu(otsu2,tuning,down,scale)
+                            bool thresholdFromLocalBlocks , uint32_t histogramBins = 256 )
+                 : ThresholdBlockCRTP<Gray<E>,Interleaved<S32>,ThresholdBlockOtsu<E>>(requestedBlockWidth, thresholdFromLocalBlocks),
+                   histogram(histogramBins) , otsu(otsu2,tuning,down,scale)
         {
-            this->stats.setNumberOfBands(256);
+            if( histogramBins < 16 || histogramBins > 256 || (histogramBins & (histogramBins-1)) != 0 )
+                throw invalid_argument("histogramBins must be a power of two from 16 to 256");
+
+            binShift = 0;
+            while( (256U >> binShift) != histogramBins )
+                binShift++;
+            otsu.binWidth = 256/histogramBins;
+            this->stats.setNumberOfBands(histogramBins);
         }
 
+        using ThresholdBlockCRTP<Gray<E>,Interleaved<S32>,ThresholdBlockOtsu<E>>::computeStatistics;
+        using ThresholdBlockCRTP<Gray<E>,Interleaved<S32>,ThresholdBlockOtsu<E>>::applyThreshold;
+
         void computeStatistics( const Gray<E>& input, uint32_t innerWidth, uint32_t innerHeight) override {
-            ImageMiscOps::fill(this->stats,0);
+            // blocks along the right and bottom border absorb the remainder and are the largest
+            uint32_t maxWidth = innerWidth == input.width ? this->blockWidth : input.width-innerWidth;
+            uint32_t maxHeight = innerHeight == input.height ? this->blockHeight : input.height-innerHeight;
+            compactCounters = maxWidth*maxHeight <= 0xFFFF;
+
+            if( compactCounters ) {
+                this->stats.setNumberOfBands(1);
+                compactStats.setNumberOfBands(histogram.size);
+                compactStats.reshape(this->stats.width,this->stats.height);
+                ImageMiscOps::fill(compactStats,(U16)0);
+            } else {
+                this->stats.setNumberOfBands(histogram.size);
+                ImageMiscOps::fill(this->stats,0);
+            }
             ThresholdBlockCommon<Gray<E>,Interleaved<S32>>::computeStatistics(input,innerWidth,innerHeight);
+
+            thresholds.reshape(this->stats.width,this->stats.height);
+            parallel_for(this->blockConcurrency(),0,this->stats.height,[&](uint32_t blockY0, uint32_t blockY1){
+                computeThresholds(blockY0,blockY1);
+            });
+        }
+
+        /**
+         * Computes the threshold for rows of blocks from blockY0 (inclusive) to blockY1 (exclusive). With local
+         * blocks, the histogram of each block's 3x3 neighborhood is updated incrementally. The sum of the three
+         * rows of blocks is kept for each column of blocks and moves down one row at a time, then the sum of
+         * three columns moves across the row one column at a time. Each call has its own histograms and copy
+         * of otsu so that rows of blocks can be processed concurrently. The histograms are taken from the pool if
+         * there is one.
+         */
+        void computeThresholds( uint32_t blockY0 , uint32_t blockY1 ) {
+            const uint32_t bins = histogram.size;
+            const uint32_t W = this->stats.width, H = this->stats.height;
+            ComputeOtsu band_otsu(otsu);
+
+            if( !this->thresholdFromLocalBlocks ) {
+                // the histograms in a row of blocks are stored one after another
+                Gray<uint32_t> row(compactCounters ? W*bins : 0,1,this->scratchAllocation());
+                for (uint32_t blockY = blockY0; blockY < blockY1; blockY++) {
+                    const uint32_t* histograms;
+                    if( compactCounters ) {
+                        std::memset(row.data,0,sizeof(uint32_t)*W*bins);
+                        addHistograms(row.data,blockY);
+                        histograms = row.data;
+                    } else {
+                        histograms = statsAt(0,blockY);
+                    }
+                    band_otsu.computeBatch(histograms,bins,W,&thresholds.unsafe_at(0,blockY));
+                }
+                return;
+            }
+
+            Gray<uint32_t> window(bins,1,this->scratchAllocation());
+
+            // sum of the histograms in the rows of blocks next to blockY for each column of blocks
+            Gray<uint32_t> columns(W*bins,1,this->scratchAllocation());
+            std::memset(columns.data,0,sizeof(uint32_t)*W*bins);
+            for (uint32_t y = blockY0 > 0 ? blockY0-1 : 0; y <= std::min(H-1,blockY0+1); y++) {
+                addHistograms(columns.data,y);
+            }
+
+            for (uint32_t blockY = blockY0; blockY < blockY1; blockY++) {
+                if( blockY > blockY0 ) {
+                    if( blockY >= 2 )
+                        subtractHistograms(columns.data,blockY-2);
+                    if( blockY+1 < H )
+                        addHistograms(columns.data,blockY+1);
+                }
+
+                std::memcpy(window.data,columns.data,sizeof(uint32_t)*bins);
+                if( W > 1 )
+                    HistogramOps::add(window.data,&columns.data[bins],bins);
+
+                for (uint32_t blockX = 0; blockX < W; blockX++) {
+                    if( blockX > 0 ) {
+                        if( blockX >= 2 )
+                            HistogramOps::subtract(window.data,&columns.data[(blockX-2)*bins],bins);
+                        if( blockX+1 < W )
+                            HistogramOps::add(window.data,&columns.data[(blockX+1)*bins],bins);
+                    }
+                    // the number of pixels can vary across the image at the borders
+                    band_otsu.compute(window.data,bins,HistogramOps::sum(window.data,bins));
+                    thresholds.unsafe_at(blockX,blockY) = band_otsu.threshold;
+                }
+            }
         }
 
         void computeBlockStatistics(uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, uint32_t indexStats,
                                     const Gray<E>& input) override
         {
-            S32* stats_ptr = &this->stats.data[indexStats];
-            for (uint32_t y = 0; y < height; y++) {
-//                uint32_t indexInput = input.offset + (y0+y)*input.stride + x0;
-//                for (uint32_t x = 0; x < width; x++) {
-//                    this->stats.data[indexStats+static_cast<int>(input.data[indexInput++])]++;
-//                }
-
-                E* input_ptr = &input.data[input.offset + (y0+y)*input.stride + x0];
-                E* end = &input_ptr[width];
-                while( input_ptr != end ) {
-                    stats_ptr[U8(*input_ptr++)]++;
-                }
+            if( compactCounters ) {
+                // stats has one band so indexStats is the index of the block
+                uint32_t blockX = indexStats % this->stats.width, blockY = indexStats / this->stats.width;
+                countBlock(&compactStats.data[compactStats.index_of(blockX,blockY,0)],x0,y0,width,height,input);
+                this->stats.data[indexStats] = static_cast<S32>(width*height);
+            } else {
+                countBlock(&this->stats.data[indexStats],x0,y0,width,height,input);
             }
         }
 
@@ -340,62 +653,81 @@ namespace boofcv
             uint32_t x1 = blockX0 == this->stats.width-1  ? input.width : (blockX0+1)*this->blockWidth;
             uint32_t y1 = blockY0 == this->stats.height-1 ? input.height: (blockY0+1)*this->blockHeight;
 
-            // define the local 3x3 region in blocks, taking in account the image border
-            uint32_t blockX1, blockY1;
-            if(this->thresholdFromLocalBlocks) {
-                blockX1 = std::min(this->stats.width  - 1, blockX0 + 1);
-                blockY1 = std::min(this->stats.height - 1, blockY0 + 1);
-
-                blockX0 = blockX0 > 0 ? blockX0 - 1 : 0;
-                blockY0 = blockY0 > 0 ? blockY0 - 1 : 0;
-            } else {
-                blockX1 = blockX0;
-                blockY1 = blockY0;
-            }
-
-            // sum up histogram in local region
-            histogram.fill(0);
-
-            for (uint32_t y = blockY0; y <= blockY1; y++) {
-//                for (uint32_t x = blockX0; x <= blockX1; x++) {
-//                    int indexStats = this->stats.index_of(x,y,0);
-//                    for (int i = 0; i < histogram.size; i++) {
-//                        histogram[i] += this->stats.data[indexStats+i];
-//                    }
-//                }
-                S32* stats_ptr = &this->stats.data[this->stats.index_of(blockX0,y,0)];
-                for (uint32_t x = blockX0; x <= blockX1; x++) {
-                    for (uint32_t i = 0; i < histogram.size; i++) {
-                        histogram[i] += *stats_ptr++;
-                    }
-                }
-            }
-
-            // this can vary across the image at the borders
-            uint32_t total = 0;
-            for (uint32_t i = 0; i < histogram.size; i++) {
-                total += histogram[i];
-            }
-
-            // compute threshold
-            otsu.compute(histogram,total);
+            double threshold = thresholds.unsafe_at(blockX0,blockY0);
 
             for (uint32_t y = y0; y < y1; y++) {
                 uint32_t indexInput = input.offset + y*input.stride + x0;
                 uint32_t indexOutput = output.offset + y*output.stride + x0;
                 uint32_t end = indexOutput + (x1-x0);
                 for (; indexOutput < end; indexOutput++, indexInput++ ) {
-                    output.data[indexOutput] = static_cast<U8>(otsu.down == ((U8)(input.data[indexInput]) <= otsu.threshold));
+                    output.data[indexOutput] = static_cast<U8>(otsu.down == ((U8)(input.data[indexInput]) <= threshold));
                     // TODO make this more efficient for floats.
                     //      is it possible to avoid converting it to an int twice? once here and once above
                     //      java version convert it into a U8 image and doesn't support float directly
                 }
             }
         }
+
+        double blockThreshold( uint32_t blockX , uint32_t blockY ) const {
+            return thresholds.unsafe_at(blockX,blockY);
+        }
+
+        bool isDown() const {
+            return otsu.down;
+        }
+
+        /**
+         * Copies the histogram of a single block into 'dst', which must have room for every bin
+         */
+        void blockHistogram( uint32_t blockX , uint32_t blockY , uint32_t* dst ) const {
+            for (uint32_t i = 0; i < histogram.size; i++) {
+                dst[i] = compactCounters ? compactStats.at(blockX,blockY,i) : this->stats.at(blockX,blockY,i);
+            }
+        }
+
+    private:
+        template<class C>
+        void countBlock( C* counts , uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, const Gray<E>& input ) {
+            const uint32_t shift = binShift;
+            for (uint32_t y = 0; y < height; y++) {
+                E* input_ptr = &input.data[input.offset + (y0+y)*input.stride + x0];
+                E* end = &input_ptr[width];
+                while( input_ptr != end ) {
+                    counts[U8(*input_ptr++) >> shift]++;
+                }
+            }
+        }
+
+        // The block statistics are non-negative counts so they can be read as unsigned
+        const uint32_t* statsAt( uint32_t blockX , uint32_t blockY ) const {
+            return reinterpret_cast<const uint32_t*>(&this->stats.data[this->stats.index_of(blockX,blockY,0)]);
+        }
+
+        /**
+         * Adds the histograms of every block in row blockY to dst
+         */
+        void addHistograms( uint32_t* dst , uint32_t blockY ) const {
+            const uint32_t length = this->stats.width*histogram.size;
+            if( compactCounters )
+                HistogramOps::add(dst,&compactStats.data[compactStats.index_of(0,blockY,0)],length);
+            else
+                HistogramOps::add(dst,statsAt(0,blockY),length);
+        }
+
+        /**
+         * Subtracts the histograms of every block in row blockY from dst
+         */
+        void subtractHistograms( uint32_t* dst , uint32_t blockY ) const {
+            const uint32_t length = this->stats.width*histogram.size;
+            if( compactCounters )
+                HistogramOps::subtract(dst,&compactStats.data[compactStats.index_of(0,blockY,0)],length);
+            else
+                HistogramOps::subtract(dst,statsAt(0,blockY),length);
+        }
     };
 
     template<class E>
-    class ThresholdBlockMinMax : public ThresholdBlockCommon<Gray<E>,Interleaved<E>> {
+    class ThresholdBlockMinMax : public ThresholdBlockCRTP<Gray<E>,Interleaved<E>,ThresholdBlockMinMax<E>> {
     public:
         typedef typename TypeInfo<E>::sum_type sum_type;
 
@@ -413,7 +745,7 @@ namespace boofcv
          */
         ThresholdBlockMinMax(float minimumSpread, const ConfigLength& requestedBlockWidth, bool thresholdFromLocalBlocks,
                              float scale , bool down )
-        : ThresholdBlockCommon<Gray<E>,Interleaved<E>>(requestedBlockWidth, thresholdFromLocalBlocks)
+        : ThresholdBlockCRTP<Gray<E>,Interleaved<E>,ThresholdBlockMinMax<E>>(requestedBlockWidth, thresholdFromLocalBlocks)
         {
             this->minimumSpread = minimumSpread;
             this->scale = scale;
@@ -429,6 +761,30 @@ namespace boofcv
             uint32_t x1 = blockX0== this->stats.width-1 ? input.width : (blockX0+1)*this->blockWidth;
             uint32_t y1 = blockY0== this->stats.height-1 ? input.height: (blockY0+1)*this->blockHeight;
 
+            E min, max;
+            localMinMax(blockX0,blockY0,min,max);
+
+            // apply threshold
+            auto textureThreshold = static_cast<sum_type>(this->minimumSpread);
+            bool textureless = max-min <= textureThreshold;
+            auto average = static_cast<sum_type>(scale*((max+min)/2));
+            for (uint32_t y = y0; y < y1; y++) {
+                E* input_ptr = &input.data[input.offset + y*input.stride + x0];
+                U8* output_ptr = &output.data[output.offset + y*output.stride + x0];
+
+                if( textureless ) {
+                    std::memset(output_ptr,1,x1-x0);
+                } else {
+                    thresholdRow(input_ptr,average,output_ptr,x1-x0);
+                }
+            }
+        }
+
+        /**
+         * Finds the min and max pixel values inside the block, or the block's local 3x3 region if
+         * thresholdFromLocalBlocks is true
+         */
+        void localMinMax( uint32_t blockX0 , uint32_t blockY0 , E& min , E& max ) const {
             // define the local 3x3 region in blocks, taking in account the image border
             int blockX1, blockY1;
             if(this->thresholdFromLocalBlocks) {
@@ -443,8 +799,8 @@ namespace boofcv
             }
 
             // find the min and max pixel values inside this block region
-            E min = std::numeric_limits<E>::max();
-            E max = std::numeric_limits<E>::min();
+            min = std::numeric_limits<E>::max();
+            max = std::numeric_limits<E>::min();
 
             for (uint32_t y = blockY0; y <= blockY1; y++) {
                 for (uint32_t x = blockX0; x <= blockX1; x++) {
@@ -457,23 +813,22 @@ namespace boofcv
                         max = localMax;
                 }
             }
+        }
 
-            // apply threshold
-            auto textureThreshold = static_cast<sum_type>(this->minimumSpread);
-            for (uint32_t y = y0; y < y1; y++) {
-                E* input_ptr = &input.data[input.offset + y*input.stride + x0];
-                U8* output_ptr = &output.data[output.offset + y*output.stride + x0];
+        /**
+         * Threshold at the center of a block when interpolating. A textureless block uses a threshold which
+         * sets every pixel inside of it to 1.
+         */
+        double blockThreshold( uint32_t blockX , uint32_t blockY ) const {
+            E min, max;
+            localMinMax(blockX,blockY,min,max);
+            if( static_cast<sum_type>(max-min) <= static_cast<sum_type>(this->minimumSpread) )
+                return down ? static_cast<double>(max) : static_cast<double>(min)-0.5;
+            return static_cast<sum_type>(scale*((max+min)/2));
+        }
 
-                for (uint32_t i = x1-x0; i ; i-- ) {
-                    if( max-min <= textureThreshold ) {
-                        *output_ptr++ = 1;
-                        input_ptr++;
-                    } else {
-                        auto average = static_cast<sum_type>(scale*((max+min)/2));
-                        *output_ptr++ = static_cast<U8>( down == *input_ptr++ <= average );
-                    }
-                }
-            }
+        bool isDown() const {
+            return down;
         }
 
         void computeBlockStatistics(uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, uint32_t indexStats,
@@ -497,6 +852,17 @@ namespace boofcv
             this->stats.data[indexStats]   = min;
             this->stats.data[indexStats+1] = max;
         }
+
+    private:
+        // U8 pixels are compared against a U32 average. Every pixel is below an average larger than 255
+        void thresholdRow( const U8* input , uint32_t average , U8* output , uint32_t length ) {
+            ThresholdOps::thresholdRow(input,static_cast<U8>(std::min(average,255U)),down,output,length);
+        }
+
+        template<class V>
+        void thresholdRow( const E* input , V average , U8* output , uint32_t length ) {
+            ThresholdOps::thresholdRow(input,average,down,output,length);
+        }
     };
 }
 #endif
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 #include "binary_ops.h"
+#include "cpu_features.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
 
 using namespace std;
 using namespace boofcv;
@@ -98,6 +101,139 @@ TEST(BinaryImageOps, dilate4) {
     set3x3(img,case6); BinaryImageOps::dilate4(img,out); EXPECT_EQ(0,out.at(1,1));
 }
 
+/**
+ * Hands out memory which has been filled with garbage, like a block which was just freed by someone else
+ */
+class DirtyAllocator : public ImageAllocator {
+public:
+    AlignedImageAllocator aligned;
+
+    void* allocate( size_t bytes ) override {
+        void* ptr = aligned.allocate(bytes);
+        std::memset(ptr,77,bytes);
+        return ptr;
+    }
+
+    void deallocate( void* ptr , size_t bytes ) override {
+        aligned.deallocate(ptr,bytes);
+    }
+};
+
+/**
+ * erode4 and dilate4 skip the image border. A freshly grown output must still be a binary image there.
+ */
+TEST(BinaryImageOps, erode4_dilate4_border) {
+    DirtyAllocator dirty;
+    Gray<U8> input(40,40);
+    ImageMiscOps::fill(input,(U8)1);
+
+    for( int erode = 0; erode < 2; erode++ ) {
+        Gray<U8> output(0,0,ImageAllocation(false,true,&dirty));
+        if( erode )
+            BinaryImageOps::erode4(input,output);
+        else
+            BinaryImageOps::dilate4(input,output);
+
+        for( uint32_t y = 0; y < output.height; y++ ) {
+            for( uint32_t x = 0; x < output.width; x++ ) {
+                bool border = x == 0 || y == 0 || x == output.width-1 || y == output.height-1;
+                ASSERT_EQ(border ? 0 : 1,output.at(x,y));
+            }
+        }
+    }
+}
+
+/**
+ * Brute force min/max inside of the rectangle. Pixels outside the image are ignored.
+ */
+void naive_rect( const Gray<U8>& input , int rx , int ry , bool erode , Gray<U8>& output ) {
+    output.reshape(input.width,input.height);
+    for( int y = 0; y < (int)input.height; y++ ) {
+        for( int x = 0; x < (int)input.width; x++ ) {
+            U8 value = erode ? 1 : 0;
+            for( int j = std::max(0,y-ry); j <= std::min((int)input.height-1,y+ry); j++ ) {
+                for( int i = std::max(0,x-rx); i <= std::min((int)input.width-1,x+rx); i++ ) {
+                    value = erode ? std::min(value,input.at(i,j)) : std::max(value,input.at(i,j));
+                }
+            }
+            output.at(x,y) = value;
+        }
+    }
+}
+
+TEST(BinaryImageOps, erode8) {
+    Gray<U8> img,out;
+
+    int case0[] = {1,1,1, 1,1,1, 1,1,0};
+    int case1[] = {1,1,1, 1,1,1, 1,1,1};
+    int case2[] = {0,1,1, 1,1,1, 1,1,1};
+
+    set3x3(img,case0); BinaryImageOps::erode8(img,out); EXPECT_EQ(0,out.at(1,1)); EXPECT_EQ(1,out.at(0,0));
+    set3x3(img,case1); BinaryImageOps::erode8(img,out); EXPECT_EQ(1,out.at(1,1)); EXPECT_EQ(1,out.at(2,2));
+    set3x3(img,case2); BinaryImageOps::erode8(img,out); EXPECT_EQ(0,out.at(1,1)); EXPECT_EQ(1,out.at(2,2));
+}
+
+TEST(BinaryImageOps, dilate8) {
+    Gray<U8> img,out;
+
+    int case0[] = {0,0,0, 0,0,0, 0,0,0};
+    int case1[] = {0,0,0, 0,0,0, 0,0,1};
+    int case2[] = {1,0,0, 0,0,0, 0,0,0};
+
+    set3x3(img,case0); BinaryImageOps::dilate8(img,out); EXPECT_EQ(0,out.at(1,1));
+    set3x3(img,case1); BinaryImageOps::dilate8(img,out); EXPECT_EQ(1,out.at(1,1)); EXPECT_EQ(0,out.at(0,0));
+    set3x3(img,case2); BinaryImageOps::dilate8(img,out); EXPECT_EQ(1,out.at(1,1)); EXPECT_EQ(0,out.at(2,2));
+}
+
+TEST(BinaryImageOps, rect) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t width : {1,7,30} ) {
+        for( uint32_t height : {1,5,23} ) {
+            Gray<U8> input(width,height);
+            // mostly ones so erode doesn't remove everything
+            ImageMiscOps::fill_uniform(input,(U8)0,(U8)6,gen);
+            for( uint32_t i = 0; i < input.data_length; i++ ) {
+                input.data[i] = input.data[i] == 0 ? 0 : 1;
+            }
+            Gray<U8> sub_input = create_subimage(input);
+
+            for( uint32_t rx : {0,1,2,5,40} ) {
+                for( uint32_t ry : {0,1,3,40} ) {
+                    Gray<U8> expected, found, storage;
+                    naive_rect(input,rx,ry,true,expected);
+                    BinaryImageOps::erodeRect(sub_input,rx,ry,found,storage);
+                    check_equals(expected,found);
+
+                    naive_rect(input,rx,ry,false,expected);
+                    BinaryImageOps::dilateRect(sub_input,rx,ry,found,storage);
+                    check_equals(expected,found);
+                }
+            }
+
+            Gray<U8> expected, found;
+            naive_rect(input,1,1,true,expected);
+            BinaryImageOps::erode8(input,found);
+            check_equals(expected,found);
+            naive_rect(input,1,1,false,expected);
+            BinaryImageOps::dilate8(input,found);
+            check_equals(expected,found);
+        }
+    }
+}
+
+TEST(BinaryImageOps, rect_inplace) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(25,18);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)2,gen);
+
+    Gray<U8> expected, found;
+    naive_rect(input,2,3,false,expected);
+    found = input;
+    BinaryImageOps::dilateRect(found,2,3,found);
+    check_equals(expected,found);
+}
+
 TEST(ThresholdOps, threshold) {
     Gray<U8> img(4,5);
     Gray<U8> out(4,5);
@@ -137,10 +273,324 @@ TEST(ThresholdOps, computeOtsu) {
     // a port of the java unit test would be complex
 }
 
+/**
+ * The SIMD versions must produce the same results as the scalar code for every length, including the tails
+ */
+TEST(ThresholdOps, thresholdRow) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t length = 0; length < 80; length++ ) {
+        std::vector<U8> inputU8(length);
+        std::vector<F32> inputF32(length);
+        for( uint32_t i = 0; i < length; i++ ) {
+            inputU8[i] = (U8)(gen() % 256);
+            inputF32[i] = (F32)(gen() % 256) - 0.5f;
+        }
+        // NaN is never below the threshold
+        if( length > 10 )
+            inputF32[length/2] = std::numeric_limits<F32>::quiet_NaN();
+
+        for( bool down : {true,false} ) {
+            for( U8 threshold : {(U8)0,(U8)100,(U8)255} ) {
+                std::vector<U8> expectedU8(length), expectedF32(length);
+                for( uint32_t i = 0; i < length; i++ ) {
+                    expectedU8[i] = (U8)(down == (inputU8[i] <= threshold));
+                    expectedF32[i] = (U8)(down == (inputF32[i] <= threshold));
+                }
+
+                for( bool simd : {false,true} ) {
+                    CpuFeatures::setSimdEnabled(simd);
+                    // output has an extra element to make sure nothing is written past the end
+                    std::vector<U8> found(length+1,7);
+                    ThresholdOps::thresholdRow(inputU8.data(),threshold,down,found.data(),length);
+                    ASSERT_EQ(expectedU8,std::vector<U8>(found.begin(),found.begin()+length));
+                    ASSERT_EQ(7,found[length]);
+
+                    ThresholdOps::thresholdRow(inputF32.data(),(F32)threshold,down,found.data(),length);
+                    ASSERT_EQ(expectedF32,std::vector<U8>(found.begin(),found.begin()+length));
+                    ASSERT_EQ(7,found[length]);
+                }
+                CpuFeatures::setSimdEnabled(true);
+            }
+        }
+    }
+}
+
+TEST(ThresholdOps, thresholdRowPixels) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t length = 0; length < 80; length++ ) {
+        std::vector<U8> inputU8(length);
+        std::vector<F32> inputF32(length), thresholds(length);
+        for( uint32_t i = 0; i < length; i++ ) {
+            inputU8[i] = (U8)(gen() % 256);
+            inputF32[i] = (F32)(gen() % 256) - 0.5f;
+            // some thresholds are exactly equal to the value
+            thresholds[i] = i % 5 == 0 ? (F32)inputU8[i] : (F32)(gen() % 2560)/10.0f;
+        }
+        if( length > 10 )
+            inputF32[length/2] = std::numeric_limits<F32>::quiet_NaN();
+
+        for( bool down : {true,false} ) {
+            std::vector<U8> expectedU8(length), expectedF32(length);
+            for( uint32_t i = 0; i < length; i++ ) {
+                expectedU8[i] = (U8)(down == (inputU8[i] <= thresholds[i]));
+                expectedF32[i] = (U8)(down == (inputF32[i] <= thresholds[i]));
+            }
+
+            for( bool simd : {false,true} ) {
+                CpuFeatures::setSimdEnabled(simd);
+                std::vector<U8> found(length+1,7);
+                ThresholdOps::thresholdRowPixels(inputU8.data(),thresholds.data(),down,found.data(),length);
+                ASSERT_EQ(expectedU8,std::vector<U8>(found.begin(),found.begin()+length));
+                ASSERT_EQ(7,found[length]);
+
+                ThresholdOps::thresholdRowPixels(inputF32.data(),thresholds.data(),down,found.data(),length);
+                ASSERT_EQ(expectedF32,std::vector<U8>(found.begin(),found.begin()+length));
+                ASSERT_EQ(7,found[length]);
+            }
+            CpuFeatures::setSimdEnabled(true);
+        }
+    }
+}
+
 TEST(ThresholdOps, localMean) {
     // TODO Finish this function and write a test
 }
 
+/**
+ * Compares against a brute force computation of the mean inside the region, clipped by the image border
+ */
+TEST(ThresholdOps, localMeanIntegral) {
+    std::mt19937 gen(0xBEEF);
+
+    Gray<U8> input(30,41);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)200,gen);
+    Gray<U8> sub_input = create_subimage(input);
+
+    int radius = 4;
+    float scale = 0.95f;
+
+    for( bool down : {true,false} ) {
+        Gray<U8> found;
+        Gray<uint32_t> integral;
+        ThresholdOps::localMeanIntegral(sub_input,found,ConfigLength::fixed(2*radius+1),scale,down,integral);
+
+        for( int y = 0; y < (int)input.height; y++ ) {
+            for( int x = 0; x < (int)input.width; x++ ) {
+                uint32_t sum = 0, count = 0;
+                for( int i = std::max(0,y-radius); i < std::min((int)input.height,y+radius+1); i++ ) {
+                    for( int j = std::max(0,x-radius); j < std::min((int)input.width,x+radius+1); j++ ) {
+                        sum += input.at(j,i);
+                        count++;
+                    }
+                }
+                auto mean = (U8)((sum+count/2)/count);
+                U8 expected = down ? input.at(x,y) <= mean*scale : input.at(x,y)*scale > mean;
+                ASSERT_EQ(expected,found.at(x,y));
+            }
+        }
+    }
+}
+
+/**
+ * Reference implementation of Otsu which walks the histogram with doubles. ComputeOtsu must produce exactly the
+ * same threshold and variance.
+ */
+void reference_otsu( const std::vector<uint32_t>& histogram , uint32_t totalPixels , bool otsu2 ,
+                     double& threshold , double& variance ) {
+    double dlength = histogram.size();
+    double sum = 0;
+    for (uint32_t i = 0; i < histogram.size(); i++)
+        sum += (i / dlength) * histogram[i];
+
+    double sumB = 0;
+    uint32_t wB = 0;
+    double selectedMB = 0, selectedMF = 0;
+
+    variance = 0;
+    threshold = 0;
+
+    for (uint32_t i = 0; i < histogram.size(); i++) {
+        wB += histogram[i];
+        if (wB == 0) continue;
+
+        uint32_t wF = totalPixels - wB;
+        if (wF == 0) break;
+
+        sumB += (i / dlength) * histogram[i];
+
+        double mB = sumB / wB;
+        double mF = (sum - sumB) / wF;
+        double varBetween = (double) wB * (double) wF * (mB - mF) * (mB - mF);
+
+        if (varBetween > variance) {
+            variance = varBetween;
+            threshold = i;
+            selectedMB = mB;
+            selectedMF = mF;
+        }
+    }
+
+    if( otsu2 )
+        threshold = histogram.size()*(selectedMB+selectedMF)/2.0;
+}
+
+void check_compute_otsu( const std::vector<uint32_t>& histogram , bool otsu2 , double tuning , bool down ,
+                         double scale ) {
+    uint32_t total = 0;
+    for( uint32_t v : histogram )
+        total += v;
+
+    double threshold, variance;
+    reference_otsu(histogram,total,otsu2,threshold,variance);
+    variance += 0.001;
+    int adjustment = (int)(tuning*threshold*tuning*threshold/variance+0.5);
+    threshold += down ? -adjustment : adjustment;
+    threshold = (int)(scale*std::max(threshold,0.0)+0.5);
+
+    for( bool simd : {false,true} ) {
+        CpuFeatures::setSimdEnabled(simd);
+        ComputeOtsu alg(otsu2,tuning,down,scale);
+        alg.compute(histogram.data(),(uint32_t)histogram.size(),total);
+        ASSERT_EQ(threshold,alg.threshold);
+        ASSERT_EQ(variance,alg.variance);
+    }
+    CpuFeatures::setSimdEnabled(true);
+}
+
 TEST(ComputeOtsu, ComputeOtsu) {
-    // Test of the class ComputeOtsu is intentionally omitted. Done by comparing results to Java
-}
\ No newline at end of file
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t length : {1,2,3,5,16,17,64,100,255,256,1000,1024} ) {
+        for( int trial = 0; trial < 40; trial++ ) {
+            std::vector<uint32_t> histogram(length,0);
+            switch( trial % 4 ) {
+                case 0: // dense
+                    for( auto& v : histogram )
+                        v = gen() % 500;
+                    break;
+                case 1: // a few values with a large number of pixels
+                    for( int i = 0; i < 4; i++ )
+                        histogram[gen()%length] += gen() % 100000;
+                    break;
+                case 2: // equally spaced spikes of the same size. Several thresholds have the same variance
+                    for( uint32_t i = trial % 3; i < length; i += 1 + length/5 )
+                        histogram[i] = 100;
+                    break;
+                default: // all the pixels have the same value
+                    histogram[gen()%length] = 1 + gen()%1000;
+                    break;
+            }
+
+            for( bool otsu2 : {false,true} ) {
+                check_compute_otsu(histogram,otsu2,0.0,true,1.0);
+                check_compute_otsu(histogram,otsu2,0.5,true,0.95);
+                check_compute_otsu(histogram,otsu2,0.5,false,1.05);
+            }
+        }
+    }
+
+    // empty histogram
+    check_compute_otsu(std::vector<uint32_t>(256,0),false,0.0,true,1.0);
+    check_compute_otsu(std::vector<uint32_t>(256,0),true,0.0,true,1.0);
+}
+
+TEST(ComputeOtsu, computeBatch) {
+    std::mt19937 gen(0xBEEF);
+
+    uint32_t length = 256, count = 23;
+    std::vector<uint32_t> histograms(length*count);
+    for( auto& v : histograms )
+        v = gen() % 50;
+    // empty histogram in the middle
+    std::fill(&histograms[5*length],&histograms[6*length],0);
+
+    for( bool otsu2 : {false,true} ) {
+        std::vector<double> found(count);
+        ComputeOtsu alg(otsu2,0.5,true,0.95);
+        alg.computeBatch(histograms.data(),length,count,found.data());
+
+        for( uint32_t k = 0; k < count; k++ ) {
+            const uint32_t* histogram = &histograms[k*length];
+            ComputeOtsu expected(otsu2,0.5,true,0.95);
+            expected.compute(histogram,length,HistogramOps::sum(histogram,length));
+            ASSERT_EQ(expected.threshold,found[k]);
+        }
+    }
+}
+
+TEST(BinaryImageOps, concurrent) {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,1);
+
+    Gray<U8> inputA(30,41), inputB(30,41);
+    ImageMiscOps::fill_uniform(inputA,(U8)0,(U8)2,gen);
+    ImageMiscOps::fill_uniform(inputB,(U8)0,(U8)2,gen);
+
+    Gray<U8> expected(30,41), found(30,41);
+
+    BinaryImageOps::logicAnd(inputA,inputB,expected);
+    BinaryImageOps::logicAnd(inputA,inputB,found,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::logicOr(inputA,inputB,expected);
+    BinaryImageOps::logicOr(inputA,inputB,found,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::erode4(inputA,expected);
+    BinaryImageOps::erode4(inputA,found,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::dilate4(inputA,expected);
+    BinaryImageOps::dilate4(inputA,found,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::erode8(inputA,expected);
+    BinaryImageOps::erode8(inputA,found,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::dilate8(inputA,expected);
+    BinaryImageOps::dilate8(inputA,found,context);
+    check_equals(expected,found);
+
+    Gray<U8> storage;
+    BinaryImageOps::erodeRect(inputA,4,2,expected);
+    BinaryImageOps::erodeRect(inputA,4,2,found,storage,context);
+    check_equals(expected,found);
+
+    BinaryImageOps::dilateRect(inputA,3,5,expected);
+    BinaryImageOps::dilateRect(inputA,3,5,found,storage,context);
+    check_equals(expected,found);
+}
+
+TEST(ThresholdOps, concurrent) {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,1);
+
+    Gray<U8> input(30,41);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)200,gen);
+
+    Gray<U8> expected(30,41), found(30,41);
+
+    for( bool down : {true,false} ) {
+        ThresholdOps::threshold(input,(U8)100,down,expected);
+        ThresholdOps::threshold(input,(U8)100,down,found,context);
+        check_equals(expected,found);
+
+        Gray<U8> storage1,storage2;
+        ThresholdOps::localMean(input,expected,ConfigLength::fixed(7),0.95f,down,storage1,storage2);
+        ThresholdOps::localMean(input,found,ConfigLength::fixed(7),0.95f,down,storage1,storage2,context);
+        check_equals(expected,found);
+
+        Gray<uint32_t> integral;
+        ThresholdOps::localMeanIntegral(input,expected,ConfigLength::fixed(7),0.95f,down,integral);
+        ThresholdOps::localMeanIntegral(input,found,ConfigLength::fixed(7),0.95f,down,integral,context);
+        check_equals(expected,found);
+    }
+
+    ASSERT_EQ(ThresholdOps::computeOtsu(input,(U8)0,(U8)255),
+              ThresholdOps::computeOtsu(input,(U8)0,(U8)255,false,context));
+}
@@ -0,0 +1,191 @@
+#include "gtest/gtest.h"
+#include "binary_packed.h"
+#include "binary_ops.h"
+#include "cpu_features.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
+
+using namespace std;
+using namespace boofcv;
+
+const std::vector<uint32_t> WIDTHS = {1,5,63,64,65,130,200};
+
+/**
+ * Computes the expected value of a 4-neighborhood operation with pixels outside the image being zero
+ */
+U8 naive_morph4( const Gray<U8>& input , uint32_t x , uint32_t y , bool erode ) {
+    int32_t offsets[5][2] = {{0,0},{-1,0},{1,0},{0,-1},{0,1}};
+    uint32_t total = 0;
+    for( auto& o : offsets ) {
+        int32_t xx = (int32_t)x + o[0], yy = (int32_t)y + o[1];
+        if( xx >= 0 && yy >= 0 && xx < (int32_t)input.width && yy < (int32_t)input.height )
+            total += input.unsafe_at(xx,yy);
+    }
+    return erode ? (U8)(total == 5) : (U8)(total > 0);
+}
+
+TEST(GrayBits, get_set) {
+    GrayBits img(130,3);
+    ASSERT_EQ(3,img.stride);
+    ASSERT_EQ(3,img.wordsPerRow());
+    ASSERT_FALSE(img.get(129,2));
+    img.set(129,2,true);
+    img.set(64,1,true);
+    ASSERT_TRUE(img.get(129,2));
+    ASSERT_TRUE(img.get(64,1));
+    ASSERT_EQ(uint64_t(1) << 1,img.row(2)[2]);
+    ASSERT_EQ(uint64_t(1),img.row(1)[1]);
+    img.set(64,1,false);
+    ASSERT_FALSE(img.get(64,1));
+    ASSERT_THROW(img.get(130,0),invalid_argument);
+
+    GrayBits padded(10,3,ImageAllocation::padded());
+    ASSERT_EQ(BOOFCPP_IMAGE_ALIGNMENT/8,padded.stride);
+}
+
+TEST(GrayBits, setTo_padded) {
+    GrayBits src(70,3);
+    src.set(69,2,true);
+    src.set(0,1,true);
+
+    // only the destination pads its rows so its stride is larger than the source's
+    GrayBits dst(0,0,ImageAllocation::padded());
+    dst.setTo(src);
+    ASSERT_GT(dst.stride,src.stride);
+    for( uint32_t y = 0; y < 3; y++ ) {
+        for( uint32_t x = 0; x < 70; x++ ) {
+            ASSERT_EQ(src.get(x,y),dst.get(x,y));
+        }
+        for( uint32_t i = dst.wordsPerRow(); i < dst.stride; i++ ) {
+            ASSERT_EQ(0,dst.row(y)[i]);
+        }
+    }
+}
+
+TEST(GrayBits, reshape_padding) {
+    GrayBits img(128,4);
+    for( uint32_t x = 0; x < 128; x++ ) {
+        img.set(x,0,true);
+    }
+    // bits past the end of the row must be zero after shrinking
+    img.reshape(70,4);
+    ASSERT_EQ(0,img.row(0)[1] >> 6);
+}
+
+TEST(BinaryPackedOps, convert) {
+    std::mt19937 gen(0xBEEF);
+    for( uint32_t width : WIDTHS ) {
+        Gray<U8> input(width,7);
+        ImageMiscOps::fill_uniform(input,(U8)0,(U8)3,gen);
+        Gray<U8> sub_input = create_subimage(input);
+
+        for( bool simd : {false,true} ) {
+            CpuFeatures::setSimdEnabled(simd);
+            GrayBits packed;
+            BinaryPackedOps::convert(sub_input,packed);
+            ASSERT_EQ(width,packed.width);
+            ASSERT_EQ(7,packed.height);
+
+            for( uint32_t y = 0; y < input.height; y++ ) {
+                for( uint32_t x = 0; x < width; x++ ) {
+                    ASSERT_EQ(input.at(x,y) != 0,packed.get(x,y));
+                }
+                ASSERT_EQ(0,packed.row(y)[packed.wordsPerRow()-1] & ~packed.lastWordMask());
+            }
+
+            Gray<U8> found;
+            BinaryPackedOps::convert(packed,found);
+            for( uint32_t y = 0; y < input.height; y++ ) {
+                for( uint32_t x = 0; x < width; x++ ) {
+                    ASSERT_EQ(input.at(x,y) != 0 ? 1 : 0,found.at(x,y));
+                }
+            }
+        }
+        CpuFeatures::setSimdEnabled(true);
+    }
+}
+
+TEST(BinaryPackedOps, logic) {
+    std::mt19937 gen(0xBEEF);
+    for( uint32_t width : WIDTHS ) {
+        Gray<U8> a(width,6), b(width,6);
+        ImageMiscOps::fill_uniform(a,(U8)0,(U8)2,gen);
+        ImageMiscOps::fill_uniform(b,(U8)0,(U8)2,gen);
+
+        GrayBits packed_a, packed_b, packed_out;
+        BinaryPackedOps::convert(a,packed_a);
+        BinaryPackedOps::convert(b,packed_b);
+
+        Gray<U8> expected, found;
+        BinaryImageOps::logicAnd(a,b,expected);
+        BinaryPackedOps::logicAnd(packed_a,packed_b,packed_out);
+        BinaryPackedOps::convert(packed_out,found);
+        check_equals(expected,found);
+
+        BinaryImageOps::logicOr(a,b,expected);
+        BinaryPackedOps::logicOr(packed_a,packed_b,packed_out);
+        BinaryPackedOps::convert(packed_out,found);
+        check_equals(expected,found);
+    }
+}
+
+void check_morph4( bool erode , bool concurrent ) {
+    std::mt19937 gen(0xBEEF);
+    ConcurrencyContext context;
+    context.grain = 2;
+
+    for( uint32_t width : WIDTHS ) {
+        for( uint32_t height : {1u,2u,9u} ) {
+            Gray<U8> input(width,height);
+            // mostly ones so that erode doesn't remove everything
+            ImageMiscOps::fill_uniform(input,(U8)0,(U8)8,gen);
+            for( uint32_t i = 0; i < input.data_length; i++ ) {
+                input.data[i] = input.data[i] == 0 ? 0 : 1;
+            }
+
+            GrayBits packed, packed_out;
+            BinaryPackedOps::convert(input,packed);
+            if( concurrent ) {
+                if( erode )
+                    BinaryPackedOps::erode4(packed,packed_out,context);
+                else
+                    BinaryPackedOps::dilate4(packed,packed_out,context);
+            } else {
+                if( erode )
+                    BinaryPackedOps::erode4(packed,packed_out);
+                else
+                    BinaryPackedOps::dilate4(packed,packed_out);
+            }
+            Gray<U8> found;
+            BinaryPackedOps::convert(packed_out,found);
+
+            // inside of the image must match BinaryImageOps
+            Gray<U8> expected(width,height);
+            if( erode )
+                BinaryImageOps::erode4(input,expected);
+            else
+                BinaryImageOps::dilate4(input,expected);
+
+            for( uint32_t y = 0; y < height; y++ ) {
+                for( uint32_t x = 0; x < width; x++ ) {
+                    bool border = x == 0 || y == 0 || x+1 == width || y+1 == height;
+                    U8 value = border ? naive_morph4(input,x,y,erode) : expected.at(x,y);
+                    ASSERT_EQ(value,found.at(x,y));
+                }
+            }
+        }
+    }
+}
+
+TEST(BinaryPackedOps, erode4) {
+    check_morph4(true,false);
+}
+
+TEST(BinaryPackedOps, dilate4) {
+    check_morph4(false,false);
+}
+
+TEST(BinaryPackedOps, concurrent) {
+    check_morph4(true,true);
+    check_morph4(false,true);
+}
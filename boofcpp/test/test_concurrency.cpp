@@ -0,0 +1,168 @@
+#include <stdexcept>
+#include <chrono>
+#include "gtest/gtest.h"
+#include "concurrency.h"
+
+using namespace std;
+using namespace boofcv;
+
+TEST(ThreadPool, size) {
+    ThreadPool pool(3);
+    ASSERT_EQ(3,pool.size());
+
+    ThreadPool single(1);
+    ASSERT_EQ(1,single.size());
+
+    // defaults to the number of hardware threads
+    ThreadPool hardware;
+    ASSERT_TRUE(hardware.size() >= 1);
+}
+
+TEST(ThreadPool, execute) {
+    ThreadPool pool(4);
+
+    // Call it multiple times to make sure the pool can be reused
+    for( uint32_t trial = 0; trial < 20; trial++ ) {
+        uint32_t N = 1+trial*7;
+        std::vector<std::atomic<int>> counts(N);
+        for( auto& c : counts )
+            c = 0;
+
+        pool.execute(N,[&](uint32_t i){ counts[i]++; });
+
+        for( uint32_t i = 0; i < N; i++ ) {
+            ASSERT_EQ(1,counts[i]);
+        }
+    }
+}
+
+TEST(ThreadPool, execute_nested) {
+    ThreadPool pool(3);
+    std::atomic<int> total(0);
+
+    pool.execute(5,[&](uint32_t){
+        pool.execute(4,[&](uint32_t){ total++; });
+    });
+
+    ASSERT_EQ(20,total);
+}
+
+TEST(ThreadPool, execute_exception) {
+    ThreadPool pool(3);
+    std::atomic<int> total(0);
+
+    ASSERT_THROW(pool.execute(10,[&](uint32_t i){
+        total++;
+        if( i == 4 )
+            throw std::runtime_error("Test");
+    }),std::runtime_error);
+
+    // all the tasks should still be processed
+    ASSERT_EQ(10,total);
+
+    // make sure it still works after an exception
+    total = 0;
+    pool.execute(10,[&](uint32_t){ total++; });
+    ASSERT_EQ(10,total);
+}
+
+void check_bands( const ConcurrencyContext& context , uint32_t rows ) {
+    std::vector<std::atomic<int>> counts(rows);
+    for( auto& c : counts )
+        c = 0;
+
+    concurrent_rows(context,rows,[&](uint32_t y0, uint32_t y1){
+        ASSERT_LT(y0,y1);
+        for( uint32_t y = y0; y < y1; y++ )
+            counts[y]++;
+    });
+
+    for( uint32_t i = 0; i < rows; i++ ) {
+        ASSERT_EQ(1,counts[i]);
+    }
+}
+
+TEST(concurrent_rows, all_rows_once) {
+    ThreadPool pool(4);
+
+    for( uint32_t grain : {1,5,32,1000} ) {
+        ConcurrencyContext context(pool,grain);
+        for( uint32_t rows : {1,2,31,32,33,100,1001} ) {
+            check_bands(context,rows);
+        }
+    }
+
+    // no pool
+    ConcurrencyContext single;
+    check_bands(single,57);
+}
+
+TEST(concurrent_rows, zero_rows) {
+    ThreadPool pool(2);
+    ConcurrencyContext context(pool);
+
+    bool called = false;
+    concurrent_rows(context,0,[&](uint32_t, uint32_t){ called = true;});
+    ASSERT_FALSE(called);
+}
+
+TEST(ThreadPool, execute_uneven) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> counts(64);
+    for( auto& c : counts )
+        c = 0;
+
+    // The first tasks take much longer. Idle threads should steal the rest.
+    pool.execute(64,[&](uint32_t i){
+        if( i < 4 )
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        counts[i]++;
+    });
+
+    for( uint32_t i = 0; i < 64; i++ ) {
+        ASSERT_EQ(1,counts[i]);
+    }
+}
+
+TEST(ThreadPool, global) {
+    ThreadPool::setGlobalThreads(3);
+    ASSERT_EQ(3,ThreadPool::global().size());
+    ASSERT_EQ(&ThreadPool::global(),ConcurrencyContext::global().pool);
+
+    std::atomic<int> total(0);
+    ThreadPool::global().execute(10,[&](uint32_t){ total++; });
+    ASSERT_EQ(10,total);
+
+    ThreadPool::setGlobalThreads(2);
+    ASSERT_EQ(2,ThreadPool::global().size());
+
+    // go back to the default
+    ThreadPool::setGlobalThreads(0);
+    ASSERT_TRUE(ThreadPool::global().size() >= 1);
+}
+
+TEST(parallel_for, all_indexes_once) {
+    ThreadPool pool(4);
+
+    for( uint32_t grain : {1,7,100} ) {
+        ConcurrencyContext context(pool,grain);
+        for( uint32_t begin : {0,5,40} ) {
+            uint32_t end = 213;
+            std::vector<std::atomic<int>> counts(end);
+            for( auto& c : counts )
+                c = 0;
+
+            parallel_for(context,begin,end,[&](uint32_t i0, uint32_t i1){
+                ASSERT_LE(begin,i0);
+                ASSERT_LT(i0,i1);
+                ASSERT_LE(i1,end);
+                for( uint32_t i = i0; i < i1; i++ )
+                    counts[i]++;
+            });
+
+            for( uint32_t i = 0; i < end; i++ ) {
+                ASSERT_EQ(i < begin ? 0 : 1,counts[i]);
+            }
+        }
+    }
+}
@@ -1,8 +1,10 @@
 #include "gtest/gtest.h"
 #include "contour.h"
+#include "cpu_features.h"
 #include "image_misc_ops.h"
 #include "image_statistics.h"
 #include "image_border.h"
+#include "testing_utils.h"
 
 #include "print_structures.h"
 
@@ -512,4 +514,277 @@ TEST(LinearContourLabelChang2004, checkInnerOuterContour) {
     ASSERT_EQ(10, alg.packedPoints.set_info.at(c.externalIndex).size);
     ASSERT_EQ(1,  c.internalIndexes.size());
     ASSERT_EQ(4,  alg.packedPoints.set_info.at(c.externalIndex+1).size);
-}
\ No newline at end of file
+}
+/**
+ * Checks to see if two labelers found identical contours
+ */
+void check_same_contours( const LinearContourLabelChang2004& expected , const LinearContourLabelChang2004& found ) {
+    ASSERT_EQ(expected.contours.size(), found.contours.size());
+    for( size_t i = 0; i < expected.contours.size(); i++ ) {
+        const ContourPacked& a = expected.contours[i];
+        const ContourPacked& b = found.contours[i];
+        ASSERT_EQ(a.id, b.id);
+        ASSERT_EQ(a.externalIndex, b.externalIndex);
+        ASSERT_EQ(a.internalIndexes, b.internalIndexes);
+    }
+
+    ASSERT_EQ(expected.packedPoints.set_info.size(), found.packedPoints.set_info.size());
+    for( uint32_t set = 0; set < expected.packedPoints.set_info.size(); set++ ) {
+        std::vector<Point2D<S32>> pointsA, pointsB;
+        expected.packedPoints.load_set(set,pointsA);
+        found.packedPoints.load_set(set,pointsB);
+        ASSERT_EQ(pointsA.size(), pointsB.size());
+        for( size_t i = 0; i < pointsA.size(); i++ ) {
+            ASSERT_EQ(pointsA[i].x, pointsB[i].x);
+            ASSERT_EQ(pointsA[i].y, pointsB[i].y);
+        }
+    }
+}
+
+/**
+ * Thresholding directly into the labeler should be the same as thresholding then labeling
+ */
+TEST(LinearContourLabelChang2004, process_threshold) {
+    std::mt19937 gen(0xBEEF);
+
+    Gray<U8> input(35,28);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+
+    GlobalFixedBinaryFilter<U8> thresholder(100,true);
+
+    for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+        LinearContourLabelChang2004 expected(rule), found(rule);
+        Gray<U8> binary(input.width,input.height);
+        Gray<S32> labeledExpected, labeledFound;
+
+        thresholder.process(input,binary);
+        expected.process(binary,labeledExpected);
+
+        // process it twice to make sure the results from the first call don't contaminate the second
+        found.process(input,thresholder,labeledFound);
+        found.process(input,thresholder,labeledFound);
+
+        check_equals(labeledExpected,labeledFound);
+        check_same_contours(expected,found);
+    }
+}
+
+TEST(LinearContourLabelChang2004, process_pool) {
+    std::mt19937 gen(0xBEEF);
+
+    Gray<U8> binary(35,28);
+    ImageMiscOps::fill_uniform(binary,(U8)0,(U8)2,gen);
+
+    ImagePool pool;
+    for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+        LinearContourLabelChang2004 expected(rule), found(rule);
+        found.pool = &pool;
+        Gray<S32> labeledExpected, labeledFound;
+
+        expected.process(binary,labeledExpected);
+
+        // the border is handed back to the pool after each call
+        found.process(binary,labeledFound);
+        ASSERT_EQ(0,pool.getOutstanding());
+        // dirty the recycled pixels so the border must be zeroed again
+        pool.gray<U8>(binary.width+2,binary.height+2).data[0] = 1;
+        found.process(binary,labeledFound);
+
+        check_equals(labeledExpected,labeledFound);
+        check_same_contours(expected,found);
+    }
+}
+
+TEST(LinearContourLabelChang2004, findRuns) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t length : {0,1,7,8,31,32,33,100} ) {
+        std::vector<U8> row(length);
+        for( int trial = 0; trial < 20; trial++ ) {
+            // values other than 1 are background, e.g. pixels marked while tracing
+            for( auto& v : row )
+                v = (U8)(gen() % 4 == 0 ? 1 : gen() % 3 == 0 ? 255 : 0);
+            if( trial == 1 ) std::fill(row.begin(),row.end(),1);
+
+            std::vector<uint32_t> expected;
+            bool inside = false;
+            for( uint32_t x = 0; x < length; x++ ) {
+                if( (row[x] == 1) != inside ) {
+                    expected.push_back(x);
+                    inside = !inside;
+                }
+            }
+            if( inside )
+                expected.push_back(length);
+
+            for( bool simd : {false,true} ) {
+                CpuFeatures::setSimdEnabled(simd);
+                std::vector<uint32_t> found;
+                LinearContourLabelChang2004::findRuns(row.data(),length,found);
+                ASSERT_EQ(expected,found);
+            }
+            CpuFeatures::setSimdEnabled(true);
+        }
+    }
+}
+
+TEST(LinearContourLabelChang2004, process_runs) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t max_value : {2,20} ) {
+        // dense and sparse images
+        Gray<U8> binary(75,48);
+        ImageMiscOps::fill_uniform(binary,(U8)0,(U8)max_value,gen);
+        for( uint32_t i = 0; i < binary.data_length; i++ ) {
+            binary.data[i] = binary.data[i] == 1 ? 1 : 0;
+        }
+
+        for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+            LinearContourLabelChang2004 expected(rule), found(rule);
+            found.useRuns = true;
+            Gray<S32> labeledExpected, labeledFound;
+
+            expected.process(binary,labeledExpected);
+            found.process(binary,labeledFound);
+
+            check_equals(labeledExpected,labeledFound);
+            check_same_contours(expected,found);
+        }
+    }
+}
+
+void load_contour( const LinearContourLabelChang2004& alg , uint32_t set , std::vector<std::pair<S32,S32>>& points ) {
+    std::vector<Point2D<S32>> tmp;
+    alg.packedPoints.load_set(set,tmp);
+    points.clear();
+    for( const auto& p : tmp )
+        points.emplace_back(p.x,p.y);
+}
+
+/**
+ * Contours belonging to each blob must be the same but they can be stored in a different order
+ */
+void check_same_blobs( const LinearContourLabelChang2004& expected , const LinearContourLabelChang2004& found ) {
+    ASSERT_EQ(expected.contours.size(), found.contours.size());
+    ASSERT_EQ(expected.packedPoints.set_info.size(), found.packedPoints.set_info.size());
+    std::vector<std::pair<S32,S32>> pointsA, pointsB;
+    for( size_t i = 0; i < expected.contours.size(); i++ ) {
+        const ContourPacked& a = expected.contours[i];
+        const ContourPacked& b = found.contours[i];
+        ASSERT_EQ(a.id, b.id);
+        load_contour(expected,a.externalIndex,pointsA);
+        load_contour(found,b.externalIndex,pointsB);
+        ASSERT_EQ(pointsA,pointsB);
+        ASSERT_EQ(a.internalIndexes.size(), b.internalIndexes.size());
+        for( size_t j = 0; j < a.internalIndexes.size(); j++ ) {
+            load_contour(expected,a.internalIndexes[j],pointsA);
+            load_contour(found,b.internalIndexes[j],pointsB);
+            ASSERT_EQ(pointsA,pointsB);
+        }
+    }
+}
+
+TEST(LinearContourLabelChang2004, process_concurrent) {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,1);
+
+    for( uint32_t max_value : {2,3,20} ) {
+        Gray<U8> binary(64,57);
+        ImageMiscOps::fill_uniform(binary,(U8)0,(U8)max_value,gen);
+        for( uint32_t i = 0; i < binary.data_length; i++ ) {
+            binary.data[i] = binary.data[i] == 0 ? 0 : 1;
+        }
+        if( max_value == 20 ) {
+            // mostly foreground so there are large blobs with many holes and blobs inside of holes
+            Gray<U8> hole = binary.makeSubimage(5,5,50,40);
+            ImageMiscOps::fill(hole,(U8)0);
+            Gray<U8> island = binary.makeSubimage(10,10,30,30);
+            ImageMiscOps::fill(island,(U8)1);
+        }
+
+        for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+            for( bool canonical : {false,true} ) {
+                LinearContourLabelChang2004 expected(rule), found(rule);
+                found.canonicalOrder = canonical;
+                Gray<S32> labeledExpected, labeledFound;
+
+                expected.process(binary,labeledExpected);
+                found.process(binary,labeledFound,context);
+
+                check_equals(labeledExpected,labeledFound);
+                if( canonical )
+                    check_same_contours(expected,found);
+                else
+                    check_same_blobs(expected,found);
+
+                // Work space is recycled
+                found.process(binary,labeledFound,context);
+                check_equals(labeledExpected,labeledFound);
+            }
+        }
+    }
+}
+
+TEST(LinearContourLabelChang2004, process_concurrent_limits) {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,4);
+
+    Gray<U8> binary(40,45);
+    ImageMiscOps::fill_uniform(binary,(U8)0,(U8)3,gen);
+    for( uint32_t i = 0; i < binary.data_length; i++ ) {
+        binary.data[i] = binary.data[i] == 0 ? 0 : 1;
+    }
+
+    for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+        LinearContourLabelChang2004 expected(rule), found(rule);
+        found.canonicalOrder = true;
+        for( auto* alg : {&expected,&found} ) {
+            alg->minContourSize = 4;
+            alg->maxContourSize = 30;
+            alg->saveInternalContours = false;
+        }
+        Gray<S32> labeledExpected, labeledFound;
+
+        expected.process(binary,labeledExpected);
+        found.process(binary,labeledFound,context);
+
+        check_equals(labeledExpected,labeledFound);
+        check_same_contours(expected,found);
+    }
+}
+
+TEST(LinearContourLabelChang2004, processContours) {
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t max_value : {2,3,20} ) {
+        Gray<U8> binary(64,57);
+        ImageMiscOps::fill_uniform(binary,(U8)0,(U8)max_value,gen);
+        for( uint32_t i = 0; i < binary.data_length; i++ ) {
+            binary.data[i] = binary.data[i] == 0 ? 0 : 1;
+        }
+
+        for( ConnectRule rule : {ConnectRule::FOUR,ConnectRule::EIGHT} ) {
+            for( bool limits : {false,true} ) {
+                LinearContourLabelChang2004 expected(rule), found(rule);
+                if( limits ) {
+                    for( auto* alg : {&expected,&found} ) {
+                        alg->minContourSize = 4;
+                        alg->maxContourSize = 30;
+                        alg->saveInternalContours = false;
+                    }
+                }
+                Gray<S32> labeled;
+                expected.process(binary,labeled);
+                found.processContours(binary);
+                check_same_contours(expected,found);
+
+                // switching between modes shouldn't change anything
+                found.process(binary,labeled);
+                found.processContours(binary);
+                check_same_contours(expected,found);
+            }
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #include <print_structures.h>
 #include "gtest/gtest.h"
 #include "convolve.h"
+#include "cpu_features.h"
 #include "image_misc_ops.h"
 #include "testing_utils.h"
 
@@ -650,6 +651,64 @@ public:
         checkResults_inner();
     }
 
+    void horizontal_div_unrolled_inner() {
+        ImageBorderValue<E> border(0);
+        border.setImage(input);
+
+        signed_type kernel_sum = kernel.sum();
+        ConvolveNaive::horizontal(kernel,border,expected,kernel_sum);
+        ConvolveImage_Inner::horizontal_unrolled(kernel,input,found,kernel_sum);
+
+        borderY0=borderY1=0;
+        borderX0 = kernel.offset;
+        borderX1 = kernel.width-1-kernel.offset;
+
+        checkResults_inner();
+    }
+
+    void vertical_div_unrolled_inner() {
+        ImageBorderValue<E> border(0);
+        border.setImage(input);
+
+        signed_type kernel_sum = kernel.sum();
+        ConvolveNaive::vertical(kernel,border,expected,kernel_sum);
+        ConvolveImage_Inner::vertical_unrolled(kernel,input,found,kernel_sum);
+
+        borderX0=borderX1=0;
+        borderY0 = kernel.offset;
+        borderY1 = kernel.width-1-kernel.offset;
+
+        checkResults_inner();
+    }
+
+    void horizontal_unrolled_inner() {
+        ImageBorderValue<E> border(0);
+        border.setImage(input);
+
+        ConvolveNaive::horizontal(kernel,border,expected);
+        ConvolveImage_Inner::horizontal_unrolled(kernel,input,found);
+
+        borderY0=borderY1=0;
+        borderX0 = kernel.offset;
+        borderX1 = kernel.width-1-kernel.offset;
+
+        checkResults_inner();
+    }
+
+    void vertical_unrolled_inner() {
+        ImageBorderValue<E> border(0);
+        border.setImage(input);
+
+        ConvolveNaive::vertical(kernel,border,expected);
+        ConvolveImage_Inner::vertical_unrolled(kernel,input,found);
+
+        borderX0=borderX1=0;
+        borderY0 = kernel.offset;
+        borderY1 = kernel.width-1-kernel.offset;
+
+        checkResults_inner();
+    }
+
     void vertical_div_inner() {
         ImageBorderValue<E> border(0);
         border.setImage(input);
@@ -1176,6 +1235,48 @@ TEST(ConvolveImage_Inner, convolve_div_F32) {
     }
 }
 
+/**
+ * Compile time kernel widths are used for 3 to 13. SIMD is turned off so that the scalar code is tested
+ */
+TEST(ConvolveImage_Inner, unrolled_U8) {
+    CompareToNaive<U8> compare;
+    CpuFeatures::setSimdEnabled(false);
+
+    for( uint32_t width = 3; width <= 15; width += 2 ) {
+        compare.setImageSize(width+10,width+12);
+        for( uint32_t offset = 0; offset < width; offset += width/2 ) {
+            compare.setKernel(width,offset);
+            compare.horizontal_unrolled_inner();
+            compare.vertical_unrolled_inner();
+            compare.horizontal_div_unrolled_inner();
+            compare.vertical_div_unrolled_inner();
+        }
+    }
+
+    CpuFeatures::setSimdEnabled(true);
+}
+
+/**
+ * Compile time kernel widths are used for 3 to 13. SIMD is turned off so that the scalar code is tested
+ */
+TEST(ConvolveImage_Inner, unrolled_F32) {
+    CompareToNaive<F32> compare;
+    CpuFeatures::setSimdEnabled(false);
+
+    for( uint32_t width = 3; width <= 15; width += 2 ) {
+        compare.setImageSize(width+10,width+12);
+        for( uint32_t offset = 0; offset < width; offset += width/2 ) {
+            compare.setKernel(width,offset);
+            compare.horizontal_unrolled_inner();
+            compare.vertical_unrolled_inner();
+            compare.horizontal_div_unrolled_inner();
+            compare.vertical_div_unrolled_inner();
+        }
+    }
+
+    CpuFeatures::setSimdEnabled(true);
+}
+
 TEST(ConvolveImage_Border, horizontal_U8) {
     CompareToNaive<U8> compare;
 
@@ -1451,4 +1552,74 @@ TEST(ConvolveImage, convolve_F32) {
     compare.setImageSize(15,16);
     compare.setKernel2(3,1);compare.convolve();
     compare.setKernel2(7,2);compare.convolve();
-}
\ No newline at end of file
+}
+
+/**
+ * Processing the image in bands across multiple threads should produce the same results as a single thread
+ */
+template<class E>
+void compare_concurrent( uint32_t num_threads , uint32_t grain ) {
+    typedef typename TypeInfo<E>::signed_type signed_type;
+    std::mt19937 gen(0xBEEF);
+
+    ThreadPool pool(num_threads);
+    ConcurrencyContext context(pool,grain);
+
+    for( uint32_t height : {4,9,31} ) {
+        Gray<E> input(17,height);
+        ImageMiscOps::fill_uniform(input, (E)0, (E)50, gen);
+        ImageBorderValue<E> border(input,(E)3);
+
+        for( uint32_t width : {3,7} ) {
+            for( uint32_t offset : {0u,width/2,width-1} ) {
+                Kernel1D<signed_type> kernel(width,offset);
+                KernelOps::fill_uniform(kernel,(signed_type)1,(signed_type)10,gen);
+                Kernel2D<signed_type> kernel2(width,offset);
+                KernelOps::fill_uniform(kernel2,(signed_type)1,(signed_type)10,gen);
+
+                Gray<E> expected(1,1), found(1,1), workspace(1,1);
+
+                ConvolveImage::horizontal(kernel,border,expected);
+                ConvolveImage::horizontal(kernel,border,found,context);
+                check_equals(expected,found,(E)0);
+
+                ConvolveImage::vertical(kernel,border,expected);
+                ConvolveImage::vertical(kernel,border,found,context);
+                check_equals(expected,found,(E)0);
+
+                ConvolveImage::convolve(kernel2,border,expected);
+                ConvolveImage::convolve(kernel2,border,found,context);
+                check_equals(expected,found,(E)0);
+
+                expected.reshape(input.width,input.height);
+                found.reshape(input.width,input.height);
+
+                ConvolveNormalized::horizontal(kernel,input,expected);
+                ConvolveNormalized::horizontal(kernel,input,found,context);
+                check_equals(expected,found,(E)0);
+
+                ConvolveNormalized::vertical(kernel,input,expected);
+                ConvolveNormalized::vertical(kernel,input,found,context);
+                check_equals(expected,found,(E)0);
+
+                ConvolveNormalized::convolve(kernel,input,expected,workspace);
+                ConvolveNormalized::convolve(kernel,input,found,workspace,context);
+                check_equals(expected,found,(E)0);
+            }
+        }
+    }
+}
+
+TEST(ConvolveImage, concurrent_U8) {
+    for( uint32_t threads : {1,2,4} ) {
+        compare_concurrent<U8>(threads,1);
+        compare_concurrent<U8>(threads,3);
+    }
+}
+
+TEST(ConvolveImage, concurrent_F32) {
+    for( uint32_t threads : {1,2,4} ) {
+        compare_concurrent<F32>(threads,1);
+        compare_concurrent<F32>(threads,3);
+    }
+}
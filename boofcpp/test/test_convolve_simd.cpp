@@ -0,0 +1,178 @@
+#include "gtest/gtest.h"
+#include "convolve.h"
+#include "cpu_features.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
+
+using namespace std;
+using namespace boofcv;
+
+/**
+ * Compares the SIMD code against the scalar code in ConvolveImage_Inner. Results should be identical. Image widths
+ * are selected so that the scalar tail is exercised and input/output images are subimages to test stride.
+ */
+template<class E, class R>
+class CompareSimdToScalar {
+public:
+    typedef typename TypeInfo<E>::signed_type signed_type;
+
+    std::mt19937 gen;
+    E minValue,maxValue;
+    // added to one of the kernel's weights. Large values prevent 16-bit arithmetic from being used
+    signed_type boost = 200;
+
+    CompareSimdToScalar( E minValue , E maxValue ) : gen(0xBEEF), minValue(minValue), maxValue(maxValue) {}
+
+    void setKernel( Kernel1D<signed_type>& kernel , uint32_t width , uint32_t offset ) {
+        kernel.reshape(width,offset);
+        KernelOps::fill_uniform(kernel,(signed_type)-10,(signed_type)10,gen);
+        // make sure the sum isn't zero so that it can be used as a divisor
+        kernel.data[offset] += boost;
+    }
+
+    template<class Operation>
+    void process( bool horizontal , Operation op ) {
+        if( !CpuFeatures::simd() ) {
+            printf("SIMD not available. Skipping\n");
+            return;
+        }
+
+        Kernel1D<signed_type> kernel;
+
+        for( uint32_t width = 3; width <= 13; width += 2 ) {
+            for( uint32_t offset = 0; offset < width; offset += width/2 ) {
+                setKernel(kernel,width,offset);
+
+                for( uint32_t size = width; size < width+20; size += 3 ) {
+                    uint32_t w = horizontal ? size : 9;
+                    uint32_t h = horizontal ? 5 : size;
+
+                    Gray<E> input(w,h);
+                    ImageMiscOps::fill_uniform(input,minValue,maxValue,gen);
+                    Gray<E> sub_input = create_subimage(input);
+                    Gray<R> expected(w,h), found(w,h);
+                    Gray<R> sub_found = create_subimage(found);
+
+                    CpuFeatures::setSimdEnabled(false);
+                    ASSERT_FALSE(op(kernel,input,expected));
+                    CpuFeatures::setSimdEnabled(true);
+                    ASSERT_TRUE(op(kernel,sub_input,sub_found));
+
+                    uint32_t borderX0=0,borderX1=0,borderY0=0,borderY1=0;
+                    if( horizontal ) {
+                        borderX0 = kernel.offset;
+                        borderX1 = kernel.width-1-kernel.offset;
+                    } else {
+                        borderY0 = kernel.offset;
+                        borderY1 = kernel.width-1-kernel.offset;
+                    }
+                    check_equals_inner(expected,sub_found,borderX0,borderX1,borderY0,borderY1,(R)0);
+
+                    sub_input.subimage = false;
+                    sub_found.subimage = false;
+                }
+            }
+        }
+    }
+
+    void horizontal() {
+        process(true,[](const Kernel1D<signed_type>& kernel, const Gray<E>& input , Gray<R>& output){
+            if( ConvolveImage_SIMD::horizontal(kernel,input,output) )
+                return true;
+            ConvolveImage_Inner::horizontal(kernel,input,output);
+            return false;
+        });
+    }
+
+    void vertical() {
+        process(false,[](const Kernel1D<signed_type>& kernel, const Gray<E>& input , Gray<R>& output){
+            if( ConvolveImage_SIMD::vertical(kernel,input,output) )
+                return true;
+            ConvolveImage_Inner::vertical(kernel,input,output);
+            return false;
+        });
+    }
+
+    void horizontal_div() {
+        process(true,[](const Kernel1D<signed_type>& kernel, const Gray<E>& input , Gray<R>& output){
+            if( ConvolveImage_SIMD::horizontal(kernel,input,output,kernel.sum()) )
+                return true;
+            ConvolveImage_Inner::horizontal(kernel,input,output,kernel.sum());
+            return false;
+        });
+    }
+
+    void vertical_div() {
+        process(false,[](const Kernel1D<signed_type>& kernel, const Gray<E>& input , Gray<R>& output){
+            if( ConvolveImage_SIMD::vertical(kernel,input,output,kernel.sum()) )
+                return true;
+            ConvolveImage_Inner::vertical(kernel,input,output,kernel.sum());
+            return false;
+        });
+    }
+};
+
+TEST(ConvolveImage_SIMD, horizontal) {
+    CompareSimdToScalar<U8,U8>(0,255).horizontal();
+    CompareSimdToScalar<U8,S16>(0,255).horizontal();
+    CompareSimdToScalar<U8,S32>(0,255).horizontal();
+    CompareSimdToScalar<S16,S16>(-30000,30000).horizontal();
+    CompareSimdToScalar<S16,S32>(-30000,30000).horizontal();
+    CompareSimdToScalar<F32,F32>(-100,100).horizontal();
+}
+
+TEST(ConvolveImage_SIMD, vertical) {
+    CompareSimdToScalar<U8,U8>(0,255).vertical();
+    CompareSimdToScalar<U8,S16>(0,255).vertical();
+    CompareSimdToScalar<U8,S32>(0,255).vertical();
+    CompareSimdToScalar<S16,S16>(-30000,30000).vertical();
+    CompareSimdToScalar<S16,S32>(-30000,30000).vertical();
+    CompareSimdToScalar<F32,F32>(-100,100).vertical();
+}
+
+TEST(ConvolveImage_SIMD, horizontal_div) {
+    CompareSimdToScalar<U8,U8>(0,255).horizontal_div();
+    CompareSimdToScalar<S16,S16>(-30000,30000).horizontal_div();
+    CompareSimdToScalar<F32,F32>(-100,100).horizontal_div();
+}
+
+TEST(ConvolveImage_SIMD, vertical_div) {
+    CompareSimdToScalar<U8,U8>(0,255).vertical_div();
+    CompareSimdToScalar<S16,S16>(-30000,30000).vertical_div();
+    CompareSimdToScalar<F32,F32>(-100,100).vertical_div();
+}
+
+/**
+ * Kernels which can't be computed using 16-bit integer math
+ */
+TEST(ConvolveImage_SIMD, large_weights) {
+    CompareSimdToScalar<U8,S32> alg_u8(0,255);
+    alg_u8.boost = 40000;
+    alg_u8.horizontal();
+    alg_u8.vertical();
+
+    CompareSimdToScalar<S16,S32> alg_s16(-30000,30000);
+    alg_s16.boost = 40000;
+    alg_s16.horizontal();
+    alg_s16.vertical();
+}
+
+/**
+ * If the float computation can't exactly match integer division then the scalar code should be used
+ */
+TEST(ConvolveImage_SIMD, divisor_too_large) {
+    Kernel1D<S32> kernel(1,{1,2000000,3});
+    Gray<U8> input(20,10), output(20,10);
+
+    ASSERT_FALSE(ConvolveImage_SIMD::horizontal(kernel,input,output,kernel.sum()));
+    ASSERT_FALSE(ConvolveImage_SIMD::vertical(kernel,input,output,kernel.sum()));
+    ASSERT_FALSE(ConvolveImage_SIMD::horizontal(kernel,input,output,0));
+}
+
+TEST(ConvolveImage_SIMD, unsupported_type) {
+    Kernel1D<S32> kernel(1,{1,2,3});
+    Gray<U16> input(20,10), output(20,10);
+
+    ASSERT_FALSE(ConvolveImage_SIMD::horizontal(kernel,input,output));
+    ASSERT_FALSE(ConvolveImage_SIMD::vertical(kernel,input,output,6));
+}
@@ -94,6 +94,28 @@ public:
         check_equals(expected,found);
     }
 
+    /**
+     * The fused version should produce identical results to two passes with a full size intermediate image
+     */
+    void mean_fused( uint32_t block_rows ) {
+        uint32_t radius = kernel.width/2;
+        Gray<E> tmp(input.width,input.height);
+        BlurImageOps::mean(input,expected,radius,tmp);
+        ConvolveImageMean::convolve(input,found,radius,block_rows);
+
+        check_equals(expected,found);
+    }
+
+    void gaussian_fused( int32_t kernel_width , uint32_t block_rows ) {
+        kernel = FactoryKernel::gaussian1D<signed_type>(-1,kernel_width);
+
+        Gray<E> tmp(input.width,input.height);
+        BlurImageOps::gaussian(input,expected,-1,kernel_width,tmp);
+        ConvolveNormalized::convolve(kernel,input,found,block_rows);
+
+        check_equals(expected,found);
+    }
+
     void checkResults_inner() {
         check_equals_inner(expected,found,borderX0,borderX1,borderY0,borderY1);
     }
@@ -234,3 +256,79 @@ TEST(BlurImageOps, gaussian) {
         compare.gaussian(4);
     }
 }
+
+template<class E>
+void check_fused_mean() {
+    CompareToNormalized<E> compare;
+
+    // includes images which are too small and use the two pass fallback
+    for( uint32_t h : {4,11,30,47} ) {
+        compare.setImageSize(25,h);
+        for( uint32_t radius : {1,2,5} ) {
+            compare.setMeanRadius(radius);
+            for( uint32_t block_rows : {0,1,2,5,100} ) {
+                compare.mean_fused(block_rows);
+            }
+        }
+    }
+}
+
+template<class E>
+void check_fused_gaussian() {
+    CompareToNormalized<E> compare;
+
+    for( uint32_t h : {4,11,30,47} ) {
+        compare.setImageSize(25,h);
+        for( int32_t width : {3,4,7,11} ) {
+            for( uint32_t block_rows : {0,1,2,5,100} ) {
+                compare.gaussian_fused(width,block_rows);
+            }
+        }
+    }
+}
+
+TEST(ConvolveImageMean, convolve_U8) {
+    check_fused_mean<U8>();
+}
+
+TEST(ConvolveImageMean, convolve_F32) {
+    check_fused_mean<F32>();
+}
+
+TEST(ConvolveNormalized, convolve_fused_U8) {
+    check_fused_gaussian<U8>();
+}
+
+TEST(ConvolveNormalized, convolve_fused_F32) {
+    check_fused_gaussian<F32>();
+}
+
+template<class E>
+void check_blur_concurrent() {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,2);
+
+    for( uint32_t h : {4,11,47} ) {
+        Gray<E> input(25,h), expected, found, storage;
+        ImageMiscOps::fill_uniform(input, (E)0, (E)50,gen);
+
+        for( uint32_t radius : {1,3,5} ) {
+            BlurImageOps::mean(input,expected,radius,storage);
+            BlurImageOps::mean(input,found,radius,storage,context);
+            check_equals(expected,found);
+
+            BlurImageOps::gaussian(input,expected,-1,radius*2+1,storage);
+            BlurImageOps::gaussian(input,found,-1,radius*2+1,storage,context);
+            check_equals(expected,found);
+        }
+    }
+}
+
+TEST(BlurImageOps, concurrent_U8) {
+    check_blur_concurrent<U8>();
+}
+
+TEST(BlurImageOps, concurrent_F32) {
+    check_blur_concurrent<F32>();
+}
@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "image_mapping.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
+
+#include <cstdio>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace boofcv;
+
+void write_file( const std::string& path , const std::string& header , const void* data , size_t bytes ) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(header.c_str(), header.size());
+    out.write(static_cast<const char*>(data), bytes);
+}
+
+std::string read_file( const std::string& path ) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+TEST(ImageMapping, mapPGM) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> expected(13,9);
+    ImageMiscOps::fill_uniform(expected,(U8)0,(U8)255,gen);
+
+    std::string path = "test_mapping.pgm";
+    std::string header = "P5\n# comment\n13 9\n255\n";
+    write_file(path,header,expected.data,expected.data_length);
+
+    {
+        Gray<U8> found = ImageMapping::mapPGM(path);
+        ASSERT_EQ(13,found.width);
+        ASSERT_EQ(9,found.height);
+        ASSERT_TRUE(found.subimage);
+        check_equals(expected,found);
+
+        // changes to a read only mapping are not written to the file
+        found.at(2,3) = static_cast<U8>(found.at(2,3)+1);
+        ASSERT_THROW(found.reshape(5,5),invalid_argument);
+    }
+    ASSERT_EQ(expected.at(2,3),static_cast<U8>(read_file(path)[header.size()+3*13+2]));
+
+    {
+        Gray<U8> found = ImageMapping::mapPGM(path,true);
+        found.at(2,3) = static_cast<U8>(expected.at(2,3)+1);
+    }
+    ASSERT_EQ(static_cast<U8>(expected.at(2,3)+1),static_cast<U8>(read_file(path)[header.size()+3*13+2]));
+
+    // only binary 8-bit images can be mapped
+    write_file(path,"P5 13 9 65535\n",expected.data,expected.data_length);
+    ASSERT_THROW(ImageMapping::mapPGM(path),runtime_error);
+    write_file(path,"P2 13 9 255\n",expected.data,expected.data_length);
+    ASSERT_THROW(ImageMapping::mapPGM(path),runtime_error);
+
+    std::remove(path.c_str());
+}
+
+TEST(ImageMapping, mapRaw) {
+    // 16-bit image with padded rows after a 32 byte header
+    std::vector<U16> pixels(20*7);
+    for( size_t i = 0; i < pixels.size(); i++ ) {
+        pixels[i] = static_cast<U16>(i*3);
+    }
+    std::string path = "test_mapping.raw";
+    write_file(path,std::string(32,'x'),pixels.data(),sizeof(U16)*pixels.size());
+
+    Gray<U16> sub;
+    {
+        Gray<U16> found = ImageMapping::mapRaw<U16>(path,15,7,32,20);
+        ASSERT_EQ(15,found.width);
+        ASSERT_EQ(20,found.stride);
+        ASSERT_EQ(0,found.offset);
+        for( uint32_t y = 0; y < found.height; y++ ) {
+            for( uint32_t x = 0; x < found.width; x++ ) {
+                ASSERT_EQ(pixels[y*20+x],found.at(x,y));
+            }
+        }
+        sub = found.makeSubimage(2,3,5,6);
+    }
+    // the mapping stays alive as long as a sub-image references it
+    ASSERT_EQ(pixels[3*20+2],sub.at(0,0));
+
+    // doesn't fit inside the file
+    ASSERT_THROW(ImageMapping::mapRaw<U16>(path,15,8,32,20),invalid_argument);
+    // not aligned to the pixel size
+    ASSERT_THROW(ImageMapping::mapRaw<U16>(path,15,7,31,20),invalid_argument);
+    ASSERT_THROW(ImageMapping::mapRaw<U16>(path,15,7,32,10),invalid_argument);
+    ASSERT_THROW(ImageMapping::mapRaw<U8>("no_such_file.raw",15,7),runtime_error);
+
+    std::remove(path.c_str());
+}
+
+#if !defined(_WIN32)
+TEST(ImageMapping, mapSharedMemory) {
+    std::string name = "/boofcpp_test_mapping";
+    uint32_t width = 10, height = 6, bands = 3;
+    size_t bytes = width*height*bands;
+
+    // the writer, e.g. a capture process
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    ASSERT_TRUE(fd >= 0);
+    ASSERT_EQ(0,ftruncate(fd,bytes));
+    auto* frame = static_cast<U8*>(mmap(nullptr,bytes,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0));
+    close(fd);
+    ASSERT_NE(MAP_FAILED,frame);
+
+    Gray<U8> gray = ImageMapping::mapSharedMemory<U8>(name,width*bands,height);
+    Interleaved<U8> color = ImageMapping::wrapInterleaved<U8>(
+            ImageMapping::mapSharedMemory(name,bytes),width,height,bands);
+
+    // new frames show up without being copied
+    for( int trial = 0; trial < 2; trial++ ) {
+        for( size_t i = 0; i < bytes; i++ ) {
+            frame[i] = static_cast<U8>(i+trial);
+        }
+        ASSERT_EQ(frame[4*30+5],gray.at(5,4));
+        ASSERT_EQ(frame[4*30+3*3+2],color.at(3,4,2));
+    }
+
+    ASSERT_THROW(ImageMapping::mapSharedMemory<U8>(name,width*bands,height+1),runtime_error);
+
+    munmap(frame,bytes);
+    shm_unlink(name.c_str());
+}
+#endif
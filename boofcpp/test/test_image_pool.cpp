@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+#include "image_pool.h"
+#include "binary_ops.h"
+#include "threshold_block_filters.h"
+#include "contour.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
+
+using namespace std;
+using namespace boofcv;
+
+class CountingAllocator : public ImageAllocator {
+public:
+    AlignedImageAllocator aligned;
+    uint32_t allocated = 0;
+    uint32_t freed = 0;
+
+    void* allocate( size_t bytes ) override {
+        allocated++;
+        return aligned.allocate(bytes);
+    }
+
+    void deallocate( void* ptr , size_t bytes ) override {
+        freed++;
+        aligned.deallocate(ptr,bytes);
+    }
+};
+
+TEST(ImagePool, recycle) {
+    ImagePool pool;
+
+    U8* pixels;
+    {
+        Gray<U8> img = pool.gray<U8>(10,20);
+        pixels = img.data;
+        ASSERT_EQ(1,pool.getHeapAllocations());
+        ASSERT_EQ(1,pool.getOutstanding());
+    }
+    ASSERT_EQ(0,pool.getOutstanding());
+    ASSERT_EQ(200,pool.getCachedBytes());
+
+    // same type and shape gets the same array
+    Gray<U8> a = pool.gray<U8>(20,10);
+    ASSERT_EQ(pixels,a.data);
+    ASSERT_EQ(1,pool.getReused());
+
+    // nothing to recycle so another array is allocated
+    Gray<U8> b = pool.gray<U8>(10,20);
+    Gray<F32> c = pool.gray<F32>(10,20);
+    Interleaved<U8> d = pool.interleaved<U8>(10,20,3,true);
+    ASSERT_EQ(4,pool.getHeapAllocations());
+    ASSERT_EQ(4,pool.getOutstanding());
+    ASSERT_EQ(0,reinterpret_cast<uintptr_t>(c.data) % BOOFCPP_IMAGE_ALIGNMENT);
+    ASSERT_EQ(BOOFCPP_IMAGE_ALIGNMENT,d.stride);
+
+    // growing an image hands the old array back
+    a.reshape(30,30);
+    ASSERT_EQ(5,pool.getHeapAllocations());
+    ASSERT_EQ(200,pool.getCachedBytes());
+}
+
+TEST(ImagePool, clear) {
+    CountingAllocator counter;
+    {
+        ImagePool pool(&counter);
+        {
+            Gray<U8> a = pool.gray<U8>(10,20);
+            Gray<U8> b = pool.gray<U8>(5,5);
+        }
+        ASSERT_EQ(2,counter.allocated);
+        ASSERT_EQ(0,counter.freed);
+
+        pool.clear();
+        ASSERT_EQ(2,counter.freed);
+        ASSERT_EQ(0,pool.getCachedBytes());
+
+        Gray<U8> a = pool.gray<U8>(10,20);
+        ASSERT_EQ(3,counter.allocated);
+    }
+    // the pool outlived the image so its array was handed back before the pool freed everything
+    ASSERT_EQ(3,counter.freed);
+}
+
+/**
+ * Processes a sequence of frames the same way a video loop would and checks that after the first frame
+ * no pixel memory is allocated
+ */
+TEST(ImagePool, steady_state) {
+    std::mt19937 gen(0xBEEF);
+    ImagePool pool;
+
+    LocalMeanBinaryFilter<U8> thresholder(ConfigLength::fixed(11),0.95f,true);
+    LocalMeanBinaryFilter<U8> thresholder_integral(ConfigLength::fixed(11),0.95f,true,true);
+    thresholder.pool = &pool;
+    thresholder_integral.pool = &pool;
+    LinearContourLabelChang2004 alg(ConnectRule::EIGHT);
+    alg.pool = &pool;
+    // work buffers for each band of blocks come from the pool
+    ThresholdBlockOtsu<U8> otsu(false,ConfigLength::fixed(9),0.0,1.0,true,true);
+    ThresholdBlockMean<U8> interpolated(ConfigLength::fixed(9),true,0.95,true);
+    interpolated.setInterpolateThresholds(true);
+    otsu.pool = &pool;
+    interpolated.pool = &pool;
+
+    Gray<U8> input(60,45), blurred, box, binary;
+    Gray<S32> labeled;
+
+    for( int frame = 0; frame < 5; frame++ ) {
+        ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+
+        BlurImageOps::gaussian(input,blurred,-1,5,pool);
+        BlurImageOps::mean(input,box,3,pool);
+        binary.reshape(input.width,input.height);
+        otsu.process(blurred,binary);
+        interpolated.process(blurred,binary);
+        thresholder_integral.process(blurred,binary);
+        thresholder.process(blurred,binary);
+        alg.process(blurred,thresholder,labeled);
+
+        if( frame == 0 ) {
+            pool.resetCounters();
+        } else {
+            ASSERT_EQ(0,pool.getHeapAllocations());
+            ASSERT_TRUE(pool.getReused() > 0);
+        }
+        ASSERT_EQ(0,pool.getOutstanding());
+    }
+
+    // the results should be the same as without a pool
+    Gray<U8> expected_blurred, expected_box;
+    BlurImageOps::gaussian(input,expected_blurred,-1,5);
+    BlurImageOps::mean(input,expected_box,3);
+    check_equals(expected_blurred,blurred,(U8)0);
+    check_equals(expected_box,box,(U8)0);
+
+    // the results should be the same as when the filter has its own storage
+    LocalMeanBinaryFilter<U8> expected(ConfigLength::fixed(11),0.95f,true);
+    Gray<U8> expected_binary;
+    expected.process(blurred,expected_binary);
+    check_equals(expected_binary,binary);
+}
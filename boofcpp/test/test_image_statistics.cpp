@@ -90,4 +90,30 @@ TEST(ImageStatistics, histogram_FLOAT) {
             ASSERT_EQ(0,histogram[i]);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(ImageStatistics, concurrent) {
+    std::mt19937 gen(0xBEEF);
+    ThreadPool pool(3);
+    ConcurrencyContext context(pool,1);
+
+    Gray<U8> image(30,41);
+    ImageMiscOps::fill_uniform(image,(U8)5,(U8)200,gen);
+
+    // make sure a subimage is handled correctly
+    Gray<U8> sub = image.makeSubimage(2,3,25,40);
+    Gray<U8> copy(sub.width,sub.height);
+    copy.copy(sub);
+
+    ASSERT_EQ(ImageStatistics::min(copy),ImageStatistics::min(sub,context));
+    ASSERT_EQ(ImageStatistics::max(copy),ImageStatistics::max(sub,context));
+    ASSERT_EQ(ImageStatistics::sum(sub),ImageStatistics::sum(sub,context));
+    ASSERT_EQ(ImageStatistics::mean(sub),ImageStatistics::mean(sub,context));
+
+    GrowArray<uint32_t> expected(256), found(256);
+    ImageStatistics::histogram(sub,(U8)0,expected);
+    ImageStatistics::histogram(sub,(U8)0,found,context);
+    for( uint32_t i = 0; i < 256; i++ ) {
+        ASSERT_EQ(expected[i],found[i]);
+    }
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "image_stream.h"
+#include "testing_utils.h"
+
+using namespace std;
+using namespace boofcv;
+
+/**
+ * Pushes the image in strips with the specified heights, cycling through them until the image is done
+ */
+template<class I, class O>
+void push_strips( const Gray<I>& input , RowStream<I,O>& stream , const std::vector<uint32_t>& heights ,
+                  uint32_t radius ) {
+    uint32_t y = 0;
+    for( size_t i = 0; y < input.height; i++ ) {
+        uint32_t h = std::min(heights[i%heights.size()],input.height-y);
+        stream.push(input.makeSubimage(0,y,input.width,y+h));
+        y += h;
+        // rows can only be emitted once the rows below them have arrived
+        ASSERT_EQ(y > radius ? y-radius : 0,stream.getRowsEmitted());
+        // only the rows which are still needed are kept
+        ASSERT_TRUE(stream.getRowsBuffered() <= 2*radius+h);
+    }
+    stream.finish();
+    ASSERT_EQ(input.height,stream.getRowsEmitted());
+}
+
+/**
+ * Creates a consumer which copies rows into the image
+ */
+template<class O>
+typename RowStream<O,O>::Consumer copy_into( Gray<O>& found ) {
+    return [&found](const Gray<O>& rows, uint32_t y0) {
+        found.makeSubimage(0,y0,found.width,y0+rows.height).copy(rows);
+    };
+}
+
+const std::vector<std::vector<uint32_t>> STRIP_HEIGHTS = {{1},{2,5},{7},{40}};
+
+TEST(RowStream, threshold) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(23,37);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+
+    Gray<U8> expected;
+    ThresholdOps::threshold(input,(U8)100,true,expected);
+
+    for( auto& heights : STRIP_HEIGHTS ) {
+        Gray<U8> found(input.width,input.height);
+        auto stream = FactoryRowStream::threshold<U8>(100,true,copy_into(found));
+        push_strips(input,stream,heights,0);
+        check_equals(expected,found);
+    }
+}
+
+template<class E>
+void check_convolve( uint32_t height ) {
+    typedef typename TypeInfo<E>::signed_type signed_type;
+    std::mt19937 gen(0xBEEF);
+    Gray<E> input(23,height);
+    ImageMiscOps::fill_uniform(input,(E)0,(E)100,gen);
+
+    Kernel1D<signed_type> kernel = FactoryKernel::gaussian1D<signed_type>(-1,7);
+
+    Gray<E> expected;
+    ConvolveNormalized::convolve(kernel,input,expected);
+
+    for( auto& heights : STRIP_HEIGHTS ) {
+        Gray<E> found(input.width,input.height);
+        auto stream = FactoryRowStream::convolve<E>(kernel,copy_into(found));
+        push_strips(input,stream,heights,3);
+        check_equals(expected,found);
+
+        // the stream can be used again
+        ImageMiscOps::fill(found,(E)0);
+        stream.reset();
+        push_strips(input,stream,heights,3);
+        check_equals(expected,found);
+    }
+}
+
+TEST(RowStream, convolve) {
+    check_convolve<U8>(37);
+    check_convolve<S16>(37);
+    check_convolve<F32>(37);
+    // image is smaller than the kernel
+    check_convolve<U8>(5);
+    check_convolve<F32>(5);
+}
+
+TEST(RowStream, morphology) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(23,37);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)2,gen);
+
+    for( int dilate = 0; dilate < 2; dilate++ ) {
+        Gray<U8> expected(input.width,input.height);
+        if( dilate )
+            BinaryImageOps::dilate4(input,expected);
+        else
+            BinaryImageOps::erode4(input,expected);
+
+        for( auto& heights : STRIP_HEIGHTS ) {
+            Gray<U8> found(input.width,input.height);
+            ImageMiscOps::fill(found,(U8)5);
+            auto stream = dilate ? FactoryRowStream::dilate4(copy_into(found)) :
+                                   FactoryRowStream::erode4(copy_into(found));
+            push_strips(input,stream,heights,1);
+            check_equals(expected,found);
+        }
+    }
+}
+
+TEST(RowStream, chained) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(23,37);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+
+    Gray<U8> binary, expected(input.width,input.height);
+    ThresholdOps::threshold(input,(U8)100,false,binary);
+    BinaryImageOps::dilate4(binary,expected);
+
+    // output from the threshold is passed straight into the dilate
+    Gray<U8> found(input.width,input.height);
+    auto dilate = FactoryRowStream::dilate4(copy_into(found));
+    auto threshold = FactoryRowStream::threshold<U8>(100,false,[&dilate](const Gray<U8>& rows, uint32_t){
+        dilate.push(rows);
+    });
+
+    for( uint32_t y = 0; y < input.height; y += 3 ) {
+        threshold.push(input.makeSubimage(0,y,input.width,std::min(input.height,y+3)));
+    }
+    threshold.finish();
+    dilate.finish();
+    check_equals(expected,found);
+}
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 #include "binary_ops.h"
 
+#include <utility>
+
 using namespace std;
 using namespace boofcv;
 
@@ -95,6 +97,101 @@ TEST(Gray, reshape) {
     }
 }
 
+TEST(Gray, reshape_uninitialized) {
+    Gray<U8> img(10, 20, ImageAllocation::uninitialized());
+    ASSERT_FALSE(img.zero_pixels);
+
+    // the setting is kept by copies so they grow the same way
+    Gray<U8> copy(img);
+    ASSERT_FALSE(copy.zero_pixels);
+
+    Gray<U8> zeroed(10, 20);
+    ASSERT_TRUE(zeroed.zero_pixels);
+    zeroed.reserve(30,20);
+    for( uint32_t i = 0; i < zeroed.data_length; i++ ) {
+        ASSERT_EQ(0,zeroed.data[i]);
+    }
+}
+
+/**
+ * Counts how many times memory is allocated and freed
+ */
+class CountingAllocator : public ImageAllocator {
+public:
+    AlignedImageAllocator aligned;
+    uint32_t allocated = 0;
+    uint32_t freed = 0;
+
+    void* allocate( size_t bytes ) override {
+        allocated++;
+        return aligned.allocate(bytes);
+    }
+
+    void deallocate( void* ptr , size_t bytes ) override {
+        freed++;
+        aligned.deallocate(ptr,bytes);
+    }
+};
+
+TEST(Gray, aligned) {
+    for( uint32_t width = 1; width < 70; width += 7 ) {
+        Gray<U8> img(width,3);
+        ASSERT_EQ(0,reinterpret_cast<uintptr_t>(img.data) % BOOFCPP_IMAGE_ALIGNMENT);
+
+        img.reshape(width*10,20);
+        ASSERT_EQ(0,reinterpret_cast<uintptr_t>(img.data) % BOOFCPP_IMAGE_ALIGNMENT);
+    }
+}
+
+TEST(Gray, pad_rows) {
+    Gray<F32> img(10, 20, ImageAllocation::padded());
+
+    ASSERT_TRUE(img.pad_rows);
+    ASSERT_EQ(10,img.width);
+    ASSERT_EQ(BOOFCPP_IMAGE_ALIGNMENT/sizeof(F32),img.stride);
+    ASSERT_EQ(img.stride*20,img.data_length);
+    for( uint32_t y = 0; y < img.height; y++ ) {
+        ASSERT_EQ(0,reinterpret_cast<uintptr_t>(&img.data[img.index_of(0,y)]) % BOOFCPP_IMAGE_ALIGNMENT);
+        for( uint32_t x = 0; x < img.width; x++ ) {
+            ASSERT_EQ(0,img.at(x,y));
+        }
+    }
+
+    // the stride should stay padded after a reshape
+    img.reshape(17,5);
+    ASSERT_EQ(2*BOOFCPP_IMAGE_ALIGNMENT/sizeof(F32),img.stride);
+
+    // copying from an image without padding
+    Gray<F32> src(17,5);
+    src.at(16,4) = 2;
+    img.copy(src);
+    ASSERT_EQ(2,img.at(16,4));
+}
+
+TEST(Gray, allocator) {
+    CountingAllocator counter;
+
+    {
+        Gray<U8> img(10, 20, ImageAllocation(false,true,&counter));
+        ASSERT_EQ(1,counter.allocated);
+        img.reshape(5,5);
+        ASSERT_EQ(1,counter.allocated);
+        img.reshape(50,50);
+        ASSERT_EQ(2,counter.allocated);
+        ASSERT_EQ(1,counter.freed);
+    }
+    ASSERT_EQ(2,counter.freed);
+
+    // change the default allocator
+    ImageAllocator::setDefault(&counter);
+    Gray<U8> *img = new Gray<U8>(10,20);
+    ImageAllocator::setDefault(nullptr);
+    ASSERT_EQ(3,counter.allocated);
+    // memory should be freed by the allocator which allocated it
+    delete img;
+    ASSERT_EQ(3,counter.freed);
+}
+
 TEST(Gray, makeSubimage) {
     Gray<U8> img(10, 20);
     Gray<U8> sub = img.makeSubimage(2,3,6,10);
@@ -108,6 +205,176 @@ TEST(Gray, makeSubimage) {
     ASSERT_EQ(2,img.at(2,3));
 }
 
+TEST(Gray, makeSubimage_shared) {
+    CountingAllocator counter;
+    auto* img = new Gray<U8>(10, 20, ImageAllocation(false,true,&counter));
+    img->at(3,4) = 7;
+    {
+        auto* sub = new Gray<U8>(img->makeSubimage(2,3,6,10));
+        Gray<U8> sub_sub = sub->makeSubimage(1,1,3,3);
+
+        // the sub-images keep the pixels alive after the parent is gone
+        delete img;
+        ASSERT_EQ(0,counter.freed);
+        ASSERT_TRUE(sub->isValid());
+        ASSERT_EQ(7,sub->at(1,1));
+
+        delete sub;
+        ASSERT_EQ(0,counter.freed);
+        ASSERT_EQ(7,sub_sub.at(0,0));
+    }
+    ASSERT_EQ(1,counter.freed);
+}
+
+TEST(Gray, makeSubimage_stale) {
+    Gray<U8> img(10, 20);
+    Gray<U8> sub = img.makeSubimage(2,3,6,10);
+    ASSERT_TRUE(sub.isValid());
+
+    // same shape so nothing changes
+    img.reshape(10,20);
+    ASSERT_TRUE(sub.isValid());
+
+    // memory isn't reallocated but the rows no longer line up
+    img.reshape(5,20);
+    ASSERT_FALSE(sub.isValid());
+    ASSERT_TRUE(img.isValid());
+    ASSERT_TRUE(img.makeSubimage(0,0,2,2).isValid());
+#if BOOFCPP_CHECK_SUBIMAGES
+    ASSERT_THROW(sub.at(0,0),logic_error);
+#endif
+
+    // parent moves onto a larger array
+    Gray<U8> sub2 = img.makeSubimage(0,0,2,2);
+    img.reserve(100,100);
+    ASSERT_FALSE(sub2.isValid());
+    ASSERT_TRUE(img.isValid());
+
+    // wrapped arrays are never stale
+    U8 pixels[20];
+    Gray<U8> wrapped(pixels,20,4,5,0,4);
+    ASSERT_TRUE(wrapped.makeSubimage(1,1,2,2).isValid());
+}
+
+TEST(Gray, wrap) {
+    U8 pixels[4*5];
+    for( uint32_t i = 0; i < 20; i++ ) {
+        pixels[i] = static_cast<U8>(i);
+    }
+
+    Gray<U8> view = Gray<U8>::wrap(pixels,3,5,4);
+    ASSERT_EQ(pixels,view.data);
+    ASSERT_EQ(3,view.width);
+    ASSERT_EQ(4,view.stride);
+    ASSERT_TRUE(view.subimage);
+    ASSERT_EQ(9,view.at(1,2));
+
+    // same shape is fine, anything else isn't
+    view.reshape(3,5);
+    ASSERT_THROW(view.reshape(4,5),invalid_argument);
+    ASSERT_THROW(Gray<U8>::wrap(pixels,3,5,2),invalid_argument);
+
+    Interleaved<U8> color = Interleaved<U8>::wrap(pixels,2,5,2);
+    ASSERT_EQ(4,color.stride);
+    ASSERT_EQ(11,color.at(1,2,1));
+}
+
+TEST(Gray, copy_constructor) {
+    Gray<U8> img(10, 20, ImageAllocation::padded());
+    img.at(4,5) = 8;
+
+    // owning images are deep copied with the same padding
+    Gray<U8> copy(img);
+    ASSERT_NE(img.data,copy.data);
+    ASSERT_FALSE(copy.subimage);
+    ASSERT_TRUE(copy.pad_rows);
+    ASSERT_EQ(img.stride,copy.stride);
+    ASSERT_EQ(8,copy.at(4,5));
+
+    // sub-images reference the same pixels
+    Gray<U8> sub = img.makeSubimage(2,3,6,10);
+    Gray<U8> sub_copy(sub);
+    ASSERT_TRUE(sub_copy.subimage);
+    ASSERT_EQ(img.data,sub_copy.data);
+    ASSERT_EQ(8,sub_copy.at(2,2));
+}
+
+TEST(Gray, move) {
+    CountingAllocator counter;
+    {
+        Gray<U8> img(10, 20, ImageAllocation(false,true,&counter));
+        U8* pixels = img.data;
+
+        Gray<U8> moved(std::move(img));
+        ASSERT_EQ(pixels,moved.data);
+        ASSERT_EQ(10,moved.width);
+        ASSERT_EQ(20,moved.height);
+        ASSERT_EQ(0,img.width);
+        ASSERT_EQ(nullptr,img.data);
+
+        Gray<U8> assigned(5,5);
+        assigned = std::move(moved);
+        ASSERT_EQ(pixels,assigned.data);
+        ASSERT_EQ(10,assigned.width);
+        ASSERT_EQ(&counter,assigned.allocator);
+
+        // moving into a sub-image copies the pixels into the parent
+        Gray<U8> parent(20,30);
+        Gray<U8> sub = parent.makeSubimage(5,5,15,25);
+        assigned.at(1,2) = 7;
+        sub = std::move(assigned);
+        ASSERT_EQ(7,parent.at(6,7));
+
+        // storing images in a vector shouldn't copy any pixels
+        std::vector<Gray<U8>> frames;
+        for( int i = 0; i < 10; i++ ) {
+            frames.emplace_back(10,10,ImageAllocation(false,true,&counter));
+        }
+        ASSERT_EQ(11,counter.allocated);
+    }
+    ASSERT_EQ(11,counter.freed);
+}
+
+TEST(Gray, swap) {
+    Gray<U8> a(10, 20);
+    Gray<U8> b(5, 6, ImageAllocation::padded());
+    U8* data_a = a.data;
+    U8* data_b = b.data;
+
+    swap(a,b);
+    ASSERT_EQ(data_b,a.data);
+    ASSERT_EQ(5,a.width);
+    ASSERT_EQ(6,a.height);
+    ASSERT_TRUE(a.pad_rows);
+    ASSERT_EQ(data_a,b.data);
+    ASSERT_EQ(10,b.width);
+    ASSERT_EQ(20,b.height);
+    ASSERT_FALSE(b.pad_rows);
+}
+
+TEST(Gray, reserve) {
+    CountingAllocator counter;
+    Gray<U8> img(10, 20, ImageAllocation(false,true,&counter));
+    img.at(3,4) = 9;
+
+    img.reserve(100,50);
+    ASSERT_EQ(2,counter.allocated);
+    ASSERT_EQ(1,counter.freed);
+    ASSERT_EQ(10,img.width);
+    ASSERT_EQ(20,img.height);
+    ASSERT_EQ(5000,img.data_length);
+    ASSERT_EQ(9,img.at(3,4));
+
+    // reshaping inside of the reserved memory doesn't allocate
+    img.reshape(100,50);
+    img.reshape(30,60);
+    img.reserve(40,40);
+    ASSERT_EQ(2,counter.allocated);
+
+    Gray<U8> sub = img.makeSubimage(0,0,5,5);
+    ASSERT_THROW(sub.reserve(100,100),invalid_argument);
+}
+
 TEST(Planar, Constructor_WH) {
 
 }
@@ -125,11 +392,62 @@ TEST(Planar, reshape) {
 }
 
 TEST(Planar, setNumberOfBands) {
+    Planar<Gray<U8>> img(10, 15, 2);
+    Gray<U8>& band0 = img.getBand(0);
+    band0.at(1,2) = 3;
+
+    img.setNumberOfBands(4);
+    ASSERT_EQ(4,img.num_bands);
+    ASSERT_EQ(&band0,&img.getBand(0));
+    ASSERT_EQ(3,img.at(1,2,0));
+    ASSERT_EQ(10,img.getBand(3).width);
+    ASSERT_EQ(15,img.getBand(3).height);
 
+    img.setNumberOfBands(1);
+    ASSERT_EQ(1,img.num_bands);
+    ASSERT_EQ(3,img.at(1,2,0));
+    ASSERT_THROW(img.getBand(1),invalid_argument);
 }
 
 TEST(Planar, setTo) {
+    Planar<Gray<U8>> src(10, 15, 3);
+    src.at(4,5,2) = 6;
+
+    Planar<Gray<U8>> dst(2, 3, 1);
+    dst.setTo(src);
+    ASSERT_EQ(10,dst.width);
+    ASSERT_EQ(15,dst.height);
+    ASSERT_EQ(3,dst.num_bands);
+    ASSERT_EQ(6,dst.at(4,5,2));
+    ASSERT_NE(src.getBand(2).data,dst.getBand(2).data);
+}
+
+TEST(Planar, move) {
+    Planar<Gray<U8>> img(10, 15, 3);
+    U8* pixels = img.getBand(1).data;
+
+    Planar<Gray<U8>> moved(std::move(img));
+    ASSERT_EQ(pixels,moved.getBand(1).data);
+    ASSERT_EQ(3,moved.num_bands);
+    ASSERT_EQ(10,moved.width);
+    ASSERT_EQ(0,img.num_bands);
+
+    Planar<Gray<U8>> assigned;
+    assigned = std::move(moved);
+    ASSERT_EQ(pixels,assigned.getBand(1).data);
 
+    Planar<Gray<U8>> copy(assigned);
+    ASSERT_NE(pixels,copy.getBand(1).data);
+    ASSERT_EQ(3,copy.num_bands);
+}
+
+TEST(Planar, reserve) {
+    Planar<Gray<U8>> img(10, 15, 2);
+    img.reserve(20,30);
+    ASSERT_EQ(10,img.width);
+    U8* pixels = img.getBand(1).data;
+    img.reshape(20,30);
+    ASSERT_EQ(pixels,img.getBand(1).data);
 }
 
 TEST(Planar, makeSubimage) {
@@ -263,6 +581,18 @@ TEST(Interleaved, setTo) {
     }
 }
 
+TEST(Interleaved, pad_rows) {
+    Interleaved<U8> img(10, 15, 3, ImageAllocation::padded());
+
+    ASSERT_EQ(BOOFCPP_IMAGE_ALIGNMENT,img.stride);
+    ASSERT_EQ(0,reinterpret_cast<uintptr_t>(img.data) % BOOFCPP_IMAGE_ALIGNMENT);
+
+    img.setNumberOfBands(10);
+    ASSERT_EQ(2*BOOFCPP_IMAGE_ALIGNMENT,img.stride);
+    img.at(9,14,9) = 5;
+    ASSERT_EQ(5,img.data[14*img.stride + 9*10 + 9]);
+}
+
 TEST(Interleaved, makeSubimage) {
     Interleaved<U8> img(10, 15, 2);
 
@@ -278,4 +608,57 @@ TEST(Interleaved, makeSubimage) {
 
     subimage.at(0,0,1) = 5;
     ASSERT_EQ(5,img.at(2,3,1));
-}
\ No newline at end of file
+}
+
+TEST(Interleaved, move) {
+    Interleaved<U8> img(10, 15, 2);
+    U8* pixels = img.data;
+
+    Interleaved<U8> moved(std::move(img));
+    ASSERT_EQ(pixels,moved.data);
+    ASSERT_EQ(2,moved.num_bands);
+    ASSERT_EQ(0,img.num_bands);
+    ASSERT_EQ(nullptr,img.data);
+
+    Interleaved<U8> assigned;
+    assigned = std::move(moved);
+    ASSERT_EQ(pixels,assigned.data);
+
+    // deep copy
+    assigned.at(3,4,1) = 2;
+    Interleaved<U8> copy(assigned);
+    ASSERT_NE(pixels,copy.data);
+    ASSERT_EQ(2,copy.at(3,4,1));
+
+    swap(copy,img);
+    ASSERT_EQ(2,img.at(3,4,1));
+    ASSERT_EQ(0,copy.width);
+}
+
+TEST(Interleaved, reserve) {
+    Interleaved<U8> img(10, 15, 2);
+    img.at(3,4,1) = 5;
+
+    img.reserve(20,30,3);
+    ASSERT_EQ(10,img.width);
+    ASSERT_EQ(2,img.num_bands);
+    ASSERT_EQ(5,img.at(3,4,1));
+
+    U8* pixels = img.data;
+    img.reshape(20,30,3);
+    ASSERT_EQ(pixels,img.data);
+}
+
+TEST(Interleaved, makeSubimage_shared) {
+    auto* img = new Interleaved<U8>(10, 15, 2);
+    img->at(3,4,1) = 6;
+    Interleaved<U8> sub = img->makeSubimage(2,3,8,5);
+    Interleaved<U8> sub2 = img->makeSubimage(2,3,8,5);
+
+    img->setNumberOfBands(3);
+    ASSERT_FALSE(sub.isValid());
+    delete img;
+
+    // the pixels are still there after the parent is gone
+    ASSERT_EQ(6,sub2.unsafe_at(1,1,1));
+}
@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+#include "integral_image.h"
+#include "cpu_features.h"
+#include "image_misc_ops.h"
+#include "testing_utils.h"
+
+using namespace std;
+using namespace boofcv;
+
+/**
+ * Computes the sum inside a rectangle the slow way
+ */
+template<class E, class I>
+I naive_sum( const Gray<E>& input , uint32_t x0 , uint32_t y0 , uint32_t x1 , uint32_t y1 ) {
+    I total = 0;
+    for( uint32_t y = y0; y < y1; y++ ) {
+        for( uint32_t x = x0; x < x1; x++ ) {
+            total += static_cast<I>(input.at(x,y));
+        }
+    }
+    return total;
+}
+
+template<class E>
+void check_transform( E min_value , E max_value ) {
+    typedef typename IntegralImageType<E>::type I;
+    std::mt19937 gen(0xBEEF);
+
+    Gray<E> input(21,15);
+    ImageMiscOps::fill_uniform(input,min_value,max_value,gen);
+    Gray<E> sub_input = create_subimage(input);
+
+    Gray<I> integral;
+    IntegralImageOps::transform(sub_input,integral);
+
+    ASSERT_EQ(input.width+1,integral.width);
+    ASSERT_EQ(input.height+1,integral.height);
+
+    for( uint32_t y = 0; y <= input.height; y++ ) {
+        for( uint32_t x = 0; x <= input.width; x++ ) {
+            double expected = naive_sum<E,I>(input,0,0,x,y);
+            ASSERT_NEAR(expected,(double)integral.at(x,y),1e-8);
+        }
+    }
+
+    double expected = naive_sum<E,I>(input,3,2,10,9);
+    ASSERT_NEAR(expected,(double)IntegralImageOps::block_sum(integral,3u,2u,10u,9u),1e-8);
+    expected = naive_sum<E,I>(input,0,0,21,15);
+    ASSERT_NEAR(expected,(double)IntegralImageOps::block_sum(integral,0u,0u,21u,15u),1e-8);
+}
+
+TEST(IntegralImageOps, transform) {
+    check_transform<U8>(0,255);
+    check_transform<S16>(-1000,1000);
+    check_transform<S32>(-1000,1000);
+    check_transform<F32>(-10,10);
+}
+
+TEST(IntegralImageOps, transform_wrap_around) {
+    // the sum of all the pixels can't fit inside of 32-bits, so the integral image wraps around
+    Gray<U8> input(8000,2200);
+    ImageMiscOps::fill(input,(U8)255);
+
+    Gray<uint32_t> integral;
+    IntegralImageOps::transform(input,integral);
+
+    // the sum inside of a small rectangle is still correct
+    ASSERT_EQ(255u*20*10,IntegralImageOps::block_sum(integral,7980u,2190u,8000u,2200u));
+}
+
+TEST(IntegralImage_SIMD, transform) {
+    if( !CpuFeatures::simd() ) {
+        printf("SIMD not available. Skipping\n");
+        return;
+    }
+    std::mt19937 gen(0xBEEF);
+
+    for( uint32_t width = 1; width < 40; width += 3 ) {
+        Gray<U8> input(width,7);
+        ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+        Gray<U8> sub_input = create_subimage(input);
+
+        Gray<uint32_t> expected, found;
+        CpuFeatures::setSimdEnabled(false);
+        IntegralImageOps::transform(input,expected);
+        CpuFeatures::setSimdEnabled(true);
+        IntegralImageOps::transform(sub_input,found);
+
+        for( uint32_t y = 0; y < expected.height; y++ ) {
+            for( uint32_t x = 0; x < expected.width; x++ ) {
+                ASSERT_EQ(expected.at(x,y),found.at(x,y));
+            }
+        }
+    }
+}
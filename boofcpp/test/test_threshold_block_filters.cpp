@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include <random>
 #include "threshold_block_filters.h"
+#include "cpu_features.h"
 #include "image_misc_ops.h"
 #include "testing_utils.h"
 
@@ -119,6 +120,33 @@ public:
         sub_input.subimage = false;
         sub_output.subimage = false;
     }
+
+    /**
+     * Processing blocks concurrently should produce identical results
+     */
+    void concurrent() {
+        typedef typename T::pixel_type E;
+
+        // size is selected so that blocks don't evenly divide the image
+        T input(103,121);
+        ImageMiscOps::fill_uniform(input,(E)0,(E)255,gen);
+
+        Gray<U8> expected(input.width,input.height);
+        Gray<U8> found(input.width,input.height);
+
+        ThreadPool pool(3);
+
+        for( bool down : {true,false} ) {
+            create_algorithm(7,1.0,down);
+            alg->process(input,expected);
+
+            for( uint32_t grain : {1,10,1000} ) {
+                alg->concurrency = ConcurrencyContext(pool,grain);
+                alg->process(input,found);
+                check_equals(expected,found);
+            }
+        }
+    }
 };
 
 template<class E>
@@ -141,6 +169,7 @@ TEST(ThresholdBlockMean, standard_tests_U8) {
     standard_tests.toggle_down();
     standard_tests.widthLargerThanImage();
     standard_tests.subimage();
+    standard_tests.concurrent();
 }
 
 template<class E>
@@ -163,6 +192,144 @@ TEST(ThresholdBlockOtsu, standard_tests_U8) {
     standard_tests.toggle_down();
     standard_tests.widthLargerThanImage();
     standard_tests.subimage();
+    standard_tests.concurrent();
+}
+
+/**
+ * Compares against a brute force implementation which sums the histograms in the local region for every block
+ */
+void check_otsu_brute_force( bool local , bool otsu2 , uint32_t width , uint32_t height , uint32_t blockWidth ,
+                             uint32_t bins = 256 ) {
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(width,height);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+    // add structure so that thresholds vary between blocks
+    for( uint32_t y = 0; y < height; y++ ) {
+        for( uint32_t x = 0; x < width; x++ ) {
+            input.at(x,y) = (U8)((input.at(x,y) + 3*x + y)/3);
+        }
+    }
+
+    ThresholdBlockOtsu<U8> alg(otsu2,ConfigLength::fixed(blockWidth),0.5,0.95,true,local,bins);
+    Gray<U8> found(width,height);
+    alg.process(input,found);
+
+    const Interleaved<S32>& stats = alg.stats;
+    GrowArray<uint32_t> histogram(bins), block(bins);
+    ComputeOtsu otsu(otsu2,0.5,true,0.95);
+    otsu.binWidth = 256/bins;
+    uint32_t r = local ? 1 : 0;
+    for( uint32_t by = 0; by < stats.height; by++ ) {
+        for( uint32_t bx = 0; bx < stats.width; bx++ ) {
+            histogram.fill(0);
+            uint32_t total = 0;
+            for( uint32_t y = by > r ? by-r : 0; y <= std::min(stats.height-1,by+r); y++ ) {
+                for( uint32_t x = bx > r ? bx-r : 0; x <= std::min(stats.width-1,bx+r); x++ ) {
+                    alg.blockHistogram(x,y,block.data);
+                    for( uint32_t i = 0; i < bins; i++ ) {
+                        histogram[i] += block[i];
+                        total += block[i];
+                    }
+                }
+            }
+            otsu.compute(histogram,total);
+            ASSERT_EQ(otsu.threshold,alg.thresholds.at(bx,by));
+
+            // every pixel inside the block uses this threshold
+            uint32_t x0 = bx*alg.blockWidth, y0 = by*alg.blockHeight;
+            uint32_t x1 = bx+1 == stats.width ? width : x0+alg.blockWidth;
+            uint32_t y1 = by+1 == stats.height ? height : y0+alg.blockHeight;
+            for( uint32_t y = y0; y < y1; y++ ) {
+                for( uint32_t x = x0; x < x1; x++ ) {
+                    ASSERT_EQ(input.at(x,y) <= otsu.threshold ? 1 : 0, found.at(x,y));
+                }
+            }
+        }
+    }
+}
+
+TEST(ThresholdBlockOtsu, brute_force) {
+    for( bool local : {false,true} ) {
+        for( bool otsu2 : {false,true} ) {
+            check_otsu_brute_force(local,otsu2,103,121,10);
+            check_otsu_brute_force(local,otsu2,60,20,10);
+            check_otsu_brute_force(local,otsu2,20,45,10);
+        }
+    }
+}
+
+TEST(ThresholdBlockOtsu, brute_force_bins) {
+    for( uint32_t bins : {16,32,64} ) {
+        for( bool local : {false,true} ) {
+            for( bool otsu2 : {false,true} ) {
+                check_otsu_brute_force(local,otsu2,103,121,10,bins);
+                check_otsu_brute_force(local,otsu2,20,45,10,bins);
+            }
+        }
+    }
+}
+
+/**
+ * Block histograms should be the same with 16-bit and 32-bit counts and have the pixel values in each bin
+ */
+TEST(ThresholdBlockOtsu, blockHistogram) {
+    std::mt19937 gen(0xBEEF);
+
+    // the second size has blocks which are too large for 16-bit counts
+    for( uint32_t size : {61,300} ) {
+        Gray<U8> input(size+7,size);
+        ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+        Gray<U8> output(input.width,input.height);
+
+        for( uint32_t bins : {16,64,256} ) {
+            uint32_t blockWidth = size == 61 ? 15 : size;
+            ThresholdBlockOtsu<U8> alg(false,ConfigLength::fixed(blockWidth),0.0,1.0,true,true,bins);
+            alg.process(input,output);
+            ASSERT_EQ(size == 61, alg.compactCounters);
+
+            GrowArray<uint32_t> found(bins), expected(bins);
+            for( uint32_t by = 0; by < alg.stats.height; by++ ) {
+                for( uint32_t bx = 0; bx < alg.stats.width; bx++ ) {
+                    uint32_t x0 = bx*alg.blockWidth, y0 = by*alg.blockHeight;
+                    uint32_t x1 = bx+1 == alg.stats.width ? input.width : x0+alg.blockWidth;
+                    uint32_t y1 = by+1 == alg.stats.height ? input.height : y0+alg.blockHeight;
+                    expected.fill(0);
+                    for( uint32_t y = y0; y < y1; y++ ) {
+                        for( uint32_t x = x0; x < x1; x++ ) {
+                            expected[input.at(x,y)*bins/256]++;
+                        }
+                    }
+                    alg.blockHistogram(bx,by,found.data);
+                    for( uint32_t i = 0; i < bins; i++ ) {
+                        ASSERT_EQ(expected[i],found[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(ThresholdBlockOtsu, histogramBins_invalid) {
+    for( uint32_t bins : {0,8,48,512} ) {
+        EXPECT_THROW(ThresholdBlockOtsu<U8>(false,ConfigLength::fixed(10),0.0,1.0,true,true,bins),
+                     std::invalid_argument);
+    }
+}
+
+TEST(ThresholdBlockOtsu, brute_force_concurrent) {
+    ThreadPool pool(3);
+    std::mt19937 gen(0xBEEF);
+    Gray<U8> input(150,173);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+
+    ThresholdBlockOtsu<U8> expected(false,ConfigLength::fixed(9),0.0,1.0,true,true);
+    ThresholdBlockOtsu<U8> found(false,ConfigLength::fixed(9),0.0,1.0,true,true);
+    found.concurrency = ConcurrencyContext(pool,1);
+    Gray<U8> outExpected(input.width,input.height), outFound(input.width,input.height);
+    expected.process(input,outExpected);
+    found.process(input,outFound);
+    check_equals(expected.thresholds,found.thresholds);
+    check_equals(outExpected,outFound);
 }
 
 template<class E>
@@ -186,4 +353,153 @@ TEST(ThresholdBlocMinMaxTest, standard_tests_U8) {
     standard_tests.toggle_down();
     standard_tests.widthLargerThanImage();
     standard_tests.subimage();
-}
\ No newline at end of file
+    standard_tests.concurrent();
+}
+
+/**
+ * The SIMD apply pass should produce the same output as the scalar code. Width is selected so that the blocks
+ * are not a multiple of the vector width
+ */
+template<class E>
+void check_apply_simd( InputToBinary<Gray<E>>& alg ) {
+    std::mt19937 gen(0xBEEF);
+    Gray<E> input(157,61);
+    ImageMiscOps::fill_uniform(input,(E)0,(E)255,gen);
+
+    Gray<U8> expected(input.width,input.height), found(input.width,input.height);
+    CpuFeatures::setSimdEnabled(false);
+    alg.process(input,expected);
+    CpuFeatures::setSimdEnabled(true);
+    alg.process(input,found);
+    check_equals(expected,found);
+}
+
+TEST(ThresholdBlockMean, apply_simd) {
+    for( bool local : {false,true} ) {
+        for( bool down : {false,true} ) {
+            ThresholdBlockMean<U8> algU8(ConfigLength::fixed(19),local,0.95,down);
+            check_apply_simd(algU8);
+            ThresholdBlockMean<F32> algF32(ConfigLength::fixed(19),local,0.95,down);
+            check_apply_simd(algF32);
+        }
+    }
+}
+
+TEST(ThresholdBlocMinMaxTest, apply_simd) {
+    for( bool local : {false,true} ) {
+        for( bool down : {false,true} ) {
+            // large scale so the average can go past the largest U8 value
+            for( float scale : {0.95f,2.5f} ) {
+                ThresholdBlockMinMax<U8> algU8(10,ConfigLength::fixed(19),local,scale,down);
+                check_apply_simd(algU8);
+                ThresholdBlockMinMax<F32> algF32(10,ConfigLength::fixed(19),local,scale,down);
+                check_apply_simd(algF32);
+            }
+        }
+    }
+}
+
+/**
+ * Center of a block along one axis. The last block includes the extra pixels at the border
+ */
+double block_center( uint32_t block , uint32_t blockLength , uint32_t blocks , uint32_t imageLength ) {
+    uint32_t upper = block+1 == blocks ? imageLength : (block+1)*blockLength;
+    return (block*blockLength + upper - 1)/2.0;
+}
+
+/**
+ * Finds the two blocks on either side of coordinate 'v' and the weight of the second one
+ */
+void block_weights( uint32_t v , uint32_t blockLength , uint32_t blocks , uint32_t imageLength ,
+                    uint32_t& blockA , uint32_t& blockB , double& weight ) {
+    blockA = blockB = 0;
+    weight = 0;
+    while( blockB < blocks && block_center(blockB,blockLength,blocks,imageLength) <= v )
+        blockB++;
+    if( blockB == 0 ) {
+        return;
+    } else if( blockB == blocks ) {
+        blockA = blockB = blocks-1;
+        return;
+    }
+    blockA = blockB-1;
+    double a = block_center(blockA,blockLength,blocks,imageLength);
+    double b = block_center(blockB,blockLength,blocks,imageLength);
+    weight = (v-a)/(b-a);
+}
+
+/**
+ * Compares the interpolated threshold against a brute force bilinear interpolation of each block's threshold
+ */
+template<class Alg>
+void check_interpolated( Alg& alg ) {
+    std::mt19937 gen(0xBEEF);
+    uint32_t width = 103, height = 121;
+    Gray<U8> input(width,height);
+    ImageMiscOps::fill_uniform(input,(U8)0,(U8)255,gen);
+    for( uint32_t y = 0; y < height; y++ ) {
+        for( uint32_t x = 0; x < width; x++ ) {
+            input.at(x,y) = (U8)((input.at(x,y) + 3*x + y)/3);
+        }
+    }
+
+    alg.setInterpolateThresholds(true);
+    Gray<U8> found(width,height);
+    alg.process(input,found);
+
+    const uint32_t W = alg.stats.width, H = alg.stats.height;
+    for( uint32_t y = 0; y < height; y++ ) {
+        uint32_t by0, by1; double wy;
+        block_weights(y,alg.blockHeight,H,height,by0,by1,wy);
+        for( uint32_t x = 0; x < width; x++ ) {
+            uint32_t bx0, bx1; double wx;
+            block_weights(x,alg.blockWidth,W,width,bx0,bx1,wx);
+
+            double top = (1-wx)*alg.blockThreshold(bx0,by0) + wx*alg.blockThreshold(bx1,by0);
+            double bottom = (1-wx)*alg.blockThreshold(bx0,by1) + wx*alg.blockThreshold(bx1,by1);
+            double threshold = (1-wy)*top + wy*bottom;
+
+            // the threshold is computed with floats and can't be compared when it's too close to the value
+            if( std::abs(input.at(x,y)-threshold) < 1e-3 )
+                continue;
+            ASSERT_EQ(alg.isDown() == (input.at(x,y) <= threshold) ? 1 : 0, found.at(x,y));
+        }
+    }
+
+    // processing rows of blocks concurrently should produce the same output
+    ThreadPool pool(3);
+    alg.concurrency = ConcurrencyContext(pool,1);
+    Gray<U8> concurrent(width,height);
+    alg.process(input,concurrent);
+    check_equals(found,concurrent);
+}
+
+TEST(ThresholdBlockMean, interpolated) {
+    for( bool local : {false,true} ) {
+        for( bool down : {false,true} ) {
+            ThresholdBlockMean<U8> alg(ConfigLength::fixed(10),local,0.95,down);
+            check_interpolated(alg);
+        }
+    }
+}
+
+TEST(ThresholdBlocMinMaxTest, interpolated) {
+    for( bool local : {false,true} ) {
+        for( bool down : {false,true} ) {
+            // the large spread makes some blocks textureless
+            for( float spread : {1.0f,40.0f} ) {
+                ThresholdBlockMinMax<U8> alg(spread,ConfigLength::fixed(10),local,0.95f,down);
+                check_interpolated(alg);
+            }
+        }
+    }
+}
+
+TEST(ThresholdBlockOtsu, interpolated) {
+    for( bool local : {false,true} ) {
+        for( bool down : {false,true} ) {
+            ThresholdBlockOtsu<U8> alg(false,ConfigLength::fixed(10),0.0,1.0,down,local);
+            check_interpolated(alg);
+        }
+    }
+}